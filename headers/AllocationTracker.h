@@ -0,0 +1,159 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_ALLOCATIONTRACKER_H
+#define SAFEANDMIRRORSPROBLEM_ALLOCATIONTRACKER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Accounting of the heap allocations of the program, by phase of the resolution of a case.
+ *
+ * The global operators new and delete are replaced (see AllocationOperators.cpp) to count the allocations and the bytes
+ * of every thread. The size of a block is the size given by the allocator, so a freed block is subtracted exactly.
+ * Without accounting (default), the operators only check a flag. The replacements are only linked in the program, not
+ * in the library used by the tools, and only where the allocator gives the size of a block.
+ *
+ * The current phase is shared by every thread: allocations are attributed to the phase of the case being solved, even
+ * when a worker helps the breaker, so cases must be solved one at a time while accounting.
+ */
+class AllocationTracker {
+
+public:
+
+    /**
+     * Phases of the resolution of a case
+     */
+    enum class ephase : uint8_t {
+        ePhaseParse = 0u,  ///< Reading of the case from the input
+        ePhaseSafe = 1u,  ///< Arrays of mirrors of the Safe
+        ePhaseIndex = 2u,  ///< Mirror index of the breaker
+        ePhaseSegments = 3u,  ///< Segments of the trajectories
+        ePhaseIntersection = 4u,  ///< Intersections between the trajectories
+        ePhaseOther = 5u  ///< Anything else: candidates, minimum number of mirrors, cache...
+    };
+
+    /// Number of phases
+    static constexpr std::size_t C_NB_PHASES = 6u;
+
+    /**
+     * Allocations of a phase
+     */
+    struct PhaseUsage {
+        uint64_t allocations = 0u;  ///< Number of allocations
+        uint64_t bytes = 0u;  ///< Bytes allocated, freed or not
+    };
+
+    /**
+     * Allocations since the start of a case
+     */
+    struct Usage {
+        std::array<PhaseUsage, C_NB_PHASES> phases{};  ///< Allocations of each phase
+        uint64_t startBytes = 0u;  ///< Live bytes at the start of the case
+        uint64_t peakBytes = 0u;  ///< Highest live bytes during the case
+
+        /**
+         * Retrieve the phase which allocated the most bytes
+         *
+         * @return phase, ePhaseOther if nothing was allocated
+         */
+        [[nodiscard]] ephase heaviestPhase() const;
+
+        /**
+         * Retrieve the growth of the live bytes during the case: the memory the case needed on top of the memory
+         * already held, buffers kept from a previous case included
+         *
+         * @return peak minus the live bytes at the start of the case
+         */
+        [[nodiscard]] uint64_t growthBytes() const {
+            return peakBytes > startBytes ? peakBytes - startBytes : 0u;
+        }
+    };
+
+    /**
+     * Phase set for the lifetime of the scope, the previous phase is restored at its end
+     */
+    class Scope {
+
+    public:
+
+        explicit Scope(ephase phase);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+
+        /// Phase before the scope
+        ephase mPrevious;
+    };
+
+    /**
+     * Check if the global operators new and delete are replaced, ie if the allocations can be counted
+     *
+     * @return true if AllocationOperators.cpp is linked in the program
+     */
+    [[nodiscard]] static bool installed();
+
+    /**
+     * Start or stop the accounting. Bytes allocated before the accounting started are not counted when freed.
+     *
+     * @param enabled: true to count the allocations
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Check if the allocations are counted
+     *
+     * @return true if the accounting is enabled
+     */
+    [[nodiscard]] static bool enabled();
+
+    /**
+     * Start a new case: the counters of the phases are cleared, and the peak is the current live bytes.
+     */
+    static void startCase();
+
+    /**
+     * Retrieve the allocations since the start of the case
+     *
+     * @return allocations of each phase and peak of live bytes
+     */
+    [[nodiscard]] static Usage usage();
+
+    /**
+     * Retrieve the name of a phase, as written in the output file
+     *
+     * @param phase: phase
+     * @return name of the phase
+     */
+    [[nodiscard]] static const char *phaseName(ephase phase);
+
+    /**
+     * Record that the global operators are replaced. Called once by AllocationOperators.cpp.
+     */
+    static void setInstalled();
+
+    /**
+     * Count an allocation. Called by the operators new.
+     *
+     * @param bytes: size of the allocated block
+     */
+    static void allocated(std::size_t bytes);
+
+    /**
+     * Count a deallocation. Called by the operators delete.
+     *
+     * @param bytes: size of the freed block
+     */
+    static void freed(std::size_t bytes);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_ALLOCATIONTRACKER_H
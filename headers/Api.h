@@ -6,13 +6,26 @@
 #define SAFEANDMIRRORSPROBLEM_API_H
 
 #include <string>
-#include <list>
+#include <array>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 #include <utility>
+#include "AllocationTracker.h"
 #include "Safe.h"
 #include "Mirror.h"
 #include "SafeBreaker.h"
+#include "CaseReader.h"
+#include "ThreadPool.h"
+#include "ResultWriter.h"
+#include "StatsWriter.h"
+#include "ResultCache.h"
 
 /**
  * API to solve several safe opening problems from an input file.
@@ -22,6 +35,10 @@ class Api {
 
 public:
 
+    /// Default number of cases read but not written yet, per worker, and default ceiling of the bytes of their Safes
+    static constexpr std::size_t C_QUEUE_CASES_PER_WORKER = 4u;
+    static constexpr std::size_t C_QUEUE_BYTES = std::size_t{1} << 28u;
+
     /**
      * Constructor defining the inputs/outputs files.
      *
@@ -36,46 +53,259 @@ public:
      */
     void launch();
 
+    /**
+     * Set the number of threads solving the cases concurrently. Results are still output in case order.
+     *
+     * @param nbThreads: number of threads, 0 to use one thread per core (default)
+     */
+    void setThreads(uint32_t nbThreads);
+
+    /**
+     * Set the format of the output file. Results are always displayed as text.
+     *
+     * @param format: format of the output file, text by default
+     */
+    void setOutputFormat(ResultWriter::eformat format);
+
+    /**
+     * Set when the buffered results are written in the output file.
+     *
+     * @param flushBytes: size of the buffer triggering a write
+     * @param flushInterval: time since the last write triggering a write
+     */
+    void setFlushPolicy(std::size_t flushBytes, std::chrono::milliseconds flushInterval);
+
+    /**
+     * Save the times and counters of each phase of each case, and their aggregate, in a JSON Lines file.
+     * Without statistics file (default), no statistic is gathered.
+     *
+     * @param statsFileName: name of the statistics file, empty for no statistics
+     */
+    void setStatsFile(std::string statsFileName);
+
+    /**
+     * Check candidate placements of a mirror for some cases, and save which ones open their Safe.
+     *
+     * The candidates file has one candidate per line: 'case row column kind', with the number of the case (starting
+     * from 0) and the kind of the mirror, / or \ . Each candidate is saved in the answers file with its answer:
+     * 'case row column kind answer', where answer is opens, closes, occupied or outside.
+     *
+     * @param candidatesFileName: name of the candidates file, empty for no candidates (default)
+     * @param answersFileName: name of the answers file
+     */
+    void setCandidatesFiles(std::string candidatesFileName, std::string answersFileName);
+
+    /**
+     * Save every solution of each case in the output file, after the result of the case, in lexicographic order and
+     * with the kind of mirror to place. Solutions are streamed to the output file as they are found: they are never
+     * stored in memory. The cases are then solved one by one.
+     *
+     * @param enumerate: true to save every solution, false to save only the closest one (default)
+     */
+    void setEnumerate(bool enumerate);
+
+    /**
+     * For each case which can not be opened by adding a single mirror, save in the output file the minimum number of
+     * mirrors to add and one placement of these mirrors, after the result of the case. Such cases are always solved,
+     * even if their result is in the cache.
+     *
+     * @param minimum: true to search the minimum number of mirrors, false to only solve the cases (default)
+     */
+    void setMinimum(bool minimum);
+
+    /**
+     * Count the heap allocations of each phase of each case, and save their peak of live bytes in the output file after
+     * the result of the case. The cases which raised the live bytes the most are displayed at the end. The cases are
+     * then solved one by one, so that every allocation is attributed to the case being solved.
+     *
+     * @param accounting: true to count the allocations, false to leave them alone (default)
+     */
+    void setMemoryAccounting(bool accounting);
+
+    /**
+     * Bound the cases read but not written yet when the cases are solved concurrently. The input is read by the calling
+     * thread, the cases are solved by the workers and the results are written in case order by a writer thread: the
+     * reading waits for the writer when a bound is reached, so a huge input is solved at constant memory. A case bigger
+     * than the ceiling is solved alone.
+     *
+     * @param maxCases: maximum number of cases, 0 for C_QUEUE_CASES_PER_WORKER per worker (default)
+     * @param maxBytes: maximum bytes of the Safes of these cases, 0 for no ceiling (C_QUEUE_BYTES by default)
+     */
+    void setQueueLimits(std::size_t maxCases, std::size_t maxBytes);
+
+    /**
+     * Keep the results of the solved Safes: a Safe already solved, with the same size and mirrors, is not solved again.
+     * The cache can be loaded from a file before the first case and saved in it after the last case, to be shared
+     * between runs. Cases with candidates or whose solutions are enumerated are always solved.
+     *
+     * @param capacity: maximum number of Safes kept, 0 to disable the cache (default)
+     * @param cacheFileName: name of the cache file, empty to keep the cache in memory only
+     */
+    void setCache(std::size_t capacity, std::string cacheFileName);
+
+    /**
+     * Accept Safes up to 2^31 rows and columns and a billion mirrors, instead of the limits of the problem. The numbers
+     * of solution are counted on 64 bits in every mode.
+     *
+     * @param largeGrid: true to accept large grids, false for the limits of the problem (default)
+     */
+    void setLargeGrid(bool largeGrid);
+
 private:
 
+    /**
+     * Result of a case solved by a worker
+     */
+    struct CaseResult {
+        int64_t nbSolution = 0;  ///< Number of solution
+        uint32_t row = 0u, column = 0u;  ///< Position of the closest solution
+        bool solved = false;  ///< The case has been solved
+        CaseStats stats;  ///< Statistics of the case, if gathered
+        std::vector<SafeBreaker::ecandidate> answers;  ///< Answer for each candidate of the case, if any
+        int64_t minimum = 0;  ///< Minimum number of mirrors to add if searched, -1 if the Safe can not be opened
+        std::vector<MirrorRouter::Placement> placements;  ///< Placement of these mirrors
+        AllocationTracker::Usage memory;  ///< Heap allocations of the case, if counted
+    };
+
+    /// Bytes taken by a mirror in a Safe
+    static constexpr std::size_t C_MIRROR_BYTES = 2u * sizeof(uint32_t) + sizeof(Mirror::emirrorKind);
+
+    /// Number of cases with the highest peak of live bytes displayed at the end
+    static constexpr std::size_t C_NB_WORST_CASES = 10u;
+
     /// Define input and output file names
     const std::string mInputFileName, mOutputFileName;
 
-    /// List of lines of the input file
-    std::list<std::string> mInputLines;
+    /// Reader of the cases of the input file
+    CaseReader mCaseReader;
 
     /// Number of solved case. Start from 0.
     uint32_t mNbCases;
 
-    /// Safe to open, is configured during the launch sequence
-    Safe mSafe;
+    /// Safe to open, is configured during the launch sequence. Shared with the worker solving it, which gives it back
+    /// to the CaseReader once solved.
+    std::shared_ptr<Safe> mSafe;
+
+    /// The Safe has been handed to a worker: the next case is configured in another Safe
+    bool mSafeShared = false;
+
+    /// Breaker reused from case to case when the cases are solved one by one
+    SafeBreaker mBreaker;
+
+    /// Number of threads solving the cases, 0 for one per core
+    uint32_t mNbThreads = 0u;
+
+    /// Bounds of the cases read but not written yet, see setQueueLimits
+    std::size_t mQueueCases = 0u, mQueueBytes = C_QUEUE_BYTES;
+
+    /// Output file, opened once, and its format
+    ResultWriter mWriter;
+    ResultWriter::eformat mOutputFormat = ResultWriter::eformat::eFormatText;
+
+    /// Displayed result, reused for every case
+    std::string mDisplay;
+
+    /// Statistics file, and its name (empty for no statistics)
+    StatsWriter mStatsWriter;
+    std::string mStatsFileName;
+
+    /// Candidate placements of each case having candidates, their file and the file of their answers
+    std::unordered_map<uint32_t, std::vector<SafeBreaker::Candidate>> mCandidates;
+    std::string mCandidatesFileName, mAnswersFileName;
+    std::ofstream mAnswersFile;
+
+    /// Every solution of each case is saved in the output file
+    bool mEnumerate = false;
+
+    /// The minimum number of mirrors is searched for the cases which can not be opened by a single mirror
+    bool mMinimum = false;
+
+    /// The heap allocations of each case are counted, and the cases with the highest growth of live bytes, highest
+    /// first
+    bool mMemory = false;
+    std::vector<std::pair<uint32_t, AllocationTracker::Usage>> mWorstCases;
+
+    /// Results of the Safes already solved, the file they are saved in (empty if none) and the hash of the last case read
+    ResultCache mCache;
+    std::string mCacheFileName;
+    ResultCache::Key mCaseKey;
 
     /**
-     * Read the input file and store each line in the mInputLines list
+     * Open the input file in the case reader. The file is mapped in memory and not copied.
      */
     void readFile();
 
+    /**
+     * Read the candidates file, if any, and open the answers file.
+     */
+    void readCandidates();
+
     /**
      * Retrieve the next case, ie the safe configuration, from the inputs lines.
      *
+     * @param[out] stats: statistics receiving the parse time, nullptr if not gathered
      * @returns true if a case has been retrieved (correctly or not), false otherwise
      */
-    bool getNextCase();
+    bool getNextCase(CaseStats *stats);
+
+    /**
+     * Solve a case with a breaker.
+     *
+     * @param breaker: breaker solving the case, reset with the Safe
+     * @param safe: Safe of the case
+     * @param[out] result: solution of the case, and the statistics of its resolution if gathered
+     * @param withStats: gather the statistics of the case
+     * @param candidates: candidate placements to check, nullptr if none
+     * @param minimum: search the minimum number of mirrors if a single mirror can not open the Safe
+     */
+    static void solveCase(SafeBreaker &breaker, const Safe &safe, CaseResult &result, bool withStats,
+                          const std::vector<SafeBreaker::Candidate> *candidates, bool minimum);
 
     /**
-     * Configure the safe mirrors from the new case
+     * Retrieve the candidates of a case
      *
-     * @param nbMirrorRightLeft: number of mirrors of type /
-     * @param nbMirrorLeftRight: number of mirrors of type \
+     * @param caseId: number of the case
+     * @return candidates of the case, nullptr if none
      */
-    void configureSafe(uint32_t nbMirrorRightLeft, uint32_t nbMirrorLeftRight);
+    [[nodiscard]] const std::vector<SafeBreaker::Candidate> *candidatesOf(uint32_t caseId) const;
+
+    /**
+     * Retrieve the result of the last case read from the cache.
+     *
+     * @param[in] caseId: number of the case
+     * @param[in out] result: result of the case, if found, its parse time is kept
+     * @return true if the result has been found, false if the case must be solved
+     */
+    bool findCached(uint32_t caseId, CaseResult &result);
+
+    /**
+     * Solve the cases concurrently on a work-stealing pool while reading them, and output the results in case order
+     * from a writer thread. The reading waits for the writer when the bounds of setQueueLimits are reached.
+     *
+     * @param nbThreads: number of workers of the pool
+     * @param withStats: gather the statistics of each case
+     */
+    void launchConcurrent(uint32_t nbThreads, bool withStats);
 
     /**
      * Display and save in the output file the number of solution and the lexicographically closest solution.
-     * @param nbSolution: number of solution.
-     * @param row, column: position of the closest solution
+     * Statistics of the case are saved if asked.
+     * @param result: solution of the case
+     */
+    void outputSolution(const CaseResult &result);
+
+    /**
+     * Keep a case among the cases with the highest growth of live bytes
+     *
+     * @param caseId: number of the case
+     * @param usage: heap allocations of the case
+     */
+    void rankMemory(uint32_t caseId, const AllocationTracker::Usage &usage);
+
+    /**
+     * Display the cases with the highest growth of live bytes, and the phase which allocated the most in each of them.
      */
-    void outputSolution(int nbSolution, uint32_t row, uint32_t column);
+    void displayWorstCases() const;
 
 };
 
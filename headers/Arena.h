@@ -0,0 +1,85 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_ARENA_H
+#define SAFEANDMIRRORSPROBLEM_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Monotonic memory arena kept between cases.
+ *
+ * Buffers are taken one after the other from a block of memory and are all released at once by reset. When a case
+ * needs more than the current block, new blocks are added; they are merged in a single block at the next reset, so
+ * the arena stops allocating once it has reached the size needed by the biggest case.
+ */
+class Arena {
+
+public:
+
+    /**
+     * Take a buffer of trivially copyable objects from the arena. The objects are not initialized.
+     *
+     * @param count: number of objects
+     * @return buffer, valid until the next reset
+     */
+    template<typename T>
+    std::span<T> allocate(std::size_t count) {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                      "Arena buffers are released without calling destructors");
+        return {static_cast<T *>(allocateBytes(count * sizeof(T), alignof(T))), count};
+    }
+
+    /**
+     * Release every buffer taken from the arena. The memory is kept for the next buffers.
+     */
+    void reset();
+
+    /**
+     * Retrieve the number of bytes reserved by the arena
+     *
+     * @return number of bytes reserved
+     */
+    [[nodiscard]] std::size_t capacity() const;
+
+    /**
+     * Retrieve the number of bytes taken from the arena since the last reset
+     *
+     * @return number of bytes taken
+     */
+    [[nodiscard]] std::size_t used() const;
+
+private:
+
+    /**
+     * Block of memory
+     */
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;  ///< Memory of the block
+        std::size_t size;  ///< Size of the block in bytes
+    };
+
+    /// Blocks of memory, buffers are taken from the last one
+    std::vector<Block> mBlocks;
+
+    /// Bytes taken from the last block, and from the previous blocks
+    std::size_t mOffset = 0u, mPreviousBlocksUsed = 0u;
+
+    /**
+     * Take an aligned buffer from the last block, adding a new block if needed.
+     *
+     * @param size: size of the buffer in bytes
+     * @param alignment: alignment of the buffer
+     * @return buffer
+     */
+    void *allocateBytes(std::size_t size, std::size_t alignment);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_ARENA_H
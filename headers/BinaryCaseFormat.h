@@ -0,0 +1,129 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_BINARYCASEFORMAT_H
+#define SAFEANDMIRRORSPROBLEM_BINARYCASEFORMAT_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Safe.h"
+
+/**
+ * Versioned binary format of the cases, loaded without any parsing.
+ *
+ * A file starts with a FileHeader (magic "SAMB" and version), followed by the cases until the end of the file. Each case
+ * is a CaseHeader followed by its payload, padded to 4 bytes: the rows of the mirrors then their columns, mirrors of
+ * kind / first then mirrors of kind \ . The payload is either raw (native unsigned 32 bits integers, handed to the Safe
+ * straight from the mapped file) or delta-encoded (each position as the zigzag varint of its difference with the
+ * previous one, mirrors of each kind sorted by row then column). Integers are in the native byte order (little-endian
+ * on x86).
+ */
+class BinaryCaseFormat {
+
+public:
+
+    /// Magic bytes at the beginning of a binary file
+    static constexpr std::array<char, 4> C_MAGIC = {'S', 'A', 'M', 'B'};
+
+    /// Version of the format written by this program
+    static constexpr uint32_t C_VERSION = 1u;
+
+    /**
+     * Definition of all possible encodings of the payload of a case.
+     */
+    enum class eencoding : uint32_t {
+        eEncodingRaw = 0u,  ///< Arrays of rows and columns, 4 bytes per position
+        eEncodingDelta = 1u  ///< Zigzag varints of the differences between consecutive positions
+    };
+
+    /**
+     * Header of a binary file
+     */
+    struct FileHeader {
+        std::array<char, 4> magic;  ///< Always C_MAGIC
+        uint32_t version;  ///< Version of the format
+    };
+    static_assert(sizeof(FileHeader) == 8u, "File header must be 8 bytes wide");
+
+    /**
+     * Header of a case, followed by its payload
+     */
+    struct CaseHeader {
+        uint32_t rows, columns;  ///< Size of the Safe
+        uint32_t nbRightLeft, nbLeftRight;  ///< Number of mirrors of each kind
+        eencoding encoding;  ///< Encoding of the payload
+        uint32_t payloadSize;  ///< Size of the payload in bytes, padding included
+    };
+    static_assert(sizeof(CaseHeader) == 24u, "Case header must be 24 bytes wide");
+
+    /**
+     * Check if a content starts with the magic bytes of the binary format.
+     *
+     * @param content: beginning of a file
+     * @return true if the content is in binary format
+     */
+    [[nodiscard]] static bool isBinary(std::string_view content);
+
+    /**
+     * Append the header of a binary file.
+     *
+     * @param output: content of the binary file
+     */
+    static void writeFileHeader(std::string &output);
+
+    /**
+     * Append a case, with the mirrors of a Safe.
+     *
+     * @param output: content of the binary file
+     * @param safe: Safe of the case
+     * @param encoding: encoding of the payload
+     */
+    static void writeCase(std::string &output, const Safe &safe, eencoding encoding);
+
+    /**
+     * Reader of the cases of a binary content, reusing its buffers from case to case.
+     */
+    class Reader {
+
+    public:
+
+        /**
+         * Read the file header at the beginning of a content.
+         *
+         * @param content: whole content, starting with the file header
+         * @return size of the file header, 0 if the header is invalid (error displayed)
+         */
+        static std::size_t readFileHeader(std::string_view content);
+
+        /**
+         * Compute the size of the next case of a content, to know how much content is needed before reading it.
+         *
+         * @param content: content left, starting with a case header, complete or not
+         * @return size of the case, header and payload, or size of a case header if the header is incomplete
+         */
+        [[nodiscard]] static std::size_t caseSize(std::string_view content);
+
+        /**
+         * Configure a Safe with the next case of a content. Raw mirrors are copied from the content at once.
+         *
+         * @param content: content left, starting with a case header
+         * @param safe: Safe to configure
+         * @return size of the case read, 0 if the case is truncated or invalid (error displayed)
+         */
+        std::size_t readCase(std::string_view content, Safe &safe);
+
+    private:
+
+        /// Decoded rows and columns of a delta-encoded case
+        std::vector<uint32_t> mRows, mColumns;
+
+    };
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_BINARYCASEFORMAT_H
@@ -0,0 +1,85 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_CANDIDATEINDEX_H
+#define SAFEANDMIRRORSPROBLEM_CANDIDATEINDEX_H
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Mirror.h"
+#include "Segment.h"
+
+/**
+ * Index of the cells passed by a trajectory, giving for any cell the first passage of the beam on it.
+ *
+ * A beam never passes twice on a cell along the same axis (it would have to come back on its own path), so the
+ * movements of a trajectory along a given row, or a given column, never overlap: the movement containing a cell is found
+ * by a binary search in the movements sorted by row (or column) then by outer point.
+ */
+class CandidateIndex {
+
+public:
+
+    /// Step used when the beam does not pass on a cell
+    static constexpr uint32_t C_NOT_VISITED = UINT32_MAX;
+
+    /**
+     * Passage of the beam on a cell
+     */
+    struct Visit {
+        uint32_t step = C_NOT_VISITED;  ///< Rank of the movement in the trajectory, C_NOT_VISITED if never passed
+        Mirror::edirection direction = Mirror::edirection::eDirRight;  ///< Direction of the beam on the cell
+    };
+
+    /**
+     * Build the index from the movements of a trajectory starting along a row. A trajectory alternates the movements
+     * along the rows and along the columns, as each mirror turns the beam by 90 degrees: the order of the movements and
+     * their directions are deduced from the starting position.
+     *
+     * @param horizontal: movements along the rows, in the order of the trajectory
+     * @param verticalReversed: movements along the columns, in the reverse order of the trajectory (as stored at the end
+     * of a trajectory buffer)
+     * @param start: starting position of the trajectory
+     */
+    void build(std::span<const Segment> horizontal, std::span<const Segment> verticalReversed,
+               std::array<uint32_t, 2> start);
+
+    /**
+     * Retrieve the first passage of the beam strictly inside a movement on a cell, ie the beam crosses the cell.
+     *
+     * @param row, column: position of the cell
+     * @return first passage, with a step C_NOT_VISITED if the beam does not cross the cell
+     */
+    [[nodiscard]] Visit firstVisit(uint32_t row, uint32_t column) const;
+
+private:
+
+    /**
+     * Movement of the trajectory with its rank and direction
+     */
+    struct Entry {
+        Segment segment;  ///< Row or column of the movement and its outer points
+        uint32_t step;  ///< Rank of the movement in the trajectory
+        Mirror::edirection direction;  ///< Direction of the movement
+    };
+
+    /// Movements along the rows and along the columns, sorted by row (column) then by smallest outer point
+    std::vector<Entry> mRows, mColumns;
+
+    /**
+     * Find the movement crossing a position along a line
+     *
+     * @param entries: sorted movements along the same axis
+     * @param line: row or column of the position
+     * @param position: position along the line
+     * @return passage on the position
+     */
+    static Visit crossing(const std::vector<Entry> &entries, uint32_t line, uint32_t position);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_CANDIDATEINDEX_H
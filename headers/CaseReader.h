@@ -0,0 +1,128 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_CASEREADER_H
+#define SAFEANDMIRRORSPROBLEM_CASEREADER_H
+
+#include <array>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Safe.h"
+#include "InputReader.h"
+#include "BinaryCaseFormat.h"
+
+/**
+ * Reader of the cases of an input file, each case configuring a Safe.
+ *
+ * A case is a line of type 'nb_rows nb_columns nb_mirror_/ nb_mirror_\' followed by one line per mirror (row then
+ * column), first the mirrors of kind / then the mirrors of kind \. Errors in the input are displayed and the reading
+ * goes on. Cases can also be streamed from a descriptor: a case is read as soon as its lines are received.
+ *
+ * A file starting with the magic bytes of the BinaryCaseFormat is read as binary cases instead: the mirrors are taken
+ * from the mapped file without any parsing. A truncated or invalid binary case ends the reading.
+ */
+class CaseReader {
+
+public:
+
+    /**
+     * Open an input file and place the reader on its first case.
+     *
+     * @param fileName: name of the input file
+     * @return true if the file has been opened, false otherwise
+     */
+    bool open(const std::string &fileName);
+
+    /**
+     * Stream the cases of a descriptor (pipe, socket), in text or binary format, and place the reader on its first
+     * case. The descriptor is not closed by the reader.
+     *
+     * @param descriptor: descriptor to read, until its end
+     */
+    void open(int descriptor);
+
+    /**
+     * Accept the grids bigger than the limits of the problem, see Safe::setLargeGrid.
+     *
+     * @param largeGrid: true to accept large grids
+     */
+    void setLargeGrid(bool largeGrid);
+
+    /**
+     * Check if the next case can be started without waiting for the streamed descriptor.
+     *
+     * @return true if the beginning of the next case (its whole content in binary format) has been received, or if
+     * every case has been read
+     */
+    [[nodiscard]] bool hasCase() const;
+
+    /**
+     * Retrieve the next case, ie the safe configuration, from the inputs lines.
+     *
+     * A line which does not describe a case is skipped and the Safe is left unchanged, copied to a recycled or new
+     * Safe if it has been handed to another thread. Otherwise, the Safe is configured in place, or replaced by a
+     * recycled or new Safe if it has been handed to another thread. The input of the previous cases may be given back
+     * to the system.
+     *
+     * @param[in out] safe: Safe to configure
+     * @param shared: true if the Safe has been handed to another thread, which may still read it
+     * @returns true if a case has been retrieved (correctly or not), false otherwise
+     */
+    bool nextCase(std::shared_ptr<Safe> &safe, bool shared = false);
+
+    /**
+     * Give back a Safe handed to another thread, once this thread does not read it anymore, so that a next case is
+     * configured in it instead of allocating a new Safe. Can be called from any thread, once per Safe handed out: a
+     * Safe already given back is refused.
+     *
+     * @param safe: Safe not read anymore
+     */
+    void recycle(std::shared_ptr<Safe> safe);
+
+private:
+
+    /// Reader of the lines of the input file
+    InputReader mReader;
+
+    /// The input file is in binary format
+    bool mBinary = false;
+
+    /// The Safes of the cases accept large grids
+    bool mLargeGrid = false;
+
+    /// Reader of the binary cases, used only for a binary input file
+    BinaryCaseFormat::Reader mBinaryReader;
+
+    /// Safes given back by the other threads. The mutex orders their last reads before the next case is configured.
+    std::vector<std::shared_ptr<Safe>> mFreeSafes;
+    std::mutex mFreeSafesMutex;
+
+    /**
+     * Detect the format of the input from its first bytes, and read the file header of a binary input.
+     */
+    void detectFormat();
+
+    /**
+     * Replace a Safe handed to another thread by a recycled Safe, or by a new one if none has been given back.
+     *
+     * @param[in out] safe: Safe of the previous case
+     */
+    void replaceShared(std::shared_ptr<Safe> &safe);
+
+    /**
+     * Configure the safe mirrors from the new case
+     *
+     * @param safe: Safe to configure
+     * @param nbMirrorRightLeft: number of mirrors of type /
+     * @param nbMirrorLeftRight: number of mirrors of type \
+     */
+    void configureSafe(Safe &safe, uint32_t nbMirrorRightLeft, uint32_t nbMirrorLeftRight);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_CASEREADER_H
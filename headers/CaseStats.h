@@ -0,0 +1,40 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_CASESTATS_H
+#define SAFEANDMIRRORSPROBLEM_CASESTATS_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * Time spent in each phase of the resolution of a case, and counters of the work done.
+ *
+ * Statistics are only gathered when asked: the resolution without statistics does not read any clock.
+ */
+struct CaseStats {
+    uint64_t parseNs = 0u;  ///< Reading of the case from the input
+    uint64_t buildNs = 0u;  ///< Build of the mirror index
+    uint64_t forwardNs = 0u;  ///< Trajectory of the laser beam
+    uint64_t backwardNs = 0u;  ///< Trajectory from the detector
+    uint64_t intersectNs = 0u;  ///< Intersections between the trajectories
+    uint64_t mirrorsVisited = 0u;  ///< Mirrors reached by both trajectories
+    uint64_t segments = 0u;  ///< Segments of both trajectories
+    uint64_t columnsProbed = 0u;  ///< Range queries on the columns of the vertical segments, one per horizontal segment
+    uint64_t intersections = 0u;  ///< Intersections found, ie solutions
+
+    /**
+     * Elapsed time since a time point
+     *
+     * @param start: time point
+     * @return elapsed time in nanoseconds
+     */
+    static uint64_t elapsedNs(const std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+    }
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_CASESTATS_H
@@ -0,0 +1,122 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_COLUMNTREE_H
+#define SAFEANDMIRRORSPROBLEM_COLUMNTREE_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Segment.h"
+
+/**
+ * Fenwick tree counting the active vertical movements in each column, used by the sweep-line engines.
+ *
+ * The columns are compressed: the tree only has one entry per distinct column of the vertical movements, so its size
+ * only depends on the number of movements. Rebuilding the tree for the next case reuses its arrays of columns and
+ * counts.
+ */
+class ColumnTree {
+
+public:
+
+    /**
+     * Compress the columns of vertical movements and clear the tree: no movement is active.
+     *
+     * @param vertical: movements along the columns
+     */
+    void build(std::span<const Segment> vertical);
+
+    /**
+     * Retrieve the compressed column of the first column not smaller than a column
+     *
+     * @param column: column to look for
+     * @return compressed column, the number of columns if every column is smaller
+     */
+    [[nodiscard]] uint32_t lowerBound(uint32_t column) const {
+        return static_cast<uint32_t>(std::lower_bound(mColumns.begin(), mColumns.end(), column) - mColumns.begin());
+    }
+
+    /**
+     * Retrieve the compressed column of the first column bigger than a column
+     *
+     * @param column: column to look for
+     * @return compressed column, the number of columns if no column is bigger
+     */
+    [[nodiscard]] uint32_t upperBound(uint32_t column) const {
+        return static_cast<uint32_t>(std::upper_bound(mColumns.begin(), mColumns.end(), column) - mColumns.begin());
+    }
+
+    /**
+     * Retrieve the number of compressed columns
+     *
+     * @return number of distinct columns
+     */
+    [[nodiscard]] std::size_t size() const { return mColumns.size(); }
+
+    /**
+     * Retrieve the column of a compressed column
+     *
+     * @param index: compressed column
+     * @return column
+     */
+    [[nodiscard]] uint32_t column(uint32_t index) const { return mColumns[index]; }
+
+    /**
+     * Add a value to a compressed column.
+     *
+     * @param index: compressed column, starting from 0
+     * @param value: value to add
+     */
+    void add(uint32_t index, const int value) {
+        /// Fenwick tree is indexed from 1
+        for (++index; index < mTree.size(); index += index & (~index + 1u))
+            mTree[index] += value;
+    }
+
+    /**
+     * Retrieve the number of active vertical movements in the compressed columns [0, end).
+     *
+     * @param end: first compressed column excluded from the sum
+     * @return number of active vertical movements
+     */
+    [[nodiscard]] int prefix(uint32_t end) const {
+        int sum = 0;
+        for (; end > 0u; end -= end & (~end + 1u))
+            sum += mTree[end];
+        return sum;
+    }
+
+    /**
+     * Find the compressed column holding the k-th active vertical movement.
+     *
+     * @param k: rank of the wanted vertical movement, starting from 1
+     * @return compressed column of the movement
+     */
+    [[nodiscard]] uint32_t find(int k) const {
+        /// Descend the tree from the highest power of two, keeping the position whose prefix is still smaller than k
+        uint32_t position = 0u;
+        for (uint32_t step = std::bit_floor(static_cast<uint32_t>(mTree.size() - 1u)); step > 0u; step >>= 1u) {
+            if (position + step < mTree.size() && mTree[position + step] < k) {
+                position += step;
+                k -= mTree[position];
+            }
+        }
+        return position;  ///< Position is the last index with a prefix smaller than k, ie the wanted index in base 0
+    }
+
+private:
+
+    /// Sorted and unique columns of the vertical movements, used to compress the columns
+    std::vector<uint32_t> mColumns;
+
+    /// Fenwick tree counting the active vertical movements in each compressed column
+    std::vector<int> mTree;
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_COLUMNTREE_H
@@ -0,0 +1,68 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_CROSSINGKERNEL_H
+#define SAFEANDMIRRORSPROBLEM_CROSSINGKERNEL_H
+
+#include <cstdint>
+
+/**
+ * Vectorized test of a row against packed vertical movements: a movement (lo, hi) is crossed by the row if
+ * lo < row < hi.
+ *
+ * The movements are tested 16 at a time with AVX2, 4 at a time with SSE2, or one by one. The instruction set is chosen
+ * once at runtime, from the processor executing the program: the program does not need to be compiled for AVX2.
+ */
+class CrossingKernel {
+
+public:
+
+    /**
+     * Definition of all possible instruction sets of the kernel.
+     */
+    enum class einstructionSet {
+        eInstructionSetScalar,  ///< One movement at a time, on any processor
+        eInstructionSetSse2,  ///< 4 movements at a time, on any x86-64 processor
+        eInstructionSetAvx2  ///< 16 movements at a time (two vectors of 8)
+    };
+
+    /**
+     * Crossings of a row with packed movements
+     */
+    struct Result {
+        uint32_t count;  ///< Number of movements crossed by the row
+        uint32_t first;  ///< Index of the first movement crossed, the number of movements if none
+    };
+
+    /**
+     * Test a row against packed movements, with the best instruction set of the processor.
+     *
+     * @param row: row to test
+     * @param lo, hi: outer points of each movement, same size
+     * @param size: number of movements
+     * @return number of crossed movements and index of the first one
+     */
+    static Result cross(uint32_t row, const uint32_t *lo, const uint32_t *hi, uint32_t size);
+
+    /**
+     * Test a row against packed movements with a given instruction set, supported by the processor.
+     *
+     * @param instructionSet: instruction set to use
+     * @param row, lo, hi, size: as cross
+     * @return as cross
+     */
+    static Result cross(einstructionSet instructionSet, uint32_t row, const uint32_t *lo, const uint32_t *hi,
+                        uint32_t size);
+
+    /**
+     * Retrieve the best instruction set supported by the processor, used by cross.
+     *
+     * @return instruction set of the kernel
+     */
+    [[nodiscard]] static einstructionSet instructionSet();
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_CROSSINGKERNEL_H
@@ -0,0 +1,180 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_INPUTREADER_H
+#define SAFEANDMIRRORSPROBLEM_INPUTREADER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Line by line reader of integers from an input file, without any copy of the lines.
+ *
+ * The file is mapped in memory when possible (streamed by chunks otherwise) and integers are scanned directly from the
+ * mapped memory. The pages already read can be given back to the system, so a huge file is read at constant memory.
+ * Empty lines are ignored. Integers of a line are read as a stream would read them: the reading of a line stops at the
+ * first data which is not an unsigned integer.
+ *
+ * The reader can also stream a descriptor (pipe, socket): the content is read by chunks in a buffer, only when the
+ * current line is not complete. A line is never waited for before it is needed, so a case can be answered before the
+ * next one is sent.
+ */
+class InputReader {
+
+public:
+
+    /**
+     * Construct a reader without any input: the reader is at the end.
+     */
+    InputReader() = default;
+
+    /**
+     * Unmap the input file if needed.
+     */
+    ~InputReader();
+
+    /// The mapping is owned by the reader: no copy
+    InputReader(const InputReader &) = delete;
+    InputReader &operator=(const InputReader &) = delete;
+
+    /**
+     * Open an input file and place the reader on its first non empty line. Any previously opened file is closed.
+     *
+     * @param fileName: name of the input file
+     * @return true if the file has been opened, false otherwise
+     */
+    bool open(const std::string &fileName);
+
+    /**
+     * Stream a descriptor. Any previously opened file is closed. Nothing is read before a line or some characters are
+     * needed, and the descriptor is not closed by the reader.
+     *
+     * @param descriptor: descriptor to read, until its end
+     */
+    void open(int descriptor);
+
+    /**
+     * Check if every line has been read. When streaming, waits for the current line.
+     *
+     * @return true if there is no more line to read
+     */
+    [[nodiscard]] bool atEnd();
+
+    /**
+     * Check if the current line can be read without waiting for the descriptor.
+     *
+     * @return true if the current line is complete in the buffer, or if everything has been read
+     */
+    [[nodiscard]] bool hasLine() const;
+
+    /**
+     * Wait until some characters can be read without waiting for the descriptor, or the end is reached.
+     *
+     * @param size: number of characters needed
+     * @return true if the characters are available
+     */
+    bool request(std::size_t size);
+
+    /**
+     * Retrieve the number of characters left to read, from the current line.
+     *
+     * @return number of characters left
+     */
+    [[nodiscard]] std::size_t remainingSize() const;
+
+    /**
+     * Read the integers of the current line without going to the next line.
+     *
+     * @param[out] values: integers read, at most maxValues
+     * @param[in] maxValues: maximum number of integers to read
+     * @return number of integers read, reading stops after maxValues integers
+     */
+    uint32_t parseLine(uint32_t *values, uint32_t maxValues);
+
+    /**
+     * Go to the next non empty line.
+     */
+    void nextLine();
+
+    /**
+     * Retrieve the content left to read, from the current position, to read binary data without any copy.
+     * When streaming, only the content already read from the descriptor is given.
+     *
+     * @return content left, valid until the reader is closed or reads the descriptor again
+     */
+    [[nodiscard]] std::string_view remaining() const;
+
+    /**
+     * Move the current position forward, without looking for lines.
+     *
+     * @param size: number of characters to skip, at most the number of characters left
+     */
+    void advance(std::size_t size);
+
+    /**
+     * Give back to the system the pages of a mapped file before the current position, once enough of them have been
+     * read. The content before the current position must not be used anymore.
+     */
+    void releaseConsumed();
+
+private:
+
+    /// Mapped file, nullptr if the file was read in mBuffer instead
+    void *mMapping = nullptr;
+
+    /// Size of the mapped file
+    std::size_t mMappingSize = 0u;
+
+    /// End of the pages of the mapping already given back to the system
+    std::size_t mReleasedSize = 0u;
+
+    /// Streamed content, when the file could not be mapped
+    std::string mBuffer;
+
+    /// Current position and end of the content
+    const char *mCursor = nullptr, *mEnd = nullptr;
+
+    /// Streamed descriptor, -1 for a mapped file, and if it has been opened by the reader
+    int mDescriptor = -1;
+    bool mOwnsDescriptor = false;
+
+    /// Size of a read from the descriptor
+    static constexpr std::size_t C_CHUNK_SIZE = 1u << 16u;
+
+    /// Size of the pages read from a mapped file triggering their release
+    static constexpr std::size_t C_RELEASE_SIZE = 1u << 24u;
+
+    /**
+     * Skip the empty lines from the current position. When streaming, only the content already read is skipped.
+     */
+    void skipEmptyLines();
+
+    /**
+     * When streaming, read the descriptor until the current line is complete, skipping the empty lines.
+     */
+    void fillLine();
+
+    /**
+     * Read a chunk from the descriptor at the end of the buffer, keeping the content left to read.
+     *
+     * @return false if the end of the descriptor has been reached
+     */
+    bool readChunk();
+
+    /**
+     * Stop streaming the descriptor, closing it if it has been opened by the reader.
+     */
+    void closeDescriptor();
+
+    /**
+     * Unmap the input file if needed and forget the content.
+     */
+    void close();
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_INPUTREADER_H
@@ -0,0 +1,120 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_INTERSECTIONCOUNTER_H
+#define SAFEANDMIRRORSPROBLEM_INTERSECTIONCOUNTER_H
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include "Segment.h"
+#include "ColumnTree.h"
+#include "CrossingKernel.h"
+
+/**
+ * Sweep-line engine counting the crossings between horizontal and vertical movements.
+ *
+ * The vertical movements are inserted in a Fenwick tree indexed by their (compressed) column while the rows are swept
+ * in ascending order. Each horizontal movement is then a single range query on the tree. The complexity time is
+ * O((H+V)*log(H+V)), with H the number of horizontal movements and V the number of vertical movements, and does not
+ * depend on the size of the Safe.
+ *
+ * With few vertical movements, sorting the events costs more than testing each horizontal movement against the
+ * vertical movements of its columns: they are then tested by the vectorized CrossingKernel instead.
+ *
+ * The events, the clipped movements and the column tree are members, so counting the next case reuses their memory.
+ */
+class IntersectionCounter {
+
+public:
+
+    /// Default maximum number of vertical movements tested by the kernel instead of the sweep
+    static constexpr std::size_t C_KERNEL_MAX_VERTICAL = 256u;
+
+    /**
+     * Override the maximum number of vertical movements tested by the kernel, so that small inputs can be counted by
+     * the sweep in tests. The result does not depend on it.
+     *
+     * @param maxVertical: maximum number of vertical movements tested by the kernel, 0 to always sweep
+     */
+    void setKernelMaxVertical(std::size_t maxVertical);
+
+    /**
+     * Count the crossings between horizontal and vertical movements and keep the lexicographically smallest one.
+     *
+     * A crossing is a cell strictly inside a vertical movement and inside a horizontal movement.
+     *
+     * @param[in] horizontal: movements along the rows
+     * @param[in] vertical: movements along the columns
+     * @param[out] nbIntersection: incremented total number of intersection
+     * @param[in out] row, column: position of the closest intersection, only replaced by a lexicographically
+     * smaller intersection
+     */
+    void count(std::span<const Segment> horizontal, std::span<const Segment> vertical,
+               int64_t &nbIntersection, uint32_t &row, uint32_t &column);
+
+    /**
+     * Count the crossings as count does, only in a band of rows. Bands partition the crossings: counting every band of
+     * a partition of the rows gives the same result as counting all rows at once.
+     *
+     * @param[in] horizontal: movements along the rows
+     * @param[in] vertical: movements along the columns
+     * @param[in] rowBegin, rowEnd: band of rows [rowBegin, rowEnd)
+     * @param[out] nbIntersection: incremented total number of intersection in the band
+     * @param[in out] row, column: position of the closest intersection, as count
+     */
+    void count(std::span<const Segment> horizontal, std::span<const Segment> vertical, uint32_t rowBegin,
+               uint32_t rowEnd, int64_t &nbIntersection, uint32_t &row, uint32_t &column);
+
+private:
+
+    /**
+     * Event of the sweep, ordered by row. At a given row, updates of the tree are done before the queries.
+     */
+    struct Event {
+        uint32_t row;  ///< Row where the event happens
+        uint32_t kind;  ///< 0: add a vertical movement, 1: remove a vertical movement, 2: query a horizontal movement
+        uint32_t index;  ///< Index of the associated movement
+    };
+
+    /// Active vertical movements in each column
+    ColumnTree mTree;
+
+    /// Events of the sweep
+    std::vector<Event> mEvents;
+
+    /// Vertical movements clipped to a band of rows
+    std::vector<Segment> mClipped;
+
+    /// Maximum number of vertical movements tested by the kernel instead of the sweep, unless overridden
+    std::size_t mKernelMaxVertical = C_KERNEL_MAX_VERTICAL;
+
+    /// Vertical movements sorted by column then row, as packed arrays for the kernel
+    std::vector<Segment> mSorted;
+    std::vector<uint32_t> mKernelColumns, mKernelLo, mKernelHi;
+
+    /**
+     * Count the crossings as sweep, by testing each horizontal movement against the vertical movements of its columns
+     * with the kernel.
+     *
+     * @param[in] horizontal, vertical, rowBegin, rowEnd: as sweep
+     * @param[out] nbIntersection, row, column: as count
+     */
+    void crossKernel(std::span<const Segment> horizontal, std::span<const Segment> vertical, uint32_t rowBegin,
+                     uint32_t rowEnd, int64_t &nbIntersection, uint32_t &row, uint32_t &column);
+
+    /**
+     * Sweep the rows of a band, the vertical movements being already clipped to the band.
+     *
+     * @param[in] horizontal, vertical: movements along the rows and the columns
+     * @param[in] rowBegin, rowEnd: band of rows [rowBegin, rowEnd), only horizontal movements inside are counted
+     * @param[out] nbIntersection, row, column: as count
+     */
+    void sweep(std::span<const Segment> horizontal, std::span<const Segment> vertical, uint32_t rowBegin,
+               uint32_t rowEnd, int64_t &nbIntersection, uint32_t &row, uint32_t &column);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_INTERSECTIONCOUNTER_H
@@ -5,6 +5,8 @@
 #ifndef SAFEANDMIRRORSPROBLEM_MIRROR_H
 #define SAFEANDMIRRORSPROBLEM_MIRROR_H
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <iostream>
 
@@ -77,6 +79,13 @@ public:
      */
     [[nodiscard]] uint32_t column() const;
 
+    /**
+     * Retrieve the kind of the mirror
+     *
+     * @return kind of mirror
+     */
+    [[nodiscard]] emirrorKind kind() const;
+
     /**
      * Gives the direction of the light after the mirror has reflected the incoming light
      *
@@ -85,13 +94,95 @@ public:
      */
     [[nodiscard]] edirection reflect(edirection incomingDirection) const;
 
+    /**
+     * Gives the direction of the light after a mirror of a given kind has reflected the incoming light.
+     * A single access to a table computed at compile time.
+     *
+     * @param mirrorKind: kind of the mirror
+     * @param incomingDirection: direction of the incoming light beam
+     * @return new direction of the light beam after reflection
+     */
+    [[nodiscard]] static constexpr edirection reflect(emirrorKind mirrorKind, edirection incomingDirection);
+
+    /**
+     * Gives the opposite of a direction, ie the direction of a light beam going back on its path
+     *
+     * @param direction: direction of the light beam
+     * @return opposite direction
+     */
+    [[nodiscard]] static constexpr edirection opposite(edirection direction);
+
 private:
     /// Position in the Safe
     uint32_t mRow, mColumn;
 
     /// Kind of mirror (/, \ or none)
     emirrorKind mKind;
+
+    /// Reflected direction for each kind of mirror and each incoming direction, indexed by the enums
+    static const std::array<std::array<edirection, 4>, 3> C_REFLECTIONS;
+
+    /**
+     * Compute the direction of the light after a mirror of a given kind has reflected the incoming light, to fill the
+     * table of reflections at compile time.
+     *
+     * @param mirrorKind: kind of the mirror
+     * @param incomingDirection: direction of the incoming light beam
+     * @return new direction of the light beam after reflection
+     */
+    static constexpr edirection computeReflection(emirrorKind mirrorKind, edirection incomingDirection);
 };
 
+constexpr Mirror::edirection Mirror::computeReflection(const emirrorKind mirrorKind,
+                                                       const edirection incomingDirection) {
+
+    /// By default the mirror does not reflect (pass-through). Behaviour associated with kind kindNone
+    edirection reflectedDirection = incomingDirection;
+
+    /// If mirror is of kind kindNone, no reflection: return here.
+    if(mirrorKind == emirrorKind::eKindNone) return reflectedDirection;
+
+    /// For each incoming direction, associate a new direction (reflection) depending on the kind of mirror
+    /// (either rightLeft / or leftRight \)
+    switch (incomingDirection) {
+        case edirection::eDirUp :
+            reflectedDirection = mirrorKind == emirrorKind::eKindRightLeft ? edirection::eDirRight : edirection::eDirLeft;
+            break;
+        case edirection::eDirDown :
+            reflectedDirection = mirrorKind == emirrorKind::eKindRightLeft ? edirection::eDirLeft : edirection::eDirRight;
+            break;
+        case edirection::eDirLeft :
+            reflectedDirection = mirrorKind == emirrorKind::eKindRightLeft ? edirection::eDirDown : edirection::eDirUp;
+            break;
+        case edirection::eDirRight :
+            reflectedDirection = mirrorKind == emirrorKind::eKindRightLeft ? edirection::eDirUp : edirection::eDirDown;
+            break;
+    }
+    return reflectedDirection;
+}
+
+inline constexpr std::array<std::array<Mirror::edirection, 4>, 3> Mirror::C_REFLECTIONS = [] {
+    std::array<std::array<edirection, 4>, 3> reflections{};
+    for (uint8_t kind = 0u; kind < reflections.size(); ++kind)
+        for (uint8_t direction = 0u; direction < reflections[kind].size(); ++direction)
+            reflections[kind][direction] = computeReflection(static_cast<emirrorKind>(kind),
+                                                             static_cast<edirection>(direction));
+    return reflections;
+}();
+
+constexpr Mirror::edirection Mirror::reflect(const emirrorKind mirrorKind, const edirection incomingDirection) {
+    return C_REFLECTIONS[static_cast<uint8_t>(mirrorKind)][static_cast<uint8_t>(incomingDirection)];
+}
+
+constexpr Mirror::edirection Mirror::opposite(const edirection direction) {
+    /// Directions go by pairs of opposite directions: right and left, up and down
+    return static_cast<edirection>(static_cast<uint8_t>(direction) ^ 1u);
+}
+
+static_assert(Mirror::reflect(Mirror::emirrorKind::eKindRightLeft, Mirror::edirection::eDirRight) ==
+              Mirror::edirection::eDirUp, "A mirror / reflects a beam going right upwards");
+static_assert(Mirror::opposite(Mirror::edirection::eDirUp) == Mirror::edirection::eDirDown,
+              "Opposite directions go by pairs");
+
 
 #endif //SAFEANDMIRRORSPROBLEM_MIRROR_H
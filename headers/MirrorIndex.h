@@ -0,0 +1,198 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_MIRRORINDEX_H
+#define SAFEANDMIRRORSPROBLEM_MIRRORINDEX_H
+
+#include <array>
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "Mirror.h"
+#include "Safe.h"
+
+/**
+ * Compact and contiguous index of the mirrors of a Safe.
+ *
+ * Mirrors are sorted once, using a radix sort, in row-major order: the identifier of a mirror is its rank in this order.
+ * For each mirror, the closest mirror in each of the four (4) directions is precomputed, so each step of a trajectory is a
+ * single array access. The laser and the detector are represented by virtual mirrors of kind eKindNone.
+ *
+ * A beam is followed as a state: a mirror and the direction in which the beam leaves it. The reflection by the next
+ * mirror is applied when the index is built, so the next state is read directly from the current one: a trajectory
+ * is a chain of loads in a single array, without any test on the kind of the mirrors.
+ *
+ * The radix sort keys and the steps stay allocated after a build, so a breaker reusing its index for the next case
+ * only allocates when that Safe has more mirrors than the previous ones.
+ */
+class MirrorIndex {
+
+public:
+
+    /// Identifier used when there is no mirror in a direction
+    static constexpr uint32_t C_NO_MIRROR = UINT32_MAX;
+
+    /// State used when the beam leaves the Safe without reaching any mirror
+    static constexpr uint32_t C_NO_STATE = UINT32_MAX;
+
+    /**
+     * Build the index from the mirrors of a Safe and the virtual mirrors of the laser and the detector.
+     *
+     * When several mirrors share the same position, the last one added to the Safe is kept.
+     *
+     * @param mirrors: view of the mirrors of the Safe
+     * @param laserPos, detectorPos: positions of the laser and the detector
+     */
+    void build(const Safe::MirrorsView &mirrors, const std::array<uint32_t, 2> &laserPos,
+               const std::array<uint32_t, 2> &detectorPos);
+
+    /**
+     * Retrieve the next state of a beam: the closest mirror in the direction of the state, and the direction in which
+     * the beam leaves it once reflected.
+     *
+     * @param state: mirror left by the beam and its direction
+     * @return next state, C_NO_STATE if there is no mirror until the end of the Safe
+     */
+    [[nodiscard]] uint32_t next(uint32_t state) const { return mSteps[state]; }
+
+    /**
+     * Build the state of a beam leaving a mirror.
+     *
+     * @param mirror: identifier of the mirror
+     * @param direction: direction of the beam
+     * @return state of the beam
+     */
+    [[nodiscard]] static constexpr uint32_t state(uint32_t mirror, Mirror::edirection direction) {
+        return mirror << 2u | static_cast<uint8_t>(direction);
+    }
+
+    /**
+     * Retrieve the mirror of a state
+     *
+     * @param state: state of a beam
+     * @return identifier of the mirror left by the beam
+     */
+    [[nodiscard]] static constexpr uint32_t mirror(uint32_t state) { return state >> 2u; }
+
+    /**
+     * Retrieve the direction of a state
+     *
+     * @param state: state of a beam
+     * @return direction of the beam
+     */
+    [[nodiscard]] static constexpr Mirror::edirection direction(uint32_t state) {
+        return static_cast<Mirror::edirection>(state & 3u);
+    }
+
+    /**
+     * Retrieve the row position of a mirror
+     *
+     * @param mirror: identifier of the mirror
+     * @return row position of the mirror
+     */
+    [[nodiscard]] uint32_t row(uint32_t mirror) const { return mRows[mirror]; }
+
+    /**
+     * Retrieve the column position of a mirror
+     *
+     * @param mirror: identifier of the mirror
+     * @return column position of the mirror
+     */
+    [[nodiscard]] uint32_t column(uint32_t mirror) const { return mColumns[mirror]; }
+
+    /**
+     * Retrieve the kind of a mirror
+     *
+     * @param mirror: identifier of the mirror
+     * @return kind of the mirror
+     */
+    [[nodiscard]] Mirror::emirrorKind kind(uint32_t mirror) const { return mKinds[mirror]; }
+
+    /**
+     * Retrieve the mirror at a given position, using a binary search in row-major order
+     *
+     * @param row, column: position of the mirror
+     * @return identifier of the mirror, C_NO_MIRROR if there is no mirror at this position
+     */
+    [[nodiscard]] uint32_t find(uint32_t row, uint32_t column) const;
+
+    /**
+     * Retrieve the closest mirror from a position in a direction, using a binary search in row-major order (along a
+     * row) or in column-major order (along a column)
+     *
+     * @param row, column: position to start from, excluded
+     * @param direction: direction to look in
+     * @return identifier of the closest mirror, C_NO_MIRROR if there is no mirror until the end of the Safe
+     */
+    [[nodiscard]] uint32_t closest(uint32_t row, uint32_t column, Mirror::edirection direction) const;
+
+    /**
+     * Mark the states of the beams going round a loop of mirrors forever, never leaving the Safe. Each state is
+     * followed once, the next state of a state being the next state of no other one.
+     *
+     * @param[out] looping: for each state, 1 if the beam loops, 0 if it leaves the Safe
+     */
+    void findLoops(std::vector<uint8_t> &looping) const;
+
+    /**
+     * Retrieve the identifiers of the mirrors in column-major order, as sorted by the last build
+     *
+     * @return identifiers of the mirrors, including the laser and the detector
+     */
+    [[nodiscard]] std::span<const uint32_t> columnOrder() const { return mOrder; }
+
+    /**
+     * Retrieve the identifier of the virtual mirror representing the laser
+     *
+     * @return identifier of the laser
+     */
+    [[nodiscard]] uint32_t laser() const { return mLaser; }
+
+    /**
+     * Retrieve the identifier of the virtual mirror representing the detector
+     *
+     * @return identifier of the detector
+     */
+    [[nodiscard]] uint32_t detector() const { return mDetector; }
+
+    /**
+     * Retrieve the number of mirrors in the index, including the laser and the detector
+     *
+     * @return number of mirrors
+     */
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(mRows.size()); }
+
+private:
+
+    /// Positions and kinds of the mirrors, in row-major order
+    std::vector<uint32_t> mRows, mColumns;
+    std::vector<Mirror::emirrorKind> mKinds;
+
+    /// Next state of each state: closest mirror in each direction, indexed by the edirection enum, then reflected
+    std::vector<uint32_t> mSteps;
+
+    /// Identifiers of the virtual mirrors
+    uint32_t mLaser = C_NO_MIRROR, mDetector = C_NO_MIRROR;
+
+    /// Working buffers of the radix sort: keys and identifiers to sort, count of each digit. Once built, mOrder holds
+    /// the identifiers in column-major order.
+    std::vector<uint64_t> mKeys, mKeysBuffer;
+    std::vector<uint32_t> mOrder, mOrderBuffer, mHistogram;
+
+    /// Working buffer of the sort of small inputs: key and identifier of each mirror
+    std::vector<std::pair<uint64_t, uint32_t>> mPairs;
+
+    /**
+     * Sort the identifiers of mOrder by their keys in mKeys, using a stable least significant digit radix sort.
+     *
+     * Passes where every key has the same digit are skipped. Small inputs are sorted by comparison instead, since
+     * clearing the histogram of a pass would cost more than the sort itself.
+     */
+    void radixSort();
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_MIRRORINDEX_H
@@ -0,0 +1,210 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_MIRRORROUTER_H
+#define SAFEANDMIRRORSPROBLEM_MIRRORROUTER_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Mirror.h"
+#include "MirrorIndex.h"
+
+/**
+ * Engine finding the minimum number of mirrors to add to a Safe so that the laser beam reaches the detector, and one
+ * placement of these mirrors.
+ *
+ * This is a 0-1 shortest path over the states of the beam: following a movement up to a mirror of the Safe costs 0, and
+ * turning on an empty cell, by adding a mirror, costs 1. The graph is never built on the cells of the Safe. Its nodes
+ * are the pieces of rows and columns between two mirrors (or a mirror and a side of the Safe), in each direction:
+ * - the rows and columns without any mirror are grouped by consecutive ranges, each range being a single piece, since
+ * all of its rows (or columns) are equivalent;
+ * - a piece reaching a mirror continues, at no cost, on the piece leaving the mirror in the reflected direction;
+ * - a piece can turn, at a cost of 1, on every piece crossing it.
+ * The pieces are built from the MirrorIndex, their rows and columns are compressed: the graph has O(n) nodes for n
+ * mirrors, whatever the size of the Safe.
+ *
+ * The search goes layer by layer: the layer k holds the pieces reached with k added mirrors. The pieces crossing a new
+ * piece of the layer k are found by two sweeps (rows of the layer against unvisited columns, and the reverse), each
+ * piece being reached once. As usual for this problem, an added mirror is assumed to be crossed only once by the beam.
+ *
+ * A router is meant to be reused: the pieces, the layers and the sweep events of a Safe only grow the arrays of the
+ * previous Safes.
+ */
+class MirrorRouter {
+
+public:
+
+    /**
+     * Mirror to add to the Safe
+     */
+    struct Placement {
+        uint32_t row, column;  ///< Position of the mirror
+        Mirror::emirrorKind kind;  ///< Kind of the mirror
+    };
+
+    /**
+     * Find the minimum number of mirrors to add so that the laser beam reaches the detector.
+     *
+     * @param[in] index: mirrors of the Safe, with the laser and the detector
+     * @param[in] rows, columns: size of the Safe
+     * @param[out] placements: mirrors to add, in the order the beam reaches them
+     * @return minimum number of mirrors, 0 if the laser already reaches the detector, -1 if no number of mirrors does
+     */
+    int64_t route(const MirrorIndex &index, uint32_t rows, uint32_t columns, std::vector<Placement> &placements);
+
+private:
+
+    /// Identifier used when there is no piece, mirror, layer or previous node
+    static constexpr uint32_t C_NONE = UINT32_MAX;
+
+    /// Previous node of a node reached by a turn, and of the first node
+    static constexpr uint32_t C_TURN = UINT32_MAX - 1u, C_START = UINT32_MAX - 2u;
+
+    /**
+     * Range of consecutive rows (or columns): a single row or column holding mirrors, or a range without any mirror
+     */
+    struct Range {
+        uint32_t first, last;  ///< First and last row (or column) of the range
+    };
+
+    /**
+     * Piece of a row (or a column) between two consecutive mirrors, or a range of rows (or columns) without mirror.
+     * Every coordinate is the index of a range: the ranges 0 and count+1 are the outside of the Safe.
+     */
+    struct Piece {
+        uint32_t fixed;  ///< Range of the row (or column) of the piece
+        uint32_t lo, hi;  ///< Ranges of the ends of the piece, the cells strictly between them belong to the piece
+        uint32_t ends[2];  ///< Mirror at the lower and the higher end, C_NONE for a side of the Safe
+    };
+
+    /**
+     * Set of indexes, searched for the next index of the set in O(log64(n)), one bit per index on each level
+     */
+    class ActiveSet {
+
+    public:
+
+        /**
+         * Empty the set and resize it
+         *
+         * @param size: number of possible indexes
+         */
+        void reset(uint32_t size);
+
+        /// Add an index to the set
+        void insert(uint32_t index);
+
+        /// Remove an index from the set
+        void erase(uint32_t index);
+
+        /**
+         * Retrieve the first index of the set not before a given one
+         *
+         * @param index: first index to consider
+         * @return index found, C_NONE if none
+         */
+        [[nodiscard]] uint32_t next(uint32_t index) const;
+
+    private:
+
+        /// Bits of the indexes, then one bit per non-empty word of the previous level
+        std::vector<std::vector<uint64_t>> mLevels;
+    };
+
+    /// Ranges of the rows and of the columns, the outside of the Safe excluded
+    std::vector<Range> mRowRanges, mColumnRanges;
+
+    /// Range of the row and of the column of each mirror of the index
+    std::vector<uint32_t> mMirrorRows, mMirrorColumns;
+
+    /// Pieces of the rows, then pieces of the columns
+    std::vector<Piece> mPieces;
+    uint32_t mNbHorizontal = 0u;
+
+    /// Piece left by a beam leaving a mirror in each direction, indexed as the states of the MirrorIndex
+    std::vector<uint32_t> mPieceOf;
+
+    /// Layer of each node (2 per piece: towards the lower then the higher end), and its previous node
+    std::vector<uint32_t> mLayers, mPrevious;
+
+    /// Layer of the first node reached of each piece. For a piece reached by a turn: piece turned from and cell.
+    std::vector<uint32_t> mFirstLayers, mParents, mCellRows, mCellColumns;
+
+    /// Pieces reached for the first time in the current layer, and pieces crossing them with the frontier piece
+    std::vector<uint32_t> mFrontier;
+    std::vector<std::pair<uint32_t, uint32_t>> mCrossings;
+
+    /// Sweep: changes of the active pieces, and pieces of the current row (or column) range
+    std::vector<std::pair<uint32_t, uint32_t>> mEvents;
+    std::vector<uint32_t> mActivePieces;
+    ActiveSet mActive;
+
+    /**
+     * Group the rows and columns in ranges, and build the pieces between the mirrors.
+     *
+     * @param index: mirrors of the Safe
+     * @param rows, columns: size of the Safe
+     */
+    void buildPieces(const MirrorIndex &index, uint32_t rows, uint32_t columns);
+
+    /**
+     * Check if a piece is a range of rows (or columns) without any mirror. Such a piece is visited in both directions
+     * at once: its ends are sides of the Safe.
+     *
+     * @param piece: identifier of the piece
+     * @return true if the piece has no mirror at its ends
+     */
+    [[nodiscard]] bool isBundle(uint32_t piece) const {
+        return mPieces[piece].ends[0] == C_NONE && mPieces[piece].ends[1] == C_NONE;
+    }
+
+    /**
+     * Direction of a beam following a node
+     *
+     * @param node: piece and direction
+     * @return direction of the beam
+     */
+    [[nodiscard]] Mirror::edirection directionOf(uint32_t node) const;
+
+    /**
+     * Retrieve the piece of the other orientation a frontier piece can not turn on: the piece it has been reached from,
+     * if it has only been reached by a turn. Turning back on it would need two mirrors on the same cell.
+     *
+     * @param piece: piece of the frontier
+     * @return piece turned from, C_NONE if any crossing piece can be turned on
+     */
+    [[nodiscard]] uint32_t excludedOf(uint32_t piece) const;
+
+    /**
+     * Reach a node in a layer, and the nodes following it through the mirrors of the Safe.
+     *
+     * @param index: mirrors of the Safe
+     * @param node: node reached
+     * @param previous: previous node, C_TURN or C_START
+     * @param layer: current layer
+     * @return last node followed if it reaches the detector, C_NONE otherwise
+     */
+    uint32_t reach(const MirrorIndex &index, uint32_t node, uint32_t previous, uint32_t layer);
+
+    /**
+     * Find the pieces of one orientation, not visited in both directions, crossing a piece of the frontier of the other
+     * orientation. Each piece found is added to mCrossings with one of the frontier pieces crossing it.
+     *
+     * @param horizontal: true to sweep the columns with the rows of the frontier, false for the reverse
+     */
+    void sweep(bool horizontal);
+
+    /**
+     * Rebuild the mirrors added on the path from the laser to a node.
+     *
+     * @param node: last node of the path
+     * @param placements: mirrors added, in the order the beam reaches them
+     */
+    void placementsTo(uint32_t node, std::vector<Placement> &placements) const;
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_MIRRORROUTER_H
@@ -0,0 +1,134 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_REFERENCESOLVER_H
+#define SAFEANDMIRRORSPROBLEM_REFERENCESOLVER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Mirror.h"
+#include "Safe.h"
+#include "SafeBreaker.h"
+
+/**
+ * Reference solver of small Safes, used as ground truth for the SafeBreaker.
+ *
+ * Nothing of the SafeBreaker is reused but its types: the Safe is drawn on a grid of cells, and the laser beam is
+ * simulated cell by cell. Each empty cell is tried with both kinds of mirror, the beam being simulated again from the
+ * laser for each of them. The time is in O(rows * columns) per simulation, O((rows * columns)^2) per Safe: only small
+ * Safes can be solved.
+ *
+ * The grid is kept between Safes to avoid reallocating it.
+ */
+class ReferenceSolver {
+
+public:
+
+    /// Maximum number of cells of a Safe solved by the reference solver
+    static constexpr uint64_t C_MAX_CELLS = 1u << 16u;
+
+    /**
+     * Compute the solutions to open the Safe, with the same results as SafeBreaker::solve.
+     *
+     * @param[in] safe: Safe to open, of at most C_MAX_CELLS cells
+     * @param[out] nbSolution: number of solution, 0 if the Safe is opened without mirror, -1 if it can not be opened
+     * @param[out] row, column: position of the lexicographically smallest solution, if any
+     * @return false if the Safe is too big to be solved (error displayed)
+     */
+    bool solve(const Safe &safe, int64_t &nbSolution, uint32_t &row, uint32_t &column);
+
+    /**
+     * Check which placements of a single mirror open the Safe, with the same answers as SafeBreaker::checkCandidates.
+     * The beam is simulated from the laser with the mirror of each candidate placed on its empty cell.
+     *
+     * @param[in] safe: Safe to open, of at most C_MAX_CELLS cells
+     * @param[in] candidates: placements to check
+     * @param[out] answers: answer for each candidate, same size as candidates
+     * @return false if the Safe is too big to be checked (error displayed)
+     */
+    bool checkCandidates(const Safe &safe, std::span<const SafeBreaker::Candidate> candidates,
+                         std::span<SafeBreaker::ecandidate> answers);
+
+    /**
+     * Give every solution to open the Safe to a sink, in lexicographic order, with the same solutions as
+     * SafeBreaker::enumerateSolutions. Each empty cell is given with each kind of mirror opening the Safe.
+     *
+     * @param safe: Safe to open, of at most C_MAX_CELLS cells
+     * @param sink: receiver of the solutions, none if the laser already reaches the detector
+     * @return false if the Safe is too big to be solved (error displayed)
+     */
+    bool enumerateSolutions(const Safe &safe, const SolutionEnumerator::Sink &sink);
+
+    /**
+     * Find the minimum number of mirrors to add to open the Safe, as SafeBreaker::minimumMirrors, up to a bound. Every
+     * set of 1, 2, ... mirrors of any kind on distinct empty cells is tried, the beam being simulated from the laser
+     * for each of them: the time grows as (2 * rows * columns)^maxMirrors.
+     *
+     * @param[in] safe: Safe to open, of at most C_MAX_CELLS cells
+     * @param[in] maxMirrors: biggest number of mirrors tried
+     * @param[out] minimum: minimum number of mirrors, 0 if the laser already reaches the detector, -1 if no set of at
+     * most maxMirrors mirrors opens the Safe
+     * @return false if the Safe is too big to be solved (error displayed)
+     */
+    bool minimumMirrors(const Safe &safe, uint32_t maxMirrors, int64_t &minimum);
+
+    /**
+     * Check that mirrors added to a Safe open it: each mirror is on its own empty cell, and the beam simulated with all
+     * of them reaches the detector.
+     *
+     * @param[in] safe: Safe to open, of at most C_MAX_CELLS cells
+     * @param[in] placements: mirrors to add
+     * @param[out] opens: true if the mirrors open the Safe
+     * @return false if the Safe is too big to be checked (error displayed)
+     */
+    bool checkPlacements(const Safe &safe, std::span<const MirrorRouter::Placement> placements, bool &opens);
+
+private:
+
+    /// Number of rows and columns of the current Safe
+    uint32_t mRows = 0u, mColumns = 0u;
+
+    /// Kind of mirror on each cell, row by row
+    std::vector<Mirror::emirrorKind> mCells;
+
+    /**
+     * Draw the mirrors of a Safe on the grid of cells, in the order they were added: the last mirror of a cell is kept,
+     * as by the SafeBreaker
+     *
+     * @param safe: Safe to draw
+     * @return false if the Safe is too big to be drawn (error displayed)
+     */
+    bool draw(const Safe &safe);
+
+    /**
+     * Retrieve the mirror on a cell of the grid
+     *
+     * @param row, column: position of the cell, inside the Safe
+     * @return kind of the mirror on the cell, eKindNone if empty
+     */
+    [[nodiscard]] Mirror::emirrorKind &cell(uint32_t row, uint32_t column) {
+        return mCells[static_cast<std::size_t>(row - 1u) * mColumns + column - 1u];
+    }
+
+    /**
+     * Simulate the laser beam from the laser until it leaves the Safe.
+     *
+     * @return true if the beam leaves the Safe through the detector
+     */
+    [[nodiscard]] bool reachesDetector() const;
+
+    /**
+     * Try every set of mirrors on distinct empty cells, from a first cell, with the beam simulated for each set.
+     *
+     * @param first: first cell tried, row by row from 0
+     * @param nbMirrors: number of mirrors to add
+     * @return true if a set opens the Safe
+     */
+    bool placeMirrors(std::size_t first, uint32_t nbMirrors);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_REFERENCESOLVER_H
@@ -0,0 +1,177 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_RESULTCACHE_H
+#define SAFEANDMIRRORSPROBLEM_RESULTCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Safe.h"
+
+/**
+ * Cache of the results of the Safes already solved, addressed by the content of the Safe.
+ *
+ * A Safe is keyed by a 128 bits hash of its size and of the set of its mirrors. The hash of the mirrors is a sum of the
+ * hash of each mirror: it does not depend on their order and is computed in a single pass over the arrays of the Safe.
+ * A hash never proves that two Safes are the same: a found entry is compared with the Safe, mirror by mirror, before
+ * its result is used. Entries are evicted in least recently used order when the cache is full.
+ *
+ * The cache can be saved in a file and loaded back by a later run. Every method can be called concurrently.
+ */
+class ResultCache {
+
+public:
+
+    /**
+     * Hash of a Safe
+     */
+    struct Key {
+        uint64_t low = 0u, high = 0u;  ///< Both halves of the hash
+
+        bool operator==(const Key &other) const = default;
+    };
+
+    /**
+     * Result of a Safe, as given by the SafeBreaker
+     */
+    struct Result {
+        int64_t nbSolution = 0;  ///< Number of solution, 0 if opened without mirror, negative if impossible
+        uint32_t row = 0u, column = 0u;  ///< Position of the closest solution
+    };
+
+    /**
+     * Construct an empty cache.
+     *
+     * @param capacity: maximum number of Safes kept, 0 to disable the cache
+     */
+    explicit ResultCache(std::size_t capacity = 0u);
+
+    /**
+     * Change the maximum number of Safes kept, evicting the least recently used ones if needed.
+     *
+     * @param capacity: maximum number of Safes kept, 0 to disable the cache
+     */
+    void setCapacity(std::size_t capacity);
+
+    /**
+     * Check if the cache keeps any Safe.
+     *
+     * @return true if the capacity is not 0
+     */
+    [[nodiscard]] bool enabled() const;
+
+    /**
+     * Compute the hash of a Safe.
+     *
+     * @param safe: Safe to hash
+     * @return hash of the size and mirrors of the Safe, independent of the order of the mirrors
+     */
+    [[nodiscard]] static Key hash(const Safe &safe);
+
+    /**
+     * Retrieve the result of a Safe, if the same Safe has been solved.
+     *
+     * @param[in] key: hash of the Safe
+     * @param[in] safe: Safe to compare with the entry of the hash
+     * @param[out] result: result of the Safe, if found
+     * @return true if the result has been found
+     */
+    bool find(const Key &key, const Safe &safe, Result &result);
+
+    /**
+     * Keep the result of a Safe, replacing any entry of the same hash.
+     *
+     * @param key: hash of the Safe
+     * @param safe: Safe solved, its mirrors are copied
+     * @param result: result of the Safe
+     */
+    void insert(const Key &key, const Safe &safe, const Result &result);
+
+    /**
+     * Add the entries saved in a file, until the cache is full. A missing file is not an error: the cache is empty.
+     *
+     * @param fileName: name of the cache file
+     * @return false if the file exists but is not a valid cache file
+     */
+    bool load(const std::string &fileName);
+
+    /**
+     * Save the entries in a file, the most recently used first.
+     *
+     * @param fileName: name of the cache file
+     * @return true if the file has been written
+     */
+    bool save(const std::string &fileName);
+
+private:
+
+    /// Maximum number of mirrors kept by all the entries, bounding the memory of the cache
+    static constexpr std::size_t C_MAX_MIRRORS = 1u << 22u;
+
+    /**
+     * Safe solved and its result
+     */
+    struct Entry {
+        Key key;  ///< Hash of the Safe
+        uint32_t rows, columns;  ///< Size of the Safe
+        std::vector<uint32_t> mirrorRows, mirrorColumns;  ///< Positions of the mirrors, in the order of the Safe
+        std::vector<Mirror::emirrorKind> kinds;  ///< Kinds of the mirrors
+        Result result;  ///< Result of the Safe
+    };
+
+    /**
+     * Hasher of the keys: the key is already a hash
+     */
+    struct KeyHasher {
+        std::size_t operator()(const Key &key) const { return static_cast<std::size_t>(key.low ^ key.high); }
+    };
+
+    /// Protects every member, except the capacity which can be read without it
+    std::mutex mMutex;
+
+    /// Entries, the most recently used first
+    std::list<Entry> mEntries;
+
+    /// Entry of each hash
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHasher> mIndex;
+
+    /// Maximum number of entries, changed under the mutex but checked by enabled() without it
+    std::atomic<std::size_t> mCapacity;
+
+    /// Number of mirrors kept by all the entries
+    std::size_t mNbMirrors = 0u;
+
+    /**
+     * Compare an entry with a Safe: same size and same mirrors, in the same order or not.
+     *
+     * @param entry: entry to compare
+     * @param safe: Safe to compare
+     * @return true if the Safe of the entry is the same as the Safe
+     */
+    static bool sameSafe(const Entry &entry, const Safe &safe);
+
+    /**
+     * Add an entry as the most recently used one, replacing any entry of the same hash, then evict the least recently
+     * used entries while the cache is too big. The mutex must be locked.
+     *
+     * @param entry: entry to add
+     */
+    void add(Entry &&entry);
+
+    /**
+     * Remove an entry. The mutex must be locked.
+     *
+     * @param entry: entry to remove
+     */
+    void remove(std::list<Entry>::iterator entry);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_RESULTCACHE_H
@@ -0,0 +1,189 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_RESULTWRITER_H
+#define SAFEANDMIRRORSPROBLEM_RESULTWRITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include "AllocationTracker.h"
+#include "MirrorRouter.h"
+
+/**
+ * Sink saving the results of the cases in an output file.
+ *
+ * The output file is opened only once and results are written in a buffer, flushed in the file when its size reaches
+ * a limit or when a time interval has passed since the last flush. Results can be saved as text (as displayed),
+ * as JSON Lines or as fixed-width binary records.
+ */
+class ResultWriter {
+
+public:
+
+    /**
+     * Definition of all possible formats of the output file.
+     */
+    enum class eformat {
+        eFormatText,  ///< One line per case: "Case N: ..."
+        eFormatJsonLines,  ///< One JSON object per line
+        eFormatBinary  ///< One BinaryRecord per case
+    };
+
+    /**
+     * Definition of all possible status of a case.
+     */
+    enum class estatus : uint8_t {
+        eStatusOpened = 0u,  ///< The laser reaches the detector without any added mirror
+        eStatusSolutions = 1u,  ///< The safe can be opened by adding a mirror
+        eStatusImpossible = 2u,  ///< The safe can not be opened by adding a single mirror
+        eStatusPlacement = 3u,  ///< One enumerated solution: row and column of the mirror, its kind in kind
+        eStatusMinimum = 4u,  ///< Minimum number of mirrors in nbSolution (0 if none opens), followed by placements
+        eStatusMemory = 5u  ///< Peak of live heap bytes of the case in nbSolution and nbSolutionHigh
+    };
+
+    /**
+     * Fixed-width binary record of a case, in the native byte order (little-endian on x86).
+     */
+    struct BinaryRecord {
+        uint32_t caseId;  ///< Number of the case, starting from 0
+        uint32_t nbSolution;  ///< Bits 0 to 31 of the number of solution, 0 if opened or impossible
+        uint32_t row, column;  ///< Position of the closest solution, 0 if no solution
+        estatus status;  ///< Status of the case
+        uint8_t kind;  ///< Kind of a placement: 0 for (/), 1 for (\), always 0 for a case
+        uint16_t nbSolutionHigh;  ///< Bits 32 to 47 of the number of solution, 0 on grids of the usual size
+    };
+    static_assert(sizeof(BinaryRecord) == 20u, "Binary records must be 20 bytes wide");
+
+    /**
+     * Construct a writer without output file: results are ignored until a file is opened.
+     */
+    ResultWriter() = default;
+
+    /**
+     * Flush the remaining results and close the output file.
+     */
+    ~ResultWriter();
+
+    /// The output file is owned by the writer: no copy
+    ResultWriter(const ResultWriter &) = delete;
+    ResultWriter &operator=(const ResultWriter &) = delete;
+
+    /**
+     * Create or clear the output file and keep it opened. Any previously opened file is flushed and closed.
+     *
+     * @param fileName: name of the output file
+     * @param format: format of the results
+     * @return true if the file has been opened
+     */
+    bool open(const std::string &fileName, eformat format);
+
+    /**
+     * Set when the buffer is flushed in the output file.
+     *
+     * @param flushBytes: size of the buffer triggering a flush
+     * @param flushInterval: time since the last flush triggering a flush, checked when a result is written or
+     * by flushIfDue
+     */
+    void setFlushPolicy(std::size_t flushBytes, std::chrono::milliseconds flushInterval);
+
+    /**
+     * Save the result of a case.
+     *
+     * @param caseId: number of the case
+     * @param nbSolution: number of solution, 0 if opened without mirror, negative if impossible
+     * @param row, column: position of the closest solution
+     */
+    void write(uint32_t caseId, int64_t nbSolution, uint32_t row, uint32_t column);
+
+    /**
+     * Save one solution of a case, when every solution is enumerated.
+     *
+     * The buffer is only flushed when full: solutions are produced much faster than cases.
+     *
+     * @param caseId: number of the case
+     * @param row, column: position of the mirror to place
+     * @param slash: true if the mirror is of type (/), false if of type (\)
+     */
+    void writeSolution(uint32_t caseId, uint32_t row, uint32_t column, bool slash);
+
+    /**
+     * Save the minimum number of mirrors to add to open a Safe and their placement: "Case N minimum: K r c / ...".
+     * In binary format, a record of status eStatusMinimum is followed by one record of status eStatusPlacement per
+     * mirror, in the order the laser beam reaches them.
+     *
+     * @param caseId: number of the case
+     * @param nbMirrors: minimum number of mirrors, -1 if no number of mirrors opens the Safe
+     * @param placements: mirrors to add
+     */
+    void writeMinimum(uint32_t caseId, int64_t nbMirrors, std::span<const MirrorRouter::Placement> placements);
+
+    /**
+     * Save the heap allocations of a case: "Case N memory: peak P bytes (+G), parse A allocations B bytes, ...", where
+     * G is the growth of the live bytes since the start of the case. In binary format, only the peak is saved, in a
+     * record of status eStatusMemory.
+     *
+     * @param caseId: number of the case
+     * @param usage: allocations of each phase and peak of live bytes of the case
+     */
+    void writeMemory(uint32_t caseId, const AllocationTracker::Usage &usage);
+
+    /**
+     * Flush the buffer if the time interval has passed since the last flush.
+     */
+    void flushIfDue();
+
+    /**
+     * Write the buffer in the output file.
+     */
+    void flush();
+
+    /**
+     * Flush the buffer and close the output file.
+     */
+    void close();
+
+    /**
+     * Format the result of a case as displayed: "Case N: ...".
+     *
+     * @param[out] text: formatted result, without line feed
+     * @param[in] caseId: number of the case
+     * @param[in] nbSolution: number of solution, 0 if opened without mirror, negative if impossible
+     * @param[in] row, column: position of the closest solution
+     */
+    static void formatText(std::string &text, uint32_t caseId, int64_t nbSolution, uint32_t row, uint32_t column);
+
+    /**
+     * Parse the name of a format.
+     *
+     * @param[in] name: name of the format: text, jsonl or binary
+     * @param[out] format: parsed format
+     * @return true if the name is known
+     */
+    static bool parseFormat(const std::string &name, eformat &format);
+
+private:
+
+    /// Output file, opened once
+    std::ofstream mFile;
+
+    /// Format of the results
+    eformat mFormat = eformat::eFormatText;
+
+    /// Results waiting to be written
+    std::string mBuffer;
+
+    /// Size of the buffer and time interval triggering a flush
+    std::size_t mFlushBytes = 1u << 20u;
+    std::chrono::milliseconds mFlushInterval{1000};
+
+    /// Time of the last flush
+    std::chrono::steady_clock::time_point mLastFlush;
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_RESULTWRITER_H
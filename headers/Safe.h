@@ -5,20 +5,52 @@
 #ifndef SAFEANDMIRRORSPROBLEM_SAFE_H
 #define SAFEANDMIRRORSPROBLEM_SAFE_H
 
-#include <list>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
 #include <iostream>
 #include "Mirror.h"
 
 /**
  * Description of a safe of size rows*columns containing several mirrors.
  *
- * Constraints: 1 <= rows, columns <= 1000000.
+ * Constraints: 1 <= rows, columns <= 1000000 (C_MAX_LENGTH), or <= 2^31 (C_LARGE_MAX_LENGTH) in large grid mode, see
+ * setLargeGrid.
  * The safe can be changed during its lifetime and will readjust itself automatically to keep logical coherency:
  * all of its mirrors should be inside of the safe itself.
  */
 class Safe {
 
 public:
+    /// Maximum number of rows/columns, and of mirrors of each kind, of a Safe
+    static constexpr uint32_t C_MAX_LENGTH = 1000000u;
+    static constexpr std::size_t C_MAX_MIRRORS = 200000u;
+
+    /// Maximum number of rows/columns, and of mirrors of both kinds, of a Safe in large grid mode. The mirrors, the
+    /// laser and the detector are identified on 30 bits by the SafeBreaker.
+    static constexpr uint32_t C_LARGE_MAX_LENGTH = 1u << 31u;
+    static constexpr std::size_t C_LARGE_MAX_MIRRORS = (std::size_t{1} << 30u) - 4u;
+
+    /**
+     * Read-only view of the mirrors of a Safe, stored as a structure of arrays: the i-th mirror is at position
+     * (rows[i], columns[i]) and of kind kinds[i].
+     *
+     * The view is invalidated by any modification of the mirrors of the Safe.
+     */
+    struct MirrorsView {
+        std::span<const uint32_t> rows;  ///< Row position of each mirror
+        std::span<const uint32_t> columns;  ///< Column position of each mirror
+        std::span<const Mirror::emirrorKind> kinds;  ///< Kind of each mirror
+
+        /**
+         * Retrieve the number of mirrors in the view
+         *
+         * @return number of mirrors
+         */
+        [[nodiscard]] std::size_t size() const { return rows.size(); }
+    };
+
     /**
      * Construct a Safe using the number of rows and columns. The list of mirrors is empty.
      *
@@ -28,6 +60,31 @@ public:
      */
     explicit Safe(uint32_t nbRows = 1u, uint32_t nbColumns = 1u);
 
+    /**
+     * Accept grids up to C_LARGE_MAX_LENGTH rows and columns, and up to C_LARGE_MAX_MIRRORS mirrors of both kinds.
+     *
+     * The SafeBreaker never allocates memory per row or column: its time and memory only depend on the number of
+     * mirrors, whatever the size of the grid.
+     *
+     * @param largeGrid: true to accept large grids, false (default) for the limits of the problem
+     */
+    void setLargeGrid(bool largeGrid);
+
+    /**
+     * Check if the Safe accepts large grids.
+     *
+     * @return true in large grid mode
+     */
+    [[nodiscard]] bool largeGrid() const;
+
+    /**
+     * Check the number of mirrors announced for the Safe against the limits of its mode. An error is displayed if the
+     * limits are exceeded, the mirrors are still added.
+     *
+     * @param nbRightLeft, nbLeftRight: number of mirrors of kind / and \
+     */
+    void checkNbMirrors(std::size_t nbRightLeft, std::size_t nbLeftRight) const;
+
     /**
      * Set the number of Rows composing the Safe.
      *
@@ -60,6 +117,13 @@ public:
      */
     void clearMirrors();
 
+    /**
+     * Reserve the memory needed to add mirrors, to avoid reallocations while adding them one by one.
+     *
+     * @param nbMirrors: total number of mirrors expected in the Safe
+     */
+    void reserveMirrors(std::size_t nbMirrors);
+
     /**
      * Creates and add a mirror in the list of mirror only if it is inside the safe.
      *
@@ -68,6 +132,15 @@ public:
      */
     void addMirror(uint32_t row, uint32_t column, Mirror::emirrorKind kind);
 
+    /**
+     * Replace every mirror of the Safe by the given positions, copied in bulk: the first mirrors are of kind /, the
+     * others of kind \ . If a mirror is outside the Safe, the mirrors are added one by one instead, as by addMirror.
+     *
+     * @param rows, columns: position of each mirror, same size
+     * @param nbRightLeft: number of mirrors of kind / at the beginning of the arrays
+     */
+    void assignMirrors(std::span<const uint32_t> rows, std::span<const uint32_t> columns, std::size_t nbRightLeft);
+
     /**
      * Retrieve the number of rows composing the Safe
      *
@@ -83,18 +156,37 @@ public:
     [[nodiscard]] uint32_t columns() const;
 
     /**
-     * Retrieve the list of mirror in the Safe
+     * Retrieve a read-only view of the mirrors in the Safe, in the order they were added. Nothing is copied.
      *
-     * @return list of mirror in the Safe
+     * @return view of the mirrors in the Safe
      */
-    [[nodiscard]] std::list<Mirror> mirrors() const;
+    [[nodiscard]] MirrorsView mirrors() const;
 
 private:
     /// Number of Rows and Columns in the 2D Safe
     uint32_t mRows, mColumns;
 
-    /// List of Mirrors in the Safe.
-    std::list<Mirror> mMirrors;
+    /// Mirrors in the Safe, stored as contiguous arrays of rows, columns and kinds
+    std::vector<uint32_t> mMirrorRows, mMirrorColumns;
+    std::vector<Mirror::emirrorKind> mMirrorKinds;
+
+    /// Biggest row and column of the mirrors, used to avoid checking the mirrors when the Safe is not reduced
+    uint32_t mMaxMirrorRow = 0u, mMaxMirrorColumn = 0u;
+
+    /// Large grid mode, see setLargeGrid
+    bool mLargeGrid = false;
+
+    /**
+     * Check a number of rows or columns against the limits of the mode of the Safe, displaying an error if invalid.
+     *
+     * @param length: number of rows or columns
+     */
+    void checkLength(uint32_t length) const;
+
+    /**
+     * Erase the mirrors that are outside the Safe, in a single pass over the arrays.
+     */
+    void removeOutsideMirrors();
 
 };
 
@@ -5,12 +5,19 @@
 #ifndef SAFEANDMIRRORSPROBLEM_SAFEBREAKER_H
 #define SAFEANDMIRRORSPROBLEM_SAFEBREAKER_H
 
-#include <list>
-#include <vector>
-#include <unordered_map>
-#include <map>
-#include <utility>
+#include <array>
+#include <atomic>
+#include <span>
 #include "Safe.h"
+#include "IntersectionCounter.h"
+#include "MirrorIndex.h"
+#include "MirrorRouter.h"
+#include "Segment.h"
+#include "Arena.h"
+#include "CaseStats.h"
+#include "CandidateIndex.h"
+#include "SolutionEnumerator.h"
+#include "ThreadPool.h"
 
 /**
  * Let any user find the solution, if it exists, to open a given safe.
@@ -20,40 +27,107 @@
 class SafeBreaker {
 
 public:
+    /**
+     * Placement of a mirror to check
+     */
+    struct Candidate {
+        uint32_t row, column;  ///< Position of the mirror
+        Mirror::emirrorKind kind;  ///< Kind of the mirror
+    };
+
+    /**
+     * Definition of all possible answers for a candidate placement.
+     */
+    enum class ecandidate : uint8_t {
+        eCandidateOpens,  ///< The Safe is opened with the mirror
+        eCandidateCloses,  ///< The Safe is not opened with the mirror
+        eCandidateOccupied,  ///< A mirror is already at this position
+        eCandidateOutside  ///< The position is outside of the Safe, or the kind is not a mirror
+    };
+
+    /// Default minimum number of movements of both trajectories for the intersections to be counted by bands of rows
+    static constexpr std::size_t C_PARALLEL_MIN_SEGMENTS = 1u << 16u;
+
+    /// Default minimum number of mirrors for the backward trajectory to be computed by a worker, during the forward
+    /// trajectory
+    static constexpr uint32_t C_PARALLEL_MIN_MIRRORS = 1u << 15u;
+
+    /**
+     * Sizes from which a case takes the paths of big cases. The results do not depend on them: they are only lowered
+     * by tests, so that small cases go through every path.
+     */
+    struct Thresholds {
+        /// Maximum number of vertical movements counted by the kernel instead of the sweep
+        std::size_t kernelMaxVertical = IntersectionCounter::C_KERNEL_MAX_VERTICAL;
+        /// Minimum number of movements for the intersections to be counted by bands of rows, with a pool
+        std::size_t parallelMinSegments = C_PARALLEL_MIN_SEGMENTS;
+        /// Minimum number of mirrors for the backward trajectory to be traced by a worker, with a pool
+        uint32_t parallelMinMirrors = C_PARALLEL_MIN_MIRRORS;
+    };
+
+    /**
+     * Construct a breaker without any Safe. A Safe must be given by reset before solving.
+     */
+    SafeBreaker() = default;
+
     /**
      * Constructor using only a Safe.
      *
      * Forward trajectory initialized with the laser position, backward trajectory with the detector position.
      * Mirrors of the safe are mapped into the columns and the rows.
-     * Maps of segments are empty until trajectories are computed.
+     * Segments are empty until trajectories are computed.
+     *
+     * The Safe is borrowed: its mirrors are read in place, without any copy, and it is not needed after the construction.
      *
      * @param safe: Safe to open.
      */
-    explicit SafeBreaker(Safe safe);
+    explicit SafeBreaker(const Safe &safe);
 
     /**
-     * Compute the solutions to open the Safe, ie where can a mirror be placed to open the Safe.
+     * Prepare the breaker to open a new Safe, forgetting the previous one.
      *
-     * @param[out] nbSolution: number of solution
-     * @param[out] row, column: position of the lexicographically smallest solution
+     * The memory used for the previous Safe is kept: once the breaker has solved a case as big as the new one, solving
+     * does not allocate any memory.
+     *
+     * @param safe: Safe to open, borrowed as in the constructor
      */
-    void solve(int &nbSolution, uint32_t &row, uint32_t &column);
+    void reset(const Safe &safe);
 
-private:
-
-    /// Safe to open
-    const Safe mSafe;
+    /**
+     * Let the breaker split the intersection phase of big cases into bands of rows, executed by the workers of a pool.
+     * The solutions are exactly the same as without pool.
+     *
+     * The breaker executes bands itself while waiting for the workers: it never waits for a busy pool, and can be used
+     * from a task of the same pool.
+     *
+     * @param pool: pool executing the bands, nullptr to count every intersection in the calling thread (default)
+     */
+    void setThreadPool(ThreadPool *pool);
 
-    /// Position of laser and detector
-    std::vector<uint32_t> mLaserPos, mDetectorPos;
+    /**
+     * Override the sizes from which a case takes the paths of big cases (kernel or sweep, bands, concurrent tracing).
+     * Meant for tests: the solutions are exactly the same whatever the thresholds.
+     *
+     * @param thresholds: new thresholds
+     */
+    void setThresholds(const Thresholds &thresholds);
 
-    /// Maps linking non empty rows/columns to the ordered map of mirrors contained in each one of them.
-    /// This helps reducing computing time when looking for the solutions to open the Safe.
-    std::unordered_map<uint32_t, std::map<uint32_t, Mirror>> mMirrorsInColumns, mMirrorsInRows;
+    /**
+     * Compute the solutions to open the Safe, ie where can a mirror be placed to open the Safe.
+     *
+     * @param[out] nbSolution: number of solution
+     * @param[out] row, column: position of the lexicographically smallest solution
+     */
+    void solve(int64_t &nbSolution, uint32_t &row, uint32_t &column);
 
-    /// Maps linking rows and columns numbers to a list of segments defined by their outer points
-    /// and representing the movements during forward and backward trajectory
-    std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>> mForwardRows, mForwardColumns, mBackwardRows, mBackwardColumns;
+    /**
+     * Compute the solutions to open the Safe as solve does, and measure the time and work of each phase.
+     *
+     * @param[out] nbSolution: number of solution
+     * @param[out] row, column: position of the lexicographically smallest solution
+     * @param[out] stats: times and counters of the trajectories and intersections, the other fields are not modified
+     */
+    void solve(int64_t &nbSolution, uint32_t &row, uint32_t &column, CaseStats &stats);
 
     /**
      * Compute the forward and backward trajectories.
@@ -63,43 +137,241 @@ private:
      * computed only if the laser beam does not reached the detector. The backward trajectory is needed to compute all
      * solutions by checking its intersections with the laser beam.
      *
+     * When a pool is given and the Safe has many mirrors, the backward trajectory is computed speculatively by a worker
+     * while the laser beam is computed, and cancelled if the laser beam reaches the detector.
+     *
+     * This is the first phase of solve, it can be called separately to measure it.
+     *
      * @return detectorReached: bool indicating if the laser reach the detector without having to compute a solution.
      */
     [[nodiscard]] bool computeTrajectories();
 
     /**
-     * Compute the full trajectory by computing the next step in the trajectory, ie the closest mirror in the path or the end of the Safe.
+     * Check the number of intersections and their positions between the forward and backward trajectories.
      *
-     * @param[out] rows: map associated to the trajectory linking rows numbers to a list of segments defined by their outer points
-     * @param[out] columns: map associated to the trajectory linking columns numbers to a list of segments defined by their outer points
-     * @param[in out] currentPos: current position
-     * @param[in out] currentDirection: current direction headed to
+     * This is the second phase of solve, when the detector is not reached. It can be called separately to measure it.
+     *
+     * @param[out] nbIntersection: number of intersections
+     * @param[out] row, column: position of the lexicographically smallest solution
      */
-    void trajectoryTracking(std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>>& rows,
-                            std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>>& columns,
-                            std::vector<uint32_t> &currentPos,
-                            Mirror::edirection &currentDirection);
+    void checkIntersections(int64_t& nbIntersection, uint32_t& row, uint32_t& column);
 
     /**
-     * Check the number of intersections and their positions between the forward and backward trajectories.
+     * Check which placements of a single mirror open the Safe.
+     *
+     * Both trajectories are computed once and indexed by cell. A mirror placed on an empty cell only changes a
+     * trajectory from its first passage on the cell. Hence the Safe is opened by a mirror on a cell if:
+     * - the laser beam reaches the detector and does not pass on the cell, or
+     * - the laser beam does not reach the detector, and first reaches the cell in a direction which the mirror reflects
+     * into the reverse of the direction of the backward trajectory when it first reaches the cell, or
+     * - the laser beam reaches the detector and passes on the cell, and once reflected comes back to the cell then
+     * goes on to the detector: either the laser beam also passes on the cell along the reflected direction, or the
+     * line of the cell along the reflected direction is a loop of mirrors (the loops are found once, in O(n)).
+     * Each candidate is answered in O(log n).
+     *
+     * @param[in] candidates: placements to check
+     * @param[out] answers: answer for each candidate, same size as candidates
+     */
+    void checkCandidates(std::span<const Candidate> candidates, std::span<ecandidate> answers);
+
+    /**
+     * Give every solution to open the Safe to a sink, in lexicographic order, with the kind of mirror to place.
+     *
+     * Both trajectories are computed, then their crossings are swept without being stored: the memory only depends on
+     * the number of movements, even when the Safe has billions of solutions. A mirror is placed on a crossing so that it
+     * reflects the laser beam into the reverse of the backward trajectory.
+     *
+     * @param sink: receiver of the solutions
+     * @return number of solutions, the same as given by solve, 0 if the laser already reaches the detector
+     */
+    uint64_t enumerateSolutions(const SolutionEnumerator::Sink &sink);
+
+    /**
+     * Analysis mode: find the minimum number of mirrors to add to open the Safe, and one placement of these mirrors.
+     *
+     * Computed by a 0-1 shortest path over the pieces of rows and columns between the mirrors (see MirrorRouter): the
+     * time and memory only depend on the number of mirrors, not on the size of the Safe.
+     *
+     * @param[out] placements: mirrors to add, in the order the laser beam reaches them
+     * @return minimum number of mirrors, 0 if the laser already reaches the detector, -1 if the Safe can not be opened
+     */
+    int64_t minimumMirrors(std::vector<MirrorRouter::Placement> &placements);
+
+private:
+
+    /**
+     * Segments of a trajectory, stored in a single buffer taken from the arena: horizontal movements from the beginning
+     * of the buffer, vertical movements from its end.
+     */
+    struct Trajectory {
+        std::span<Segment> buffer;  ///< Buffer big enough for every movement of the trajectory
+        std::size_t nbHorizontal = 0u, nbVertical = 0u;  ///< Number of movements along the rows and the columns
+
+        /// Movements along the rows
+        [[nodiscard]] std::span<const Segment> horizontal() const { return buffer.first(nbHorizontal); }
+
+        /// Movements along the columns
+        [[nodiscard]] std::span<const Segment> vertical() const { return buffer.last(nbVertical); }
+    };
+
+    /// Number of rows and columns of the Safe to open
+    uint32_t mRows = 1u, mColumns = 1u;
+
+    /// Position of laser and detector
+    std::array<uint32_t, 2> mLaserPos{}, mDetectorPos{};
+
+    /// Index of the mirrors sorted by rows and by columns, linking each mirror to the closest one in each direction.
+    /// This helps reducing computing time when looking for the solutions to open the Safe.
+    MirrorIndex mMirrorIndex;
+
+    /// Memory of the segments, kept between cases
+    Arena mArena;
+
+    /// Segments defined by their outer points and representing the movements during forward and backward trajectory
+    Trajectory mForward, mBackward;
+
+    /// Sweep-line engine used to count the intersections between the trajectories
+    IntersectionCounter mIntersectionCounter;
+
+    /**
+     * Band of rows of one pair of trajectories, counted independently
+     */
+    struct Band {
+        uint32_t pair;  ///< 0: forward rows with backward columns, 1: backward rows with forward columns
+        uint32_t rowBegin, rowEnd;  ///< Rows of the band [rowBegin, rowEnd)
+        int64_t nbIntersection;  ///< Number of intersections in the band
+        uint32_t row, column;  ///< Closest intersection in the band
+    };
+
+    /**
+     * Progress of the bands of a case, shared with the workers: a worker starting after the end of the case only reads
+     * it and finds no band left.
+     */
+    struct BandProgress {
+        std::atomic<uint32_t> next{0u};  ///< Next band to execute
+        std::atomic<uint32_t> finished{0u};  ///< Number of executed bands
+    };
+
+    /// Number of pairs of movements (along a row, then a column) between two checks of the cancellation of a trajectory
+    static constexpr uint32_t C_CANCEL_INTERVAL = 1u << 12u;
+
+    /**
+     * Progress of a backward trajectory computed speculatively, shared with the worker: a worker starting after the end
+     * of the case only reads it and finds the trajectory already claimed.
+     */
+    struct TraceProgress {
+        std::atomic<bool> claimed{false};  ///< The trajectory is computed, by the worker or by the breaker
+        std::atomic<bool> cancelled{false};  ///< The laser beam has reached the detector, the trajectory is not needed
+        std::atomic<bool> finished{false};  ///< The worker has stopped computing the trajectory
+        uint64_t backwardNs = 0u;  ///< Time taken by the worker, read once finished
+    };
+
+    /// Pool executing the bands and the backward trajectories, nullptr to compute in the calling thread
+    ThreadPool *mPool = nullptr;
+
+    /// Sizes from which a case takes the paths of big cases
+    Thresholds mThresholds;
+
+    /// Bands of the current case and the sweep-line engine of each band
+    std::vector<Band> mBands;
+    std::vector<IntersectionCounter> mBandCounters;
+    /// Cells passed by each trajectory, and states of the mirror index looping forever (see MirrorIndex::findLoops),
+    /// built only to check candidates
+    CandidateIndex mForwardCells, mBackwardCells;
+    std::vector<uint8_t> mLoopingStates;
+    /// Sweep-line engine used to enumerate the solutions
+    SolutionEnumerator mSolutionEnumerator;
+    /// Shortest path engine used to find the minimum number of mirrors
+    MirrorRouter mMirrorRouter;
+    /// Direction of the movements of each trajectory, horizontal ones then vertical ones in the order of the buffer,
+    /// computed only to enumerate the solutions
+    std::vector<Mirror::edirection> mForwardDirections, mBackwardDirections;
+
+    /**
+     * Check if a beam leaving a cell goes round a loop of mirrors, coming back to the cell without leaving the Safe
+     *
+     * @param row, column: position of the cell, without mirror
+     * @param direction: direction of the beam leaving the cell
+     * @return true if the beam loops
+     */
+    bool loops(uint32_t row, uint32_t column, Mirror::edirection direction);
+
+    /**
+     * Compute the full trajectory by following the links of the mirror index, from mirror to mirror, until the end of
+     * the Safe.
+     *
+     * @param[out] trajectory: segments of the trajectory, the buffer must already be taken from the arena
+     * @param[in] currentMirror: identifier in the index of the starting mirror (the laser or the detector)
+     * @param[in] currentDirection: starting direction, along a row
+     * @param[in] cancelled: flag stopping the trajectory early when set, checked regularly, nullptr if never cancelled
+     * @return position where the trajectory has stopped
+     */
+    std::array<uint32_t, 2> trajectoryTracking(Trajectory &trajectory, uint32_t currentMirror,
+                                               Mirror::edirection currentDirection,
+                                               const std::atomic<bool> *cancelled = nullptr);
+
+    /**
+     * Move from a mirror to the next one in the path, or to the end of the Safe, and add the movement to the
+     * trajectory.
+     * Specialised for each axis: the inner loop of trajectoryTracking does not test the axis of the movement.
+     *
+     * @param[in out] trajectory: trajectory receiving the movement
+     * @param[in out] state: state of the beam in the mirror index, leaving a mirror, then leaving the mirror reached
+     * @param[out] endPos: position where the trajectory has stopped, set only at its end
+     * @return false if the trajectory is over: no more mirror in the path, or the laser or detector is reached
+     */
+    template<bool AlongRow>
+    bool move(Trajectory &trajectory, uint32_t &state, std::array<uint32_t, 2> &endPos) const;
+
+    /**
+     * Implementation of solve, statistics are gathered only when asked at compile time: solving without statistics
+     * does not read any clock.
+     *
+     * @param[out] nbSolution, row, column: as solve
+     * @param[out] stats: statistics, used only if WithStats
+     */
+    template<bool WithStats>
+    void solveCase(int64_t &nbSolution, uint32_t &row, uint32_t &column, CaseStats *stats);
+
+    /**
+     * Implementation of computeTrajectories, timing each trajectory if WithStats.
+     *
+     * @param[out] stats: statistics, used only if WithStats
+     * @return detectorReached: as computeTrajectories
+     */
+    template<bool WithStats>
+    bool traceTrajectories(CaseStats *stats);
+
+    /**
+     * Implementation of computeTrajectories computing the backward trajectory by a worker of the pool during the
+     * forward trajectory. If no worker has started it when the laser beam is computed, the breaker computes it itself.
+     *
+     * @param[out] stats: statistics, used only if WithStats
+     * @return detectorReached: as computeTrajectories
+     */
+    template<bool WithStats>
+    bool traceTrajectoriesConcurrently(CaseStats *stats);
+
+    /**
+     * Count the intersections as checkIntersections, by bands of rows executed concurrently by the workers of the pool
+     * and by the calling thread. Each band has its own count and closest intersection, merged at the end.
      *
      * @param[out] nbIntersection: number of intersections
      * @param[out] row, column: position of the lexicographically smallest solution
      */
-    void checkIntersections(int& nbIntersection, uint32_t& row, uint32_t& column) const;
+    void checkIntersectionsByBands(int64_t &nbIntersection, uint32_t &row, uint32_t &column);
 
     /**
-     * Compute the number of intersection between a map containing the movements along the rows and a map containing
-     * the movements along the columns.
+     * Compute the direction of each movement of a trajectory starting along a row, deduced from the starting position as
+     * the movements along the rows and the columns alternate.
      *
-     * @param[in] rowsMap: map linking rows numbers to a list of segments defined by their outer points
-     * @param[in] columnsMap: map linking columns numbers to a list of segments defined by their outer points
-     * @param[out] nbIntersection: incremented total number of intersection
-     * @param[out] closestIntersection: position of the closest intersection
+     * @param[in] trajectory: movements of the trajectory
+     * @param[in] start: starting position of the trajectory
+     * @param[out] directions: directions of the horizontal movements, followed by the ones of the vertical movements in
+     * the order of the buffer
      */
-    static void getIntersection(const std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>> &rowsMap,
-                                const std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>> &columnsMap,
-                                int &nbIntersection, std::vector<uint32_t*> &closestIntersection);
+    static void movementDirections(const Trajectory &trajectory, std::array<uint32_t, 2> start,
+                                   std::vector<Mirror::edirection> &directions);
 
 };
 
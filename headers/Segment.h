@@ -0,0 +1,23 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_SEGMENT_H
+#define SAFEANDMIRRORSPROBLEM_SEGMENT_H
+
+#include <cstdint>
+
+/**
+ * Movement of a light beam along a single row or a single column, defined by its outer points.
+ *
+ * For a movement along a row, fixed is the row number and lo, hi are the columns of the outer points.
+ * For a movement along a column, fixed is the column number and lo, hi are the rows of the outer points.
+ */
+struct Segment {
+    uint32_t fixed;  ///< Row (horizontal movement) or column (vertical movement) of the segment
+    uint32_t lo;  ///< Smallest outer point of the movement
+    uint32_t hi;  ///< Biggest outer point of the movement
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_SEGMENT_H
@@ -0,0 +1,81 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_SOLUTIONENUMERATOR_H
+#define SAFEANDMIRRORSPROBLEM_SOLUTIONENUMERATOR_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include "Mirror.h"
+#include "Segment.h"
+#include "ColumnTree.h"
+
+/**
+ * Sweep-line engine enumerating every crossing between the forward and backward trajectories, ie every solution, in
+ * lexicographic order (row then column), with the kind of mirror to place.
+ *
+ * Both pairs of movements (forward rows with backward columns, backward rows with forward columns) are swept together.
+ * In a row, the crossings of each pair are produced in ascending column order straight from their Fenwick tree and the
+ * two streams are merged: solutions are given to the sink as they are found, and the memory only depends on the number
+ * of movements, not on the number of solutions.
+ */
+class SolutionEnumerator {
+
+public:
+
+    /**
+     * Receiver of the solutions: position of the cell and kind of mirror to place on it
+     */
+    using Sink = std::function<void(uint32_t row, uint32_t column, Mirror::emirrorKind kind)>;
+
+    /**
+     * Movements of a trajectory with their directions
+     */
+    struct Movements {
+        std::span<const Segment> horizontal;  ///< Movements along the rows
+        std::span<const Mirror::edirection> horizontalDirections;  ///< Direction of each movement along the rows
+        std::span<const Segment> vertical;  ///< Movements along the columns
+        std::span<const Mirror::edirection> verticalDirections;  ///< Direction of each movement along the columns
+    };
+
+    /**
+     * Give every crossing between two trajectories to a sink, in lexicographic order.
+     *
+     * @param forward: movements of the laser beam
+     * @param backward: movements of the beam from the detector
+     * @param sink: receiver of the solutions
+     * @return number of solutions, the same as counted by the IntersectionCounter
+     */
+    uint64_t enumerate(const Movements &forward, const Movements &backward, const Sink &sink);
+
+private:
+
+    /**
+     * Event of the sweep, ordered by row. At a given row, updates of the trees are done before the queries, and
+     * queries of each pair are ordered by column.
+     */
+    struct Event {
+        uint32_t row;  ///< Row where the event happens
+        uint32_t kind;  ///< 0: add a vertical movement, 1: remove a vertical movement, 2: query a horizontal movement
+        uint32_t pair;  ///< 0: forward rows with backward columns, 1: backward rows with forward columns
+        uint32_t lo;  ///< Smallest column of a queried horizontal movement, 0 otherwise
+        uint32_t index;  ///< Index of the associated movement
+    };
+
+    /// Active vertical movements in each column, for each pair
+    std::array<ColumnTree, 2> mTrees;
+
+    /// Direction of the active vertical movement of each compressed column, for each pair
+    std::array<std::vector<Mirror::edirection>, 2> mActiveDirections;
+
+    /// Events of the sweep
+    std::vector<Event> mEvents;
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_SOLUTIONENUMERATOR_H
@@ -0,0 +1,118 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_SOLVERDAEMON_H
+#define SAFEANDMIRRORSPROBLEM_SOLVERDAEMON_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "CaseReader.h"
+#include "ResultCache.h"
+#include "SafeBreaker.h"
+#include "ThreadPool.h"
+
+/**
+ * Long-running solver answering the cases sent on a local Unix socket, or on the standard input.
+ *
+ * Each connection sends cases in the format of the input file (text or binary) and receives one "Case N: ..." line per
+ * case, numbered from 0 on each connection, as soon as the case is solved. Results are sent before waiting for the
+ * next case: a client can send a case, read its result, then send the next one. Connections are served concurrently.
+ *
+ * The workers, the breakers and their buffers, and the cache of results are kept from connection to connection: a
+ * small Safe is solved without starting a process or allocating memory again.
+ */
+class SolverDaemon {
+
+public:
+
+    /**
+     * Construct the daemon and start its workers.
+     *
+     * @param nbThreads: number of workers splitting the big cases, 0 to use one worker per core
+     */
+    explicit SolverDaemon(uint32_t nbThreads = 0u);
+
+    /**
+     * Keep the results of the solved Safes, shared by every connection.
+     *
+     * @param capacity: maximum number of Safes kept, 0 to disable the cache (default)
+     */
+    void setCache(std::size_t capacity);
+
+    /**
+     * Accept large grids on every connection, see Safe::setLargeGrid.
+     *
+     * @param largeGrid: true to accept large grids
+     */
+    void setLargeGrid(bool largeGrid);
+
+    /**
+     * Listen on a Unix socket and serve each connection until the daemon is stopped. A socket left by a previous daemon
+     * is replaced, any other file is kept.
+     *
+     * @param socketPath: path of the socket
+     * @return false, once the socket can not be created or accept connections (error displayed)
+     */
+    bool serve(const std::string &socketPath);
+
+    /**
+     * Serve the cases of a stream until its end.
+     *
+     * @param input: descriptor of the cases
+     * @param output: descriptor receiving the results, can be the same as the input
+     */
+    void serveStream(int input, int output);
+
+private:
+
+    /// Size of the buffered results triggering a send, even if the next case has been received
+    static constexpr std::size_t C_SEND_BYTES = 1u << 16u;
+
+    /// Workers splitting the big cases of every connection
+    ThreadPool mPool;
+
+    /// Breakers not used by a connection, reused with their buffers
+    std::mutex mBreakersMutex;
+    std::vector<std::unique_ptr<SafeBreaker>> mBreakers;
+
+    /// Results of the Safes already solved
+    ResultCache mCache;
+
+    /// The Safes of every connection accept large grids
+    bool mLargeGrid = false;
+
+    /// Number of connections being served
+    std::atomic<uint32_t> mNbConnections{0u};
+
+    /**
+     * Take a breaker not used by any connection, or create one.
+     *
+     * @return breaker using the workers of the daemon
+     */
+    std::unique_ptr<SafeBreaker> takeBreaker();
+
+    /**
+     * Give back a breaker at the end of a connection.
+     *
+     * @param breaker: breaker to reuse
+     */
+    void releaseBreaker(std::unique_ptr<SafeBreaker> breaker);
+
+    /**
+     * Write the whole content on a descriptor.
+     *
+     * @param output: descriptor to write
+     * @param content: content to write
+     * @return false if the descriptor has been closed by the client
+     */
+    static bool send(int output, const std::string &content);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_SOLVERDAEMON_H
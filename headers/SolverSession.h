@@ -0,0 +1,231 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_SOLVERSESSION_H
+#define SAFEANDMIRRORSPROBLEM_SOLVERSESSION_H
+
+#include <array>
+#include <map>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+#include "Safe.h"
+#include "Mirror.h"
+#include "Segment.h"
+#include "ColumnTree.h"
+
+/**
+ * Long-lived session over a Safe, solving it again after each insertion or removal of a mirror.
+ *
+ * The mirrors are kept in ordered maps per row and per column, updated in place. Both trajectories are kept with their
+ * movements sorted by row and by column: a changed cell is found in the trajectories directly, and only the part of a
+ * trajectory after its first passage on the cell is traced again.
+ *
+ * The crossings between the trajectories are kept by row. When a part of a trajectory is traced again, the crossings of
+ * its removed movements and of its new movements with the other trajectory are subtracted and added, looking only at
+ * the movements of the other trajectory in the rows or columns they span: a change costs about the changed path, and a
+ * query only searches the closest crossing in the first row having crossings. When the changed path crosses too much
+ * of the other trajectory, the crossings are counted again at the next query with a sweep-line, as SafeBreaker does.
+ */
+class SolverSession {
+
+public:
+
+    /**
+     * Start a session from a Safe: its size and its mirrors are copied, the Safe is not needed afterwards.
+     * When several mirrors share a position, the last one is kept.
+     *
+     * @param safe: initial Safe
+     */
+    explicit SolverSession(const Safe &safe);
+
+    /**
+     * Add a mirror in the Safe, replacing the mirror already at this position if any.
+     *
+     * @param row, column: position of the mirror, inside the Safe
+     * @param kind: kind of the mirror, eKindRightLeft or eKindLeftRight
+     * @return true if the Safe has changed, false if the mirror is outside the Safe or already present
+     */
+    bool addMirror(uint32_t row, uint32_t column, Mirror::emirrorKind kind);
+
+    /**
+     * Remove the mirror at a position.
+     *
+     * @param row, column: position of the mirror
+     * @return true if a mirror has been removed
+     */
+    bool removeMirror(uint32_t row, uint32_t column);
+
+    /**
+     * Compute the solutions to open the current Safe, with the same results as SafeBreaker::solve.
+     *
+     * @param[out] nbSolution: number of solution, 0 if the Safe is opened, -1 if impossible
+     * @param[out] row, column: position of the lexicographically smallest solution
+     */
+    void query(int64_t &nbSolution, uint32_t &row, uint32_t &column);
+
+private:
+
+    /// Fraction of the movements of both trajectories that a change may look at in the other trajectory, beyond which
+    /// counting every crossing again is cheaper, and work always allowed to a change whatever the trajectories
+    static constexpr std::size_t C_MAX_WORK_FRACTION = 8u;
+    static constexpr std::size_t C_MIN_MAX_WORK = 1u << 10u;
+
+    /**
+     * Trajectory of a beam, as the ordered list of its movements. Each movement is indexed by the row (horizontal
+     * movement) or the column (vertical movement) it is in.
+     */
+    struct Trajectory {
+        /// Row or column of each movement along it with the index of the movement, sorted: the movements of a row or
+        /// of a column are contiguous and in ascending order
+        using Lines = std::vector<std::pair<uint32_t, uint32_t>>;
+
+        std::vector<Segment> segments;  ///< Movements in the order of the trajectory
+        std::vector<Mirror::edirection> directions;  ///< Direction of each movement
+        std::array<uint32_t, 2> end{};  ///< Position where the trajectory stops, outside of the Safe
+        Lines rowSegments, columnSegments;  ///< Movements along the rows and along the columns
+    };
+    /// Number of rows and columns of the Safe
+    uint32_t mRows, mColumns;
+
+    /// Position of laser and detector
+    std::array<uint32_t, 2> mLaserPos{}, mDetectorPos{};
+
+    /// Maps linking non empty rows/columns to the ordered map of the kinds of their mirrors
+    std::unordered_map<uint32_t, std::map<uint32_t, Mirror::emirrorKind>> mMirrorsInRows, mMirrorsInColumns;
+
+    /// Trajectories from the laser and from the detector
+    Trajectory mForward, mBackward;
+
+    /// Number of crossings between the trajectories, in total and in each row having crossings
+    int64_t mNbCrossings = 0;
+    std::map<uint32_t, int64_t> mRowCrossings;
+
+    /// The crossings are counted again at the next query, instead of being updated
+    bool mRecount = true;
+
+    /// Rows and columns of the other trajectory looked at since the start of the current change
+    std::size_t mWork = 0u;
+
+    /// Movements sorted by row or by column being merged with new movements, swapped with the merged ones, and count
+    /// of each digit of the radix sort of the new movements
+    Trajectory::Lines mMergedLines;
+    std::vector<uint32_t> mHistogram;
+
+    /**
+     * Event of the sweep counting the crossings again, ordered by row. At a given row, updates of the tree are done
+     * before the queries.
+     */
+    struct Event {
+        uint32_t row;  ///< Row where the event happens
+        uint32_t kind;  ///< 0: add a vertical movement, 1: remove a vertical movement, 2: query a horizontal movement
+        uint32_t index;  ///< Index of the associated movement
+    };
+
+    /// Movements along the rows and along the columns of both trajectories, the events of the sweep and its active
+    /// vertical movements in each column, only used to count the crossings again
+    std::vector<Segment> mForwardRows, mForwardColumns, mBackwardRows, mBackwardColumns;
+    std::vector<Event> mEvents;
+    ColumnTree mTree;
+
+    /**
+     * Follow a beam from a position and a direction until it leaves the Safe, appending its movements to a trajectory.
+     *
+     * @param trajectory: trajectory to complete
+     * @param position: starting position
+     * @param direction: starting direction
+     */
+    void trace(Trajectory &trajectory, std::array<uint32_t, 2> position, Mirror::edirection direction);
+
+    /**
+     * Add the last movements of a trajectory, once traced, in its movements sorted by row and by column
+     *
+     * @param trajectory: trajectory to update
+     * @param first: index of the first movement to add, the following ones up to the end of the trajectory being added
+     */
+    void index(Trajectory &trajectory, uint32_t first);
+
+    /**
+     * Sort the last movements of a list by row or by column, keeping their order within a row or a column, using a
+     * least significant digit radix sort when they are numerous
+     *
+     * @param lines: movements, only the last ones being sorted
+     * @param first: position of the first movement to sort in the list
+     */
+    void sortLines(Trajectory::Lines &lines, std::size_t first);
+
+    /**
+     * Retrieve the movements of a trajectory in a range of rows or of columns
+     *
+     * @param lines: movements sorted by row or by column
+     * @param lo, hi: first and last row or column of the range, included
+     * @return first and past-the-end movements of the range
+     */
+    static std::pair<Trajectory::Lines::const_iterator, Trajectory::Lines::const_iterator>
+    linesBetween(const Trajectory::Lines &lines, uint32_t lo, uint32_t hi);
+
+    /**
+     * Trace a trajectory again from its first movement passing on a cell, if any, and update its crossings with the
+     * other trajectory. Nothing is done if the trajectory does not pass on the cell.
+     *
+     * @param trajectory: trajectory to update
+     * @param other: other trajectory, unchanged
+     * @param row, column: changed cell
+     */
+    void retrace(Trajectory &trajectory, const Trajectory &other, uint32_t row, uint32_t column);
+
+    /**
+     * Add or subtract the crossings of the last movements of a trajectory with the other trajectory. Once the work of
+     * the current change exceeds a fraction of the size of both trajectories, the crossings are left to be counted
+     * again instead.
+     *
+     * @param trajectory: trajectory of the movements
+     * @param other: other trajectory
+     * @param first: index of the first movement, the following ones up to the end of the trajectory being included
+     * @param sign: 1 to add the crossings, -1 to subtract them
+     */
+    void updateCrossings(const Trajectory &trajectory, const Trajectory &other, uint32_t first, int64_t sign);
+
+    /**
+     * Add a number of crossings in a row
+     *
+     * @param row: row of the crossings
+     * @param nbCrossings: number of crossings to add, negative to subtract
+     */
+    void addCrossings(uint32_t row, int64_t nbCrossings);
+
+    /**
+     * Count every crossing between the trajectories again, by row, with a sweep-line over the rows.
+     */
+    void recount();
+
+    /**
+     * Count the crossings of horizontal movements with vertical movements, by row.
+     *
+     * @param horizontal: movements along the rows
+     * @param vertical: movements along the columns
+     */
+    void countRows(const std::vector<Segment> &horizontal, const std::vector<Segment> &vertical);
+
+    /**
+     * Retrieve the smallest column of a crossing in a row
+     *
+     * @param row: row having crossings
+     * @return smallest column of a crossing of the row
+     */
+    [[nodiscard]] uint32_t closestColumn(uint32_t row) const;
+
+    /**
+     * Retrieve the starting position of a movement of a trajectory
+     *
+     * @param trajectory: trajectory of the movement
+     * @param index: index of the movement
+     * @return starting position
+     */
+    static std::array<uint32_t, 2> startOf(const Trajectory &trajectory, uint32_t index);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_SOLVERSESSION_H
@@ -0,0 +1,84 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_STATSWRITER_H
+#define SAFEANDMIRRORSPROBLEM_STATSWRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "CaseStats.h"
+
+/**
+ * Sink saving the statistics of the cases as JSON Lines.
+ *
+ * One object is written per case, for instance {"case":0,"parse_ns":1200,...}, then a last object aggregating every
+ * case when the file is closed: {"aggregate":{"cases":N,"total":{...},"max":{...}}}.
+ */
+class StatsWriter {
+
+public:
+
+    /**
+     * Construct a writer without file: statistics are ignored until a file is opened.
+     */
+    StatsWriter() = default;
+
+    /**
+     * Write the aggregated statistics and close the file.
+     */
+    ~StatsWriter();
+
+    /**
+     * Open (create or clear) the statistics file.
+     *
+     * @param fileName: name of the statistics file
+     * @return true if the file has been opened
+     */
+    bool open(const std::string &fileName);
+
+    /**
+     * Check if statistics are saved
+     *
+     * @return true if a statistics file is opened
+     */
+    [[nodiscard]] bool isOpen() const;
+
+    /**
+     * Save the statistics of a case and add them to the aggregated statistics.
+     *
+     * @param caseId: number of the case
+     * @param stats: statistics of the case
+     */
+    void write(uint32_t caseId, const CaseStats &stats);
+
+    /**
+     * Write the aggregated statistics and close the file. Nothing is done if no file is opened.
+     */
+    void close();
+
+private:
+
+    /// Statistics file
+    std::ofstream mFile;
+
+    /// Line being written, reused for every case
+    std::string mLine;
+
+    /// Number of cases, sum and maximum of each statistic
+    uint32_t mNbCases = 0u;
+    CaseStats mTotal, mMax;
+
+    /**
+     * Append the fields of statistics to a JSON object, without braces.
+     *
+     * @param text: JSON text to append to
+     * @param stats: statistics to append
+     */
+    static void appendFields(std::string &text, const CaseStats &stats);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_STATSWRITER_H
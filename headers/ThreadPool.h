@@ -0,0 +1,120 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_THREADPOOL_H
+#define SAFEANDMIRRORSPROBLEM_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Pool of worker threads executing independent tasks, using work-stealing.
+ *
+ * Each worker owns a queue of tasks. A worker executes the most recent task of its own queue first and, when its queue
+ * is empty, steals the oldest task of another worker. Tasks submitted from outside the pool are distributed over the
+ * queues in turn, tasks submitted by a worker are pushed in its own queue.
+ */
+class ThreadPool {
+
+public:
+
+    /**
+     * Construct the pool and start its workers.
+     *
+     * @param nbThreads: number of workers, 0 to use one worker per core
+     */
+    explicit ThreadPool(uint32_t nbThreads = 0u);
+
+    /**
+     * Execute the remaining tasks, then stop and join the workers.
+     */
+    ~ThreadPool();
+
+    /// Workers are owned by the pool: no copy
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Submit a task to be executed by a worker.
+     *
+     * @param task: task to execute
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * Retrieve the number of workers of the pool
+     *
+     * @return number of workers
+     */
+    [[nodiscard]] uint32_t size() const;
+
+    /**
+     * Retrieve the index of the worker executing the calling code.
+     *
+     * @return index of the worker in its pool, size() of the pool if not called from a worker
+     */
+    [[nodiscard]] uint32_t workerIndex() const;
+
+    /**
+     * Retrieve the number of workers to use for a requested number of threads.
+     *
+     * @param nbThreads: requested number of threads, 0 for one per core
+     * @return number of workers, at least one (1)
+     */
+    [[nodiscard]] static uint32_t resolveThreads(uint32_t nbThreads);
+
+private:
+
+    /**
+     * Queue of tasks owned by a worker
+     */
+    struct Queue {
+        std::mutex mutex;  ///< Protects the tasks
+        std::deque<std::function<void()>> tasks;  ///< Tasks waiting to be executed
+    };
+
+    /// Queues of the workers, one per worker
+    std::vector<std::unique_ptr<Queue>> mQueues;
+
+    /// Workers
+    std::vector<std::thread> mWorkers;
+
+    /// Number of tasks submitted and not yet taken by a worker
+    std::atomic<uint32_t> mNbPending{0u};
+
+    /// Next queue receiving a task submitted from outside the pool
+    std::atomic<uint32_t> mNextQueue{0u};
+
+    /// Sleeping workers wait for new tasks or the stop of the pool
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCondition;
+    bool mStop = false;
+
+    /**
+     * Main loop of a worker: execute tasks until the pool is stopped and no task is left.
+     *
+     * @param index: index of the worker
+     */
+    void work(uint32_t index);
+
+    /**
+     * Take a task, from the own queue of a worker first then from the other queues.
+     *
+     * @param[in] index: index of the worker
+     * @param[out] task: task taken
+     * @return true if a task has been taken
+     */
+    bool takeTask(uint32_t index, std::function<void()> &task);
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_THREADPOOL_H
@@ -0,0 +1,126 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+/// Replacements of the global allocation functions, counting every allocation of the program when asked. Only linked
+/// in the program, and only where the allocator gives the size of a block (malloc_usable_size): without them,
+/// AllocationTracker::installed() is false and nothing is counted.
+#ifdef SAFEANDMIRRORS_HAVE_MALLOC_USABLE_SIZE
+
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+#include "../headers/AllocationTracker.h"
+
+namespace {
+
+    /**
+     * Allocate a block as the standard operator new: retry through the new handler, throw if none.
+     *
+     * @param size: size of the block
+     * @param alignment: alignment of the block, 0 for the default alignment
+     * @return allocated block
+     */
+    void *allocate(std::size_t size, const std::size_t alignment) {
+        if (size == 0u) size = 1u;
+        for (;;) {
+            void *block = alignment == 0u ? std::malloc(size) :
+                          std::aligned_alloc(alignment, (size + alignment - 1u) / alignment * alignment);
+            if (block != nullptr) {
+                if (AllocationTracker::enabled()) AllocationTracker::allocated(malloc_usable_size(block));
+                return block;
+            }
+            const std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    /**
+     * Free a block allocated by allocate
+     *
+     * @param block: block to free, can be nullptr
+     */
+    void deallocate(void *block) noexcept {
+        if (block == nullptr) return;
+        if (AllocationTracker::enabled()) AllocationTracker::freed(malloc_usable_size(block));
+        std::free(block);
+    }
+
+    /// The operators are known to the tracker before main starts
+    [[maybe_unused]] const bool C_INSTALLED = (AllocationTracker::setInstalled(), true);
+}
+
+void *operator new(const std::size_t size) {
+    return allocate(size, 0u);
+}
+
+void *operator new[](const std::size_t size) {
+    return allocate(size, 0u);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size, 0u);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](const std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size, 0u);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *block) noexcept {
+    deallocate(block);
+}
+
+void operator delete[](void *block) noexcept {
+    deallocate(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept {
+    deallocate(block);
+}
+
+void operator delete[](void *block, std::size_t) noexcept {
+    deallocate(block);
+}
+
+void operator delete(void *block, std::align_val_t) noexcept {
+    deallocate(block);
+}
+
+void operator delete[](void *block, std::align_val_t) noexcept {
+    deallocate(block);
+}
+
+void operator delete(void *block, std::size_t, std::align_val_t) noexcept {
+    deallocate(block);
+}
+
+void operator delete[](void *block, std::size_t, std::align_val_t) noexcept {
+    deallocate(block);
+}
+
+void operator delete(void *block, const std::nothrow_t &) noexcept {
+    deallocate(block);
+}
+
+void operator delete[](void *block, const std::nothrow_t &) noexcept {
+    deallocate(block);
+}
+
+#endif
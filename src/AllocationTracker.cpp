@@ -0,0 +1,95 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <atomic>
+#include "../headers/AllocationTracker.h"
+
+namespace {
+
+    /// The global operators new and delete are replaced, and the allocations are counted
+    std::atomic<bool> operatorsInstalled{false}, accountingEnabled{false};
+
+    /// Phase of the allocations, shared by every thread
+    std::atomic<AllocationTracker::ephase> currentPhase{AllocationTracker::ephase::ePhaseOther};
+
+    /// Live bytes since the accounting started, and their peak since the start of the case. Signed: blocks allocated
+    /// before the accounting started are subtracted when freed.
+    std::atomic<int64_t> liveBytes{0}, peakBytes{0}, startBytes{0};
+
+    /// Allocations and bytes of each phase since the start of the case
+    std::array<std::atomic<uint64_t>, AllocationTracker::C_NB_PHASES> phaseAllocations{}, phaseBytes{};
+}
+
+AllocationTracker::Scope::Scope(const ephase phase) :
+        mPrevious(currentPhase.exchange(phase, std::memory_order_relaxed)) {}
+
+AllocationTracker::Scope::~Scope() {
+    currentPhase.store(mPrevious, std::memory_order_relaxed);
+}
+
+AllocationTracker::ephase AllocationTracker::Usage::heaviestPhase() const {
+    std::size_t heaviest = static_cast<std::size_t>(ephase::ePhaseOther);
+    for (std::size_t phase = 0u; phase < C_NB_PHASES; ++phase)
+        if (phases[phase].bytes > phases[heaviest].bytes) heaviest = phase;
+    return static_cast<ephase>(heaviest);
+}
+
+void AllocationTracker::setInstalled() {
+    operatorsInstalled.store(true, std::memory_order_relaxed);
+}
+
+bool AllocationTracker::installed() {
+    return operatorsInstalled.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::setEnabled(const bool enabled) {
+    accountingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool AllocationTracker::enabled() {
+    return accountingEnabled.load(std::memory_order_relaxed);
+}
+
+void AllocationTracker::startCase() {
+    for (std::size_t phase = 0u; phase < C_NB_PHASES; ++phase) {
+        phaseAllocations[phase].store(0u, std::memory_order_relaxed);
+        phaseBytes[phase].store(0u, std::memory_order_relaxed);
+    }
+    const int64_t live = liveBytes.load(std::memory_order_relaxed);
+    startBytes.store(live, std::memory_order_relaxed);
+    peakBytes.store(live, std::memory_order_relaxed);
+}
+
+AllocationTracker::Usage AllocationTracker::usage() {
+    Usage usage;
+    for (std::size_t phase = 0u; phase < C_NB_PHASES; ++phase) {
+        usage.phases[phase].allocations = phaseAllocations[phase].load(std::memory_order_relaxed);
+        usage.phases[phase].bytes = phaseBytes[phase].load(std::memory_order_relaxed);
+    }
+    usage.startBytes = static_cast<uint64_t>(std::max<int64_t>(startBytes.load(std::memory_order_relaxed), 0));
+    usage.peakBytes = static_cast<uint64_t>(std::max<int64_t>(peakBytes.load(std::memory_order_relaxed), 0));
+    return usage;
+}
+
+const char *AllocationTracker::phaseName(const ephase phase) {
+    static const char *const names[C_NB_PHASES] = {"parse", "safe", "index", "segments", "intersection", "other"};
+    return names[static_cast<std::size_t>(phase)];
+}
+
+void AllocationTracker::allocated(const std::size_t bytes) {
+    const auto phase = static_cast<std::size_t>(currentPhase.load(std::memory_order_relaxed));
+    phaseAllocations[phase].fetch_add(1u, std::memory_order_relaxed);
+    phaseBytes[phase].fetch_add(bytes, std::memory_order_relaxed);
+
+    /// Raise the peak if no other thread raised it higher
+    const int64_t live = liveBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) +
+                         static_cast<int64_t>(bytes);
+    int64_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+void AllocationTracker::freed(const std::size_t bytes) {
+    liveBytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
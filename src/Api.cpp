@@ -4,144 +4,229 @@
 
 #include "../headers/Api.h"
 
+/// Time interval between two checks of the flush of the output file while waiting for a case
+const std::chrono::milliseconds C_WAIT_INTERVAL{50};
+
 Api::Api(std::string inputFileName, std::string  outputFileName):
     mInputFileName(std::move(inputFileName)), mOutputFileName(std::move(outputFileName)){
 
     /// Number of case start from 0
     mNbCases = 0u;
-
-    /// Create or clear output file
-    std::ofstream outputFile(mOutputFileName, std::ios::out);
-    outputFile.close();
 }
 
 void Api::readFile() {
 
-    /// Open input file
-    std::ifstream file(mInputFileName);
-    std::string line;
-
-    if (file.is_open()) {
-        /// Read line by line and put each line in a list: file opened only once
-        while (std::getline(file, line)) {
-            if(!line.empty()) mInputLines.push_back(line);
-        }
-        file.close();
-    }
-    else std::cerr << "Cannot open file " << mInputFileName << " !" << std::endl;  ///< File could not be opened
+    /// Open input file: mapped in memory, lines are read directly from it
+    if (!mCaseReader.open(mInputFileName))
+        std::cerr << "Cannot open file " << mInputFileName << " !" << std::endl;  ///< File could not be opened
 }
 
-bool Api::getNextCase() {
+bool Api::getNextCase(CaseStats *stats) {
+    std::chrono::steady_clock::time_point start;
+    if (stats) start = std::chrono::steady_clock::now();
 
-    /// Check if a case can be created from input
-    if(mInputLines.empty())
-        return false;
+    /// Allocations are counted from the start of the parse of the case
+    if (mMemory) AllocationTracker::startCase();
+    AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseParse);
 
-    /// Input data
-    uint32_t number;
-    std::vector<uint32_t> vectCase;
+    /// The hash of the Safe is computed while its mirrors are still in cache
+    const Safe *previous = mSafe.get();
+    const bool hasCase = mCaseReader.nextCase(mSafe, mSafeShared);
+    if (mSafe.get() != previous) mSafeShared = false;
+    if (hasCase && mCache.enabled()) mCaseKey = ResultCache::hash(*mSafe);
 
-    /// Read line by line. Make stringstream to retrieve data in proper format (int)
-    std::stringstream line(mInputLines.front());
+    if (stats) stats->parseNs = CaseStats::elapsedNs(start);
+    return hasCase;
+}
 
-    /// Retrieve data from input line
-    while ((line >> number))
-        vectCase.push_back(number);
+bool Api::findCached(const uint32_t caseId, CaseResult &result) {
+    if (!mCache.enabled() || mEnumerate || candidatesOf(caseId) != nullptr) return false;
+
+    ResultCache::Result cached;
+    if (!mCache.find(mCaseKey, *mSafe, cached)) return false;
+    /// The minimum number of mirrors is not kept by the cache
+    if (mMinimum && cached.nbSolution < 0) return false;
+    result.nbSolution = cached.nbSolution;
+    result.row = cached.row;
+    result.column = cached.column;
+    result.answers.clear();
+
+    /// Nothing is solved: only the parse time is kept
+    const uint64_t parseNs = result.stats.parseNs;
+    result.stats = CaseStats{};
+    result.stats.parseNs = parseNs;
+    return true;
+}
 
-    /// Remove read line
-    mInputLines.pop_front();
+void Api::readCandidates() {
 
-    /// Line should have four (4) integers to create a new case:
-    /// Number of row, number of column, number of mirrors / and number of mirrors \ .
-    if(vectCase.size() == 4){
-        /// New case, configure the safe. Clear mirrors before setting context to avoid automatic removing (longer).
-        mSafe.clearMirrors();
-        mSafe.setContext(vectCase.at(0), vectCase.at(1));
+    mCandidates.clear();
+    if (mCandidatesFileName.empty()) return;
 
-        /// Add mirrors to the safe if any
-        if(vectCase.at(2) > 0 || vectCase.at(3) > 0) {
-            /// Check validity of number of mirrors, must be less than 200000 for each kind
-            if (vectCase.at(2) > 200000 || vectCase.at(3) > 200000)
-                std::cerr << "Number of mirrors should not be superior to 200000 for each kind !" << std::endl;
+    std::ifstream file(mCandidatesFileName);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open file " << mCandidatesFileName << " !" << std::endl;
+        return;
+    }
 
-            configureSafe(vectCase.at(2), vectCase.at(3));
+    /// One candidate per line: case row column kind
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream values(line);
+        uint32_t caseId, row, column;
+        char kind;
+        if (!(values >> caseId >> row >> column >> kind) || (kind != '/' && kind != '\\')) {
+            if (!line.empty())
+                std::cerr << "Improper candidate line '" << line << "' ! Expected 'case row column kind'." << std::endl;
+            continue;
         }
-    } else
-        /// Line does not represent a new case
-        std::cerr << "Missing data to create a case: Need a line of type 'nb_rows nb_columns nb_mirror_/ nb_mirror_\\'" << std::endl;
+        mCandidates[caseId].push_back({row, column, kind == '/' ? Mirror::emirrorKind::eKindRightLeft :
+                                                    Mirror::emirrorKind::eKindLeftRight});
+    }
 
-    return true;
+    mAnswersFile.open(mAnswersFileName, std::ios::out | std::ios::trunc);
+    if (!mAnswersFile.is_open()) std::cerr << "Cannot open file " << mAnswersFileName << " !" << std::endl;
+}
 
+const std::vector<SafeBreaker::Candidate> *Api::candidatesOf(const uint32_t caseId) const {
+    const auto candidates = mCandidates.find(caseId);
+    return candidates == mCandidates.end() ? nullptr : &candidates->second;
 }
 
-void Api::configureSafe(uint32_t nbMirrorRightLeft, uint32_t nbMirrorLeftRight) {
+void Api::solveCase(SafeBreaker &breaker, const Safe &safe, CaseResult &result, const bool withStats,
+                    const std::vector<SafeBreaker::Candidate> *candidates, const bool minimum) {
+    if (!withStats) {
+        breaker.reset(safe);
+        breaker.solve(result.nbSolution, result.row, result.column);
+    } else {
+        const auto start = std::chrono::steady_clock::now();
+        breaker.reset(safe);
+        result.stats.buildNs = CaseStats::elapsedNs(start);
+        breaker.solve(result.nbSolution, result.row, result.column, result.stats);
+    }
 
-    uint32_t rowColumn;
-    std::vector<uint32_t> mirrorPos;
+    /// Check the candidates with the same breaker, the trajectories are computed once for all of them
+    result.answers.clear();
+    if (candidates) {
+        result.answers.resize(candidates->size());
+        breaker.checkCandidates(*candidates, result.answers);
+    }
 
-    /// Retrieve mirrors until no more mirror is needed or input file is empty
-    while ((nbMirrorRightLeft || nbMirrorLeftRight) && !mInputLines.empty()) {
+    /// Search how many mirrors open the Safe when a single one is not enough
+    result.placements.clear();
+    if (minimum && result.nbSolution < 0) result.minimum = breaker.minimumMirrors(result.placements);
+}
 
-        /// Clear previous position
-        mirrorPos.clear();
+void Api::outputSolution(const CaseResult &result) {
 
-        /// Read position from line
-        std::stringstream line(mInputLines.front());
+    /// Display message, the display is not flushed for each case
+    mDisplay.clear();
+    ResultWriter::formatText(mDisplay, mNbCases, result.nbSolution, result.row, result.column);
+    mDisplay.push_back('\n');
+    std::cout << mDisplay;
 
-        /// Retrieve position in proper type
-        while ((line >> rowColumn))
-            mirrorPos.push_back(rowColumn);
+    /// Save message through the buffered output file
+    mWriter.write(mNbCases, result.nbSolution, result.row, result.column);
 
-        /// Line should represent a position: row position, column position
-        if (mirrorPos.size() == 2) {
-            /// First lines are for mirrors of kind /, then lines are for mirrors of kind \ .
-            if (nbMirrorRightLeft) {
-                mSafe.addMirror(mirrorPos.at(0), mirrorPos.at(1), Mirror::emirrorKind::eKindRightLeft);
-                --nbMirrorRightLeft;
-            } else if (nbMirrorLeftRight) {
-                mSafe.addMirror(mirrorPos.at(0), mirrorPos.at(1), Mirror::emirrorKind::eKindLeftRight);
-                --nbMirrorLeftRight;
-            } else
-                /// Error: reading should have stopped. Should never be reached.
-                std::cerr << "Error: file reading should have stopped at previous iteration !" << std::endl;
-        } else {
-            /// Line does not represent a position: could be a new case (ie a mirror is missing)
-            std::cerr << "Improper line format to make a mirror ! Expected two (2) integers." << std::endl;
-            break;
-        }
+    /// Save the minimum number of mirrors right after the result of the case
+    if (mMinimum && result.nbSolution < 0) mWriter.writeMinimum(mNbCases, result.minimum, result.placements);
 
-        /// Remove read line only if the line has the proper format for a mirror. Could be a new case if not.
-        mInputLines.pop_front();
+    /// Save the heap allocations of the case, and keep it if among the highest peaks
+    if (mMemory) {
+        mWriter.writeMemory(mNbCases, result.memory);
+        rankMemory(mNbCases, result.memory);
+    }
+
+    /// Save the statistics of the case
+    mStatsWriter.write(mNbCases, result.stats);
+
+    /// Save the answers of the candidates of the case
+    if (const auto *candidates = candidatesOf(mNbCases); candidates && mAnswersFile.is_open()) {
+        static const char *const names[] = {"opens", "closes", "occupied", "outside"};
+        for (std::size_t index = 0u; index < result.answers.size(); ++index) {
+            const SafeBreaker::Candidate &candidate = (*candidates)[index];
+            mAnswersFile << mNbCases << ' ' << candidate.row << ' ' << candidate.column << ' '
+                         << (candidate.kind == Mirror::emirrorKind::eKindRightLeft ? '/' : '\\') << ' '
+                         << names[static_cast<uint8_t>(result.answers[index])] << '\n';
+        }
     }
+
+    /// Increase the number of solved cases
+    ++mNbCases;
 }
 
-void Api::outputSolution(const int nbSolution, const uint32_t row, const uint32_t column) {
+void Api::setOutputFormat(const ResultWriter::eformat format) {
+    mOutputFormat = format;
+}
 
-    /// Fill string depending on the number of solutions
-    std::stringstream output;
+void Api::setFlushPolicy(const std::size_t flushBytes, const std::chrono::milliseconds flushInterval) {
+    mWriter.setFlushPolicy(flushBytes, flushInterval);
+}
 
-    /// Basic state
-    output << "Case " << mNbCases << ": ";
+void Api::setThreads(const uint32_t nbThreads) {
+    mNbThreads = nbThreads;
+}
 
-    /// If impossible to solve the case, add "impossible", otherwise add the number of solution
-    if(nbSolution<0) output << "impossible";
-    else output << nbSolution;
+void Api::setStatsFile(std::string statsFileName) {
+    mStatsFileName = std::move(statsFileName);
+}
 
-    /// If at least one solution exist, add the position given in parameters
-    if(nbSolution>0) output << " " << row << " " << column;
+void Api::setCandidatesFiles(std::string candidatesFileName, std::string answersFileName) {
+    mCandidatesFileName = std::move(candidatesFileName);
+    mAnswersFileName = std::move(answersFileName);
+}
+
+void Api::setEnumerate(const bool enumerate) {
+    mEnumerate = enumerate;
+}
+
+void Api::setMinimum(const bool minimum) {
+    mMinimum = minimum;
+}
+
+void Api::setMemoryAccounting(const bool accounting) {
+    if (accounting && !AllocationTracker::installed())
+        std::cerr << "Heap allocations can not be counted: allocation accounting is not built in this program !"
+                  << std::endl;
+    mMemory = accounting && AllocationTracker::installed();
+    AllocationTracker::setEnabled(accounting);
+}
 
-    /// Display message
-    std::cout << output.str() << std::endl;
+void Api::rankMemory(const uint32_t caseId, const AllocationTracker::Usage &usage) {
+    if (mWorstCases.size() == C_NB_WORST_CASES && usage.growthBytes() <= mWorstCases.back().second.growthBytes())
+        return;
+    if (mWorstCases.size() == C_NB_WORST_CASES) mWorstCases.pop_back();
 
-    /// Save message in output file
-    std::ofstream file(mOutputFileName, std::ios::app);
-    if (file.is_open()) {
-        file << output.str() << "\n";
-        file.close();
+    /// Highest growth first, the first case reaching a growth before the next ones
+    const auto position = std::find_if(mWorstCases.begin(), mWorstCases.end(), [&usage](const auto &worstCase) {
+        return worstCase.second.growthBytes() < usage.growthBytes();
+    });
+    mWorstCases.emplace(position, caseId, usage);
+}
+
+void Api::displayWorstCases() const {
+    std::cout << "Cases raising the live heap bytes the most:" << std::endl;
+    for (const auto &[caseId, usage]: mWorstCases) {
+        const AllocationTracker::ephase phase = usage.heaviestPhase();
+        std::cout << "  Case " << caseId << ": peak " << usage.peakBytes << " bytes (+" << usage.growthBytes()
+                  << "), most allocated by "
+                  << AllocationTracker::phaseName(phase) << " ("
+                  << usage.phases[static_cast<std::size_t>(phase)].bytes << " bytes)" << std::endl;
     }
+}
 
-    /// Increase the number of solved cases
-    ++mNbCases;
+void Api::setQueueLimits(const std::size_t maxCases, const std::size_t maxBytes) {
+    mQueueCases = maxCases;
+    mQueueBytes = maxBytes;
+}
+
+void Api::setCache(const std::size_t capacity, std::string cacheFileName) {
+    mCache.setCapacity(capacity);
+    mCacheFileName = std::move(cacheFileName);
+}
+
+void Api::setLargeGrid(const bool largeGrid) {
+    mCaseReader.setLargeGrid(largeGrid);
 }
 
 void Api::launch() {
@@ -149,17 +234,179 @@ void Api::launch() {
     /// Load input file containing cases scenario
     readFile();
 
-    /// Retrieve the next case and configure the Safe accordingly until each case is solved
-    while (getNextCase()){
+    /// Create or clear output file, opened only once
+    if (!mWriter.open(mOutputFileName, mOutputFormat))
+        std::cerr << "Cannot open file " << mOutputFileName << " !" << std::endl;
+
+    /// Create or clear statistics file if statistics are asked
+    if (!mStatsFileName.empty() && !mStatsWriter.open(mStatsFileName))
+        std::cerr << "Cannot open file " << mStatsFileName << " !" << std::endl;
+    const bool withStats = mStatsWriter.isOpen();
+
+    /// Load the candidates to check, if any
+    readCandidates();
+
+    /// Results of a previous run, if saved
+    if (mCache.enabled() && !mCacheFileName.empty() && !mCache.load(mCacheFileName))
+        std::cerr << "Invalid cache file " << mCacheFileName << ", it is ignored !" << std::endl;
+
+    /// Several workers: solve the cases concurrently, unless every solution is enumerated by the breaker of the Api or
+    /// the allocations of each case are counted
+    const uint32_t nbThreads = mEnumerate || mMemory ? 1u : ThreadPool::resolveThreads(mNbThreads);
+    if (nbThreads > 1u) {
+        launchConcurrent(nbThreads, withStats);
+    } else {
+        /// Retrieve the next case and configure the Safe accordingly until each case is solved
+        CaseResult result;
+        while (getNextCase(withStats ? &result.stats : nullptr)) {
+
+            /// Solve the case: open the Safe, unless the same Safe has already been solved
+            if (!findCached(mNbCases, result)) {
+                solveCase(mBreaker, *mSafe, result, withStats, candidatesOf(mNbCases), mMinimum);
+                if (mCache.enabled()) mCache.insert(mCaseKey, *mSafe, {result.nbSolution, result.row, result.column});
+            }
+            if (mMemory) result.memory = AllocationTracker::usage();
+
+            /// Display and save solutions to open the Safe
+            outputSolution(result);
+
+            /// Stream every solution to the output file, right after the result of the case
+            if (mEnumerate && result.nbSolution > 0) {
+                const uint32_t caseId = mNbCases - 1u;
+                mBreaker.enumerateSolutions([this, caseId](const uint32_t row, const uint32_t column,
+                                                           const Mirror::emirrorKind kind) {
+                    mWriter.writeSolution(caseId, row, column, kind == Mirror::emirrorKind::eKindRightLeft);
+                });
+            }
+        }
+    }
 
-        /// Solve the case: open the Safe
-        int nbSolution = 0;
-        uint32_t solutionRow, solutionColumn = 0u;
-        SafeBreaker breaker(mSafe);
-        breaker.solve(nbSolution, solutionRow, solutionColumn);
+    /// Save the results of the Safes for the next runs
+    if (mCache.enabled() && !mCacheFileName.empty() && !mCache.save(mCacheFileName))
+        std::cerr << "Cannot write file " << mCacheFileName << " !" << std::endl;
+
+    /// Save the remaining results and the aggregated statistics
+    mWriter.close();
+    mStatsWriter.close();
+    if (mAnswersFile.is_open()) mAnswersFile.close();
+
+    if (mMemory) displayWorstCases();
+}
 
-        /// Display and save solutions to open the Safe
-        outputSolution(nbSolution, solutionRow, solutionColumn);
+void Api::launchConcurrent(const uint32_t nbThreads, const bool withStats) {
+
+    /// Results of the cases read and not written yet, in case order, with the bytes of their Safe. A deque keeps the
+    /// results in place while new cases are added.
+    std::deque<CaseResult> results;
+    std::deque<std::size_t> resultBytes;
+    std::size_t pendingBytes = 0u;
+    bool parsed = false;
+    std::mutex resultsMutex;
+    std::condition_variable resultsCondition, spaceCondition;
+
+    /// Bounds of the cases waiting to be written: the parser waits for the writer when they are reached
+    const std::size_t maxCases = mQueueCases > 0u ? mQueueCases : C_QUEUE_CASES_PER_WORKER * nbThreads;
+    const std::size_t maxBytes = mQueueBytes;
+
+    /// Writer: display and save the solved results following the case order, as soon as they are solved
+    std::thread writer([&]() {
+        std::unique_lock<std::mutex> lock(resultsMutex);
+        for (;;) {
+            if (results.empty() || !results.front().solved) {
+                if (results.empty() && parsed) break;
+
+                /// Save the buffered results regularly while waiting for a long case
+                if (!resultsCondition.wait_for(lock, C_WAIT_INTERVAL, [&] {
+                    return (!results.empty() && results.front().solved) || (results.empty() && parsed);
+                })) {
+                    lock.unlock();
+                    mWriter.flushIfDue();
+                    lock.lock();
+                }
+                continue;
+            }
+            const CaseResult result = std::move(results.front());
+            results.pop_front();
+            lock.unlock();
+            outputSolution(result);
+            lock.lock();
+
+            /// The case leaves the queue: the parser may read the next ones
+            pendingBytes -= resultBytes.front();
+            resultBytes.pop_front();
+            spaceCondition.notify_one();
+        }
+    });
+
+    /// One breaker per worker, reused from case to case. Declared before the pool: the workers use them until the end.
+    std::vector<SafeBreaker> breakers(nbThreads);
+    ThreadPool pool(nbThreads);
+
+    /// A big case is also split over the workers, so a single huge case does not leave them idle
+    for (auto &breaker: breakers) breaker.setThreadPool(&pool);
+
+    /// Parser: retrieve the next case and share the Safe with a worker until each case is submitted. The Safe is not
+    /// copied, unless the reader gives back the Safe already submitted.
+    CaseStats parseStats;
+    for (uint32_t caseId = 0u; getNextCase(withStats ? &parseStats : nullptr); ++caseId) {
+
+        /// Wait for the writer while the queue is full. A case bigger than the ceiling waits for an empty queue.
+        const std::size_t bytes = sizeof(Safe) + mSafe->mirrors().size() * C_MIRROR_BYTES;
+        CaseResult *result;
+        {
+            std::unique_lock<std::mutex> lock(resultsMutex);
+            spaceCondition.wait(lock, [&] {
+                return results.empty() ||
+                       (results.size() < maxCases && (maxBytes == 0u || pendingBytes + bytes <= maxBytes));
+            });
+            result = &results.emplace_back();
+            resultBytes.push_back(bytes);
+            pendingBytes += bytes;
+        }
+
+        /// A Safe already solved is not given to a worker
+        CaseResult cached;
+        cached.stats = parseStats;
+        if (findCached(caseId, cached)) {
+            cached.solved = true;
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                *result = std::move(cached);
+            }
+            resultsCondition.notify_all();
+            continue;
+        }
+
+        /// A worker may still read the Safe if the reader left it in place: it is never handed to two workers
+        if (mSafeShared) mSafe = std::make_shared<Safe>(*mSafe);
+        mSafeShared = true;
+        pool.submit([result, safe = mSafe, key = mCaseKey, parseStats, withStats, candidates = candidatesOf(caseId),
+                     minimum = mMinimum, &breakers, &pool, &cache = mCache, &reader = mCaseReader, &resultsMutex,
+                     &resultsCondition]() mutable {
+            /// Solve the case with the breaker of the worker: open the Safe
+            CaseResult solved;
+            solved.stats = parseStats;
+            solveCase(breakers[pool.workerIndex()], *safe, solved, withStats, candidates, minimum);
+            solved.solved = true;
+            if (cache.enabled()) cache.insert(key, *safe, {solved.nbSolution, solved.row, solved.column});
+
+            /// The Safe is not read anymore: the parser may configure a next case in it
+            reader.recycle(std::move(safe));
+
+            /// Give the result back for an ordered output
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                *result = std::move(solved);
+            }
+            resultsCondition.notify_all();
+        });
+    }
 
+    /// Every case has been read: the writer stops once the remaining results are written
+    {
+        std::lock_guard<std::mutex> lock(resultsMutex);
+        parsed = true;
     }
+    resultsCondition.notify_all();
+    writer.join();
 }
@@ -0,0 +1,46 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include "../headers/Arena.h"
+
+/// Minimum size of a block of the arena
+const std::size_t C_MIN_BLOCK_SIZE = 1u << 16u;
+
+void *Arena::allocateBytes(const std::size_t size, const std::size_t alignment) {
+
+    /// Aligned position in the last block
+    std::size_t position = (mOffset + alignment - 1u) & ~(alignment - 1u);
+
+    if (mBlocks.empty() || position + size > mBlocks.back().size) {
+        /// Not enough memory left: add a block, at least twice the last one. Blocks are aligned for any object.
+        mPreviousBlocksUsed += mOffset;
+        const std::size_t blockSize = std::max({size, C_MIN_BLOCK_SIZE, mBlocks.empty() ? 0u : 2u * mBlocks.back().size});
+        mBlocks.push_back({std::make_unique_for_overwrite<std::byte[]>(blockSize), blockSize});
+        position = 0u;
+    }
+
+    mOffset = position + size;
+    return mBlocks.back().memory.get() + position;
+}
+
+void Arena::reset() {
+    /// Several blocks were needed: replace them by a single block big enough for all of them
+    if (mBlocks.size() > 1u) {
+        const std::size_t totalSize = capacity();
+        mBlocks.clear();
+        mBlocks.push_back({std::make_unique_for_overwrite<std::byte[]>(totalSize), totalSize});
+    }
+    mOffset = mPreviousBlocksUsed = 0u;
+}
+
+std::size_t Arena::capacity() const {
+    std::size_t totalSize = 0u;
+    for (const auto &block: mBlocks) totalSize += block.size;
+    return totalSize;
+}
+
+std::size_t Arena::used() const {
+    return mPreviousBlocksUsed + mOffset;
+}
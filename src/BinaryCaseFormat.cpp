@@ -0,0 +1,192 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+#include "../headers/AllocationTracker.h"
+#include "../headers/BinaryCaseFormat.h"
+
+namespace {
+    /**
+     * Append a value to a content as raw bytes, in the native byte order.
+     *
+     * @param output: content to append to
+     * @param value: value to append
+     */
+    template<typename T>
+    void appendRaw(std::string &output, const T &value) {
+        output.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    /**
+     * Append the zigzag varint of the difference between two positions: 7 bits per byte, the highest bit set on every
+     * byte but the last one.
+     *
+     * @param output: content to append to
+     * @param previous, current: consecutive positions
+     */
+    void appendDelta(std::string &output, const uint32_t previous, const uint32_t current) {
+        const int64_t delta = static_cast<int64_t>(current) - static_cast<int64_t>(previous);
+        uint64_t zigzag = (static_cast<uint64_t>(delta) << 1u) ^ static_cast<uint64_t>(delta >> 63);
+        for (; zigzag >= 0x80u; zigzag >>= 7u) output.push_back(static_cast<char>((zigzag & 0x7Fu) | 0x80u));
+        output.push_back(static_cast<char>(zigzag));
+    }
+
+    /**
+     * Decode consecutive positions written by appendDelta.
+     *
+     * @param[in out] position, end: content to decode, position is moved after the decoded varints
+     * @param[out] values: decoded positions, its size gives the number of positions to decode
+     * @return false if the content is truncated or a position does not fit 32 bits
+     */
+    bool decodeDeltas(const unsigned char *&position, const unsigned char *end, std::vector<uint32_t> &values) {
+        int64_t previous = 0;
+        for (auto &value: values) {
+            uint64_t zigzag = 0u;
+            for (uint32_t shift = 0u;; shift += 7u) {
+                if (position == end || shift > 63u) return false;
+                const unsigned char byte = *position++;
+                zigzag |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+                if ((byte & 0x80u) == 0u) break;
+            }
+            previous += static_cast<int64_t>(zigzag >> 1u) ^ -static_cast<int64_t>(zigzag & 1u);
+            if (previous < 0 || previous > static_cast<int64_t>(UINT32_MAX)) return false;
+            value = static_cast<uint32_t>(previous);
+        }
+        return true;
+    }
+}
+
+bool BinaryCaseFormat::isBinary(const std::string_view content) {
+    return content.size() >= C_MAGIC.size() && std::equal(C_MAGIC.begin(), C_MAGIC.end(), content.begin());
+}
+
+void BinaryCaseFormat::writeFileHeader(std::string &output) {
+    appendRaw(output, FileHeader{C_MAGIC, C_VERSION});
+}
+
+void BinaryCaseFormat::writeCase(std::string &output, const Safe &safe, const eencoding encoding) {
+
+    /// Mirrors of kind / first, then mirrors of kind \ , as in the text format
+    const Safe::MirrorsView mirrors = safe.mirrors();
+    std::vector<uint32_t> order(mirrors.size());
+    std::iota(order.begin(), order.end(), 0u);
+    auto isRightLeft = [&mirrors](const uint32_t index) {
+        return mirrors.kinds[index] == Mirror::emirrorKind::eKindRightLeft;
+    };
+    const auto nbRightLeft = static_cast<uint32_t>(
+            std::stable_partition(order.begin(), order.end(), isRightLeft) - order.begin());
+
+    /// Delta-encoded positions are smaller once sorted: the order of the mirrors of a kind does not change the Safe
+    if (encoding == eencoding::eEncodingDelta) {
+        auto byPosition = [&mirrors](const uint32_t first, const uint32_t second) {
+            return mirrors.rows[first] < mirrors.rows[second] ||
+                   (mirrors.rows[first] == mirrors.rows[second] && mirrors.columns[first] < mirrors.columns[second]);
+        };
+        std::sort(order.begin(), order.begin() + nbRightLeft, byPosition);
+        std::sort(order.begin() + nbRightLeft, order.end(), byPosition);
+    }
+
+    const std::size_t headerPosition = output.size();
+    appendRaw(output, CaseHeader{safe.rows(), safe.columns(), nbRightLeft,
+                                 static_cast<uint32_t>(mirrors.size()) - nbRightLeft, encoding, 0u});
+    const std::size_t payloadPosition = output.size();
+
+    if (encoding == eencoding::eEncodingRaw) {
+        for (const uint32_t index: order) appendRaw(output, mirrors.rows[index]);
+        for (const uint32_t index: order) appendRaw(output, mirrors.columns[index]);
+    } else {
+        for (const auto &positions: {mirrors.rows, mirrors.columns}) {
+            uint32_t previous = 0u;
+            for (const uint32_t index: order) {
+                appendDelta(output, previous, positions[index]);
+                previous = positions[index];
+            }
+        }
+    }
+
+    /// Pad the payload so that the next case, and its raw arrays, are aligned on 4 bytes
+    output.append((4u - (output.size() - payloadPosition) % 4u) % 4u, '\0');
+    const auto payloadSize = static_cast<uint32_t>(output.size() - payloadPosition);
+    std::memcpy(output.data() + headerPosition + offsetof(CaseHeader, payloadSize), &payloadSize, sizeof(payloadSize));
+}
+
+std::size_t BinaryCaseFormat::Reader::readFileHeader(const std::string_view content) {
+    FileHeader header{};
+    if (content.size() < sizeof(header)) {
+        std::cerr << "Binary input is truncated: missing file header !" << std::endl;
+        return 0u;
+    }
+    std::memcpy(&header, content.data(), sizeof(header));
+    if (header.magic != C_MAGIC || header.version != C_VERSION) {
+        std::cerr << "Unsupported binary input: expected version " << C_VERSION << ", got " << header.version << " !"
+                  << std::endl;
+        return 0u;
+    }
+    return sizeof(header);
+}
+
+std::size_t BinaryCaseFormat::Reader::caseSize(const std::string_view content) {
+    CaseHeader header{};
+    if (content.size() < sizeof(header)) return sizeof(header);
+    std::memcpy(&header, content.data(), sizeof(header));
+    return sizeof(header) + header.payloadSize;
+}
+
+std::size_t BinaryCaseFormat::Reader::readCase(const std::string_view content, Safe &safe) {
+
+    CaseHeader header{};
+    if (content.size() < sizeof(header)) {
+        std::cerr << "Binary input is truncated: missing case header !" << std::endl;
+        return 0u;
+    }
+    std::memcpy(&header, content.data(), sizeof(header));
+    const std::size_t nbMirrors = static_cast<std::size_t>(header.nbRightLeft) + header.nbLeftRight;
+    if (header.payloadSize % 4u != 0u || content.size() - sizeof(header) < header.payloadSize) {
+        std::cerr << "Binary input is truncated: missing mirrors of a case !" << std::endl;
+        return 0u;
+    }
+
+    /// Check validity of number of mirrors, as for the text format
+    safe.checkNbMirrors(header.nbRightLeft, header.nbLeftRight);
+
+    safe.clearMirrors();
+    safe.setContext(header.rows, header.columns);
+
+    const char *payload = content.data() + sizeof(header);
+    if (header.encoding == eencoding::eEncodingRaw) {
+        /// The arrays are aligned on 4 bytes in the file: they are copied to the Safe without any decoding
+        if (header.payloadSize < nbMirrors * 2u * sizeof(uint32_t)) {
+            std::cerr << "Binary input is truncated: missing mirrors of a case !" << std::endl;
+            return 0u;
+        }
+        const auto *positions = reinterpret_cast<const uint32_t *>(payload);
+        AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSafe);
+        safe.assignMirrors({positions, nbMirrors}, {positions + nbMirrors, nbMirrors}, header.nbRightLeft);
+    } else if (header.encoding == eencoding::eEncodingDelta) {
+        /// Each position takes at least one byte: a wrong number of mirrors can not allocate more than the payload
+        if (header.payloadSize < nbMirrors * 2u) {
+            std::cerr << "Binary input is truncated: missing mirrors of a case !" << std::endl;
+            return 0u;
+        }
+        const auto *position = reinterpret_cast<const unsigned char *>(payload);
+        const unsigned char *end = position + header.payloadSize;
+        mRows.resize(nbMirrors);
+        mColumns.resize(nbMirrors);
+        if (!decodeDeltas(position, end, mRows) || !decodeDeltas(position, end, mColumns)) {
+            std::cerr << "Invalid delta-encoded mirrors in binary input !" << std::endl;
+            return 0u;
+        }
+        AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSafe);
+        safe.assignMirrors(mRows, mColumns, header.nbRightLeft);
+    } else {
+        std::cerr << "Unknown encoding " << static_cast<uint32_t>(header.encoding) << " in binary input !"
+                  << std::endl;
+        return 0u;
+    }
+
+    return sizeof(header) + header.payloadSize;
+}
@@ -0,0 +1,59 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include "../headers/CandidateIndex.h"
+
+void CandidateIndex::build(const std::span<const Segment> horizontal, const std::span<const Segment> verticalReversed,
+                           std::array<uint32_t, 2> start) {
+
+    mRows.clear();
+    mColumns.clear();
+
+    /// Follow the trajectory: movements along the rows and the columns alternate, starting along a row. The direction of
+    /// a movement is given by the outer point it starts from.
+    std::size_t nbHorizontal = 0u, nbVertical = 0u;
+    for (uint32_t step = 0u; nbHorizontal + nbVertical < horizontal.size() + verticalReversed.size(); ++step) {
+        if (step % 2u == 0u) {
+            if (nbHorizontal == horizontal.size()) break;  ///< Should never be reached, movements alternate
+            const Segment &segment = horizontal[nbHorizontal++];
+            const bool right = segment.lo == start[1];
+            mRows.push_back({segment, step, right ? Mirror::edirection::eDirRight : Mirror::edirection::eDirLeft});
+            start[1] = right ? segment.hi : segment.lo;
+        } else {
+            if (nbVertical == verticalReversed.size()) break;  ///< Should never be reached, movements alternate
+            const Segment &segment = verticalReversed[verticalReversed.size() - ++nbVertical];
+            const bool down = segment.lo == start[0];
+            mColumns.push_back({segment, step, down ? Mirror::edirection::eDirDown : Mirror::edirection::eDirUp});
+            start[0] = down ? segment.hi : segment.lo;
+        }
+    }
+
+    auto byPosition = [](const Entry &first, const Entry &second) {
+        return first.segment.fixed < second.segment.fixed ||
+               (first.segment.fixed == second.segment.fixed && first.segment.lo < second.segment.lo);
+    };
+    std::sort(mRows.begin(), mRows.end(), byPosition);
+    std::sort(mColumns.begin(), mColumns.end(), byPosition);
+}
+
+CandidateIndex::Visit CandidateIndex::crossing(const std::vector<Entry> &entries, const uint32_t line,
+                                               const uint32_t position) {
+
+    /// Last movement of the line starting before the position: the only one which can contain it
+    const auto next = std::upper_bound(entries.begin(), entries.end(), std::pair{line, position},
+                                       [](const std::pair<uint32_t, uint32_t> &key, const Entry &entry) {
+                                           return key.first < entry.segment.fixed ||
+                                                  (key.first == entry.segment.fixed && key.second < entry.segment.lo);
+                                       });
+    if (next == entries.begin()) return {};
+    const Entry &entry = *std::prev(next);
+    if (entry.segment.fixed != line || entry.segment.lo >= position || position >= entry.segment.hi) return {};
+    return {entry.step, entry.direction};
+}
+
+CandidateIndex::Visit CandidateIndex::firstVisit(const uint32_t row, const uint32_t column) const {
+    const Visit alongRow = crossing(mRows, row, column), alongColumn = crossing(mColumns, column, row);
+    return alongRow.step <= alongColumn.step ? alongRow : alongColumn;
+}
@@ -0,0 +1,172 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include "../headers/AllocationTracker.h"
+#include "../headers/CaseReader.h"
+
+bool CaseReader::open(const std::string &fileName) {
+    if (!mReader.open(fileName)) return false;
+    detectFormat();
+    return true;
+}
+
+void CaseReader::open(const int descriptor) {
+    mReader.open(descriptor);
+    detectFormat();
+}
+
+void CaseReader::detectFormat() {
+
+    /// A binary file is recognized by its magic bytes, its header is checked once
+    mReader.request(BinaryCaseFormat::C_MAGIC.size());
+    mBinary = BinaryCaseFormat::isBinary(mReader.remaining());
+    if (mBinary) {
+        mReader.request(sizeof(BinaryCaseFormat::FileHeader));
+        const std::size_t headerSize = BinaryCaseFormat::Reader::readFileHeader(mReader.remaining());
+        mReader.advance(headerSize > 0u ? headerSize : mReader.remainingSize());
+    }
+}
+
+void CaseReader::setLargeGrid(const bool largeGrid) {
+    mLargeGrid = largeGrid;
+}
+
+bool CaseReader::hasCase() const {
+    if (!mBinary) return mReader.hasLine();
+    return mReader.remainingSize() == 0u ? mReader.hasLine() :
+           mReader.remainingSize() >= BinaryCaseFormat::Reader::caseSize(mReader.remaining());
+}
+
+void CaseReader::recycle(std::shared_ptr<Safe> safe) {
+    std::lock_guard<std::mutex> lock(mFreeSafesMutex);
+
+    /// A Safe handed out twice must be configured again only once both threads are done with it: it is refused
+    if (std::find(mFreeSafes.begin(), mFreeSafes.end(), safe) != mFreeSafes.end()) {
+        std::cerr << "Error: a Safe has already been given back, it is not recycled again !" << std::endl;
+        return;
+    }
+    mFreeSafes.push_back(std::move(safe));
+}
+
+void CaseReader::replaceShared(std::shared_ptr<Safe> &safe) {
+    {
+        std::lock_guard<std::mutex> lock(mFreeSafesMutex);
+        if (!mFreeSafes.empty()) {
+            safe = std::move(mFreeSafes.back());
+            mFreeSafes.pop_back();
+            return;
+        }
+    }
+    AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSafe);
+    safe = std::make_shared<Safe>();
+}
+
+bool CaseReader::nextCase(std::shared_ptr<Safe> &safe, const bool shared) {
+
+    /// The previous cases have been copied to their Safe: the input read so far is not needed anymore
+    mReader.releaseConsumed();
+
+    /// Check if a case can be created from input. Binary content has no line.
+    if(mBinary ? !mReader.request(1u) : mReader.atEnd())
+        return false;
+
+    /// A malformed first case uses an empty Safe
+    if (!safe) safe = std::make_shared<Safe>();
+
+    if (mBinary) {
+        /// Binary case, the Safe is reused as for a text case. An invalid case ends the reading.
+        if (shared) replaceShared(safe);
+        safe->setLargeGrid(mLargeGrid);
+        /// When streaming, wait for the case header, then for the whole case
+        mReader.request(BinaryCaseFormat::Reader::caseSize(mReader.remaining()));
+        mReader.request(BinaryCaseFormat::Reader::caseSize(mReader.remaining()));
+        const std::size_t caseSize = mBinaryReader.readCase(mReader.remaining(), *safe);
+        mReader.advance(caseSize > 0u ? caseSize : mReader.remainingSize());
+        return caseSize > 0u;
+    }
+
+    /// Input data. One more integer than needed is read to detect lines with too much data.
+    std::array<uint32_t, 5> vectCase{};
+
+    /// Retrieve data from input line
+    const uint32_t nbValues = mReader.parseLine(vectCase.data(), static_cast<uint32_t>(vectCase.size()));
+
+    /// Remove read line
+    mReader.nextLine();
+
+    /// Line should have four (4) integers to create a new case:
+    /// Number of row, number of column, number of mirrors / and number of mirrors \ .
+    if(nbValues == 4){
+        /// New case, configure the safe. The Safe is replaced only if a previous case may still use it, otherwise
+        /// its memory is reused. Clear mirrors before setting context to avoid automatic removing (longer).
+        if (shared) replaceShared(safe);
+        safe->clearMirrors();
+        safe->setLargeGrid(mLargeGrid);
+        safe->setContext(vectCase[0], vectCase[1]);
+
+        /// Add mirrors to the safe if any
+        if(vectCase[2] > 0 || vectCase[3] > 0) {
+            /// Check validity of number of mirrors, must be less than 200000 for each kind on a usual grid
+            safe->checkNbMirrors(vectCase[2], vectCase[3]);
+
+            configureSafe(*safe, vectCase[2], vectCase[3]);
+        }
+    } else {
+        /// Line does not represent a new case. The Safe is left unchanged, but a Safe handed to another thread is
+        /// copied to a replacement: the same Safe is never handed out twice.
+        std::cerr << "Missing data to create a case: Need a line of type 'nb_rows nb_columns nb_mirror_/ nb_mirror_\\'" << std::endl;
+        if (shared) {
+            const std::shared_ptr<Safe> previous = safe;
+            replaceShared(safe);
+            AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSafe);
+            *safe = *previous;
+        }
+    }
+
+    return true;
+
+}
+
+void CaseReader::configureSafe(Safe &safe, uint32_t nbMirrorRightLeft, uint32_t nbMirrorLeftRight) {
+
+    /// Position of a mirror. One more integer than needed is read to detect lines with too much data.
+    std::array<uint32_t, 3> mirrorPos{};
+
+    /// Reserve the arrays of mirrors once. A mirror line has at least four (4) characters: a wrong number of mirrors
+    /// can not reserve more than what the rest of the file can contain.
+    {
+        AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSafe);
+        safe.reserveMirrors(std::min<std::size_t>(static_cast<std::size_t>(nbMirrorRightLeft) + nbMirrorLeftRight,
+                                                  mReader.remainingSize() / 4u));
+    }
+
+    /// Retrieve mirrors until no more mirror is needed or input file is empty
+    while ((nbMirrorRightLeft || nbMirrorLeftRight) && !mReader.atEnd()) {
+
+        /// Read position from line, directly in proper type
+        const uint32_t nbValues = mReader.parseLine(mirrorPos.data(), static_cast<uint32_t>(mirrorPos.size()));
+
+        /// Line should represent a position: row position, column position
+        if (nbValues == 2) {
+            /// First lines are for mirrors of kind /, then lines are for mirrors of kind \ .
+            if (nbMirrorRightLeft) {
+                safe.addMirror(mirrorPos[0], mirrorPos[1], Mirror::emirrorKind::eKindRightLeft);
+                --nbMirrorRightLeft;
+            } else if (nbMirrorLeftRight) {
+                safe.addMirror(mirrorPos[0], mirrorPos[1], Mirror::emirrorKind::eKindLeftRight);
+                --nbMirrorLeftRight;
+            } else
+                /// Error: reading should have stopped. Should never be reached.
+                std::cerr << "Error: file reading should have stopped at previous iteration !" << std::endl;
+        } else {
+            /// Line does not represent a position: could be a new case (ie a mirror is missing)
+            std::cerr << "Improper line format to make a mirror ! Expected two (2) integers." << std::endl;
+            break;
+        }
+
+        /// Remove read line only if the line has the proper format for a mirror. Could be a new case if not.
+        mReader.nextLine();
+    }
+}
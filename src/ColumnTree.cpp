@@ -0,0 +1,15 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include "../headers/ColumnTree.h"
+
+void ColumnTree::build(const std::span<const Segment> vertical) {
+
+    /// Compress the columns of the vertical movements: the tree only depends on the number of movements
+    mColumns.clear();
+    for (const auto &segment: vertical) mColumns.push_back(segment.fixed);
+    std::sort(mColumns.begin(), mColumns.end());
+    mColumns.erase(std::unique(mColumns.begin(), mColumns.end()), mColumns.end());
+    mTree.assign(mColumns.size() + 1u, 0);
+}
@@ -0,0 +1,149 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <bit>
+#include "../headers/CrossingKernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SAFEANDMIRRORS_X86 1
+#endif
+
+namespace {
+
+    /**
+     * Test movements one by one.
+     *
+     * @param row, lo, hi: as CrossingKernel::cross
+     * @param begin, size: movements [begin, size) to test
+     * @param result: count and first crossing, updated
+     */
+    void crossScalar(const uint32_t row, const uint32_t *lo, const uint32_t *hi, uint32_t begin, const uint32_t size,
+                     CrossingKernel::Result &result) {
+        for (; begin < size; ++begin) {
+            if (lo[begin] < row && row < hi[begin]) {
+                if (result.count++ == 0u) result.first = begin;
+            }
+        }
+    }
+
+#ifdef SAFEANDMIRRORS_X86
+
+    /**
+     * Add the crossings of a block of movements given as a bit mask, bit i for the movement begin+i.
+     *
+     * @param bits: mask of the crossed movements of the block
+     * @param begin: index of the first movement of the block
+     * @param result: count and first crossing, updated
+     */
+    inline void addBlock(const uint32_t bits, const uint32_t begin, CrossingKernel::Result &result) {
+        if (bits == 0u) return;
+        if (result.count == 0u) result.first = begin + static_cast<uint32_t>(std::countr_zero(bits));
+        result.count += static_cast<uint32_t>(std::popcount(bits));
+    }
+
+    /**
+     * Test movements 4 at a time, 16 per iteration. Integers are compared as signed: the sign bit of every value is
+     * flipped to compare them as unsigned.
+     */
+    CrossingKernel::Result crossSse2(const uint32_t row, const uint32_t *lo, const uint32_t *hi, const uint32_t size) {
+        CrossingKernel::Result result{0u, size};
+        const __m128i bias = _mm_set1_epi32(INT32_MIN);
+        const __m128i flippedRow = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(row)), bias);
+
+        auto mask = [&](const uint32_t index) {
+            const __m128i flippedLo = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lo + index)),
+                                                    bias);
+            const __m128i flippedHi = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hi + index)),
+                                                    bias);
+            const __m128i crossed = _mm_and_si128(_mm_cmpgt_epi32(flippedRow, flippedLo),
+                                                  _mm_cmpgt_epi32(flippedHi, flippedRow));
+            return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(crossed)));
+        };
+
+        uint32_t index = 0u;
+        for (; index + 16u <= size; index += 16u)
+            addBlock(mask(index) | (mask(index + 4u) << 4u) | (mask(index + 8u) << 8u) | (mask(index + 12u) << 12u),
+                     index, result);
+        for (; index + 4u <= size; index += 4u) addBlock(mask(index), index, result);
+        crossScalar(row, lo, hi, index, size, result);
+        return result;
+    }
+
+    /**
+     * Mask of the crossed movements among 8 movements, bit i for the movement index+i.
+     */
+    __attribute__((target("avx2")))
+    inline uint32_t maskAvx2(const __m256i flippedRow, const __m256i bias, const uint32_t *lo, const uint32_t *hi,
+                             const uint32_t index) {
+        const __m256i flippedLo = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lo + index)),
+                                                   bias);
+        const __m256i flippedHi = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hi + index)),
+                                                   bias);
+        const __m256i crossed = _mm256_and_si256(_mm256_cmpgt_epi32(flippedRow, flippedLo),
+                                                 _mm256_cmpgt_epi32(flippedHi, flippedRow));
+        return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(crossed)));
+    }
+
+    /**
+     * Test movements 8 at a time, 16 per iteration, as crossSse2.
+     */
+    __attribute__((target("avx2,popcnt,bmi")))
+    CrossingKernel::Result crossAvx2(const uint32_t row, const uint32_t *lo, const uint32_t *hi, const uint32_t size) {
+        CrossingKernel::Result result{0u, size};
+        const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+        const __m256i flippedRow = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int32_t>(row)), bias);
+
+        uint32_t index = 0u;
+        for (; index + 16u <= size; index += 16u)
+            addBlock(maskAvx2(flippedRow, bias, lo, hi, index) |
+                     (maskAvx2(flippedRow, bias, lo, hi, index + 8u) << 8u), index, result);
+        for (; index + 8u <= size; index += 8u) addBlock(maskAvx2(flippedRow, bias, lo, hi, index), index, result);
+        crossScalar(row, lo, hi, index, size, result);
+        return result;
+    }
+
+#endif
+
+    /**
+     * Find the best instruction set of the processor
+     *
+     * @return instruction set
+     */
+    CrossingKernel::einstructionSet detectInstructionSet() {
+#ifdef SAFEANDMIRRORS_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi"))
+            return CrossingKernel::einstructionSet::eInstructionSetAvx2;
+        if (__builtin_cpu_supports("sse2")) return CrossingKernel::einstructionSet::eInstructionSetSse2;
+#endif
+        return CrossingKernel::einstructionSet::eInstructionSetScalar;
+    }
+}
+
+CrossingKernel::einstructionSet CrossingKernel::instructionSet() {
+    /// Detected once, by the first call
+    static const einstructionSet detected = detectInstructionSet();
+    return detected;
+}
+
+CrossingKernel::Result CrossingKernel::cross(const uint32_t row, const uint32_t *lo, const uint32_t *hi,
+                                             const uint32_t size) {
+    return cross(instructionSet(), row, lo, hi, size);
+}
+
+CrossingKernel::Result CrossingKernel::cross(const einstructionSet instructionSet, const uint32_t row,
+                                             const uint32_t *lo, const uint32_t *hi, const uint32_t size) {
+    switch (instructionSet) {
+#ifdef SAFEANDMIRRORS_X86
+        case einstructionSet::eInstructionSetAvx2: return crossAvx2(row, lo, hi, size);
+        case einstructionSet::eInstructionSetSse2: return crossSse2(row, lo, hi, size);
+#endif
+        default: {
+            Result result{0u, size};
+            crossScalar(row, lo, hi, 0u, size, result);
+            return result;
+        }
+    }
+}
@@ -0,0 +1,176 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../headers/InputReader.h"
+
+InputReader::~InputReader() {
+    close();
+}
+
+void InputReader::close() {
+    if (mMapping != nullptr) munmap(mMapping, mMappingSize);
+    mMapping = nullptr;
+    mMappingSize = mReleasedSize = 0u;
+    mBuffer.clear();
+    mCursor = mEnd = nullptr;
+    closeDescriptor();
+}
+
+void InputReader::closeDescriptor() {
+    if (mOwnsDescriptor) ::close(mDescriptor);
+    mDescriptor = -1;
+    mOwnsDescriptor = false;
+}
+
+void InputReader::open(const int descriptor) {
+    close();
+    mDescriptor = descriptor;
+}
+
+bool InputReader::readChunk() {
+
+    /// Keep the content left to read at the beginning of the buffer
+    const std::size_t left = remainingSize();
+    if (left > 0u && mCursor != mBuffer.data()) std::memmove(mBuffer.data(), mCursor, left);
+    if (mBuffer.size() < left + C_CHUNK_SIZE) mBuffer.resize(left + C_CHUNK_SIZE);
+
+    ssize_t size;
+    do size = ::read(mDescriptor, mBuffer.data() + left, C_CHUNK_SIZE);
+    while (size < 0 && errno == EINTR);
+
+    mCursor = mBuffer.data();
+    mEnd = mCursor + left + (size > 0 ? size : 0);
+    if (size > 0) return true;
+
+    /// End of the descriptor, or error: the content already read is the last one
+    closeDescriptor();
+    return false;
+}
+
+void InputReader::fillLine() {
+    if (mDescriptor < 0) return;
+    skipEmptyLines();
+    while (!hasLine() && readChunk()) skipEmptyLines();
+}
+
+bool InputReader::hasLine() const {
+    return mDescriptor < 0 || (mCursor != mEnd && std::memchr(mCursor, '\n', remainingSize()) != nullptr);
+}
+
+bool InputReader::request(const std::size_t size) {
+    while (remainingSize() < size && mDescriptor >= 0) readChunk();
+    return remainingSize() >= size;
+}
+
+bool InputReader::open(const std::string &fileName) {
+
+    close();
+
+    /// Map the whole file in memory: pages are loaded by the system when needed, nothing is copied
+    const int descriptor = ::open(fileName.c_str(), O_RDONLY);
+    if (descriptor < 0) return false;
+
+    struct stat status{};
+    if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        void *mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, static_cast<std::size_t>(status.st_size), MADV_SEQUENTIAL);
+            mMapping = mapping;
+            mMappingSize = static_cast<std::size_t>(status.st_size);
+            mCursor = static_cast<const char *>(mMapping);
+            mEnd = mCursor + mMappingSize;
+        }
+    }
+
+    /// The file could not be mapped (empty file, pipe...): stream it by chunks instead, the reader closes it
+    if (mMapping == nullptr) {
+        mDescriptor = descriptor;
+        mOwnsDescriptor = true;
+        return true;
+    }
+    ::close(descriptor);
+
+    skipEmptyLines();
+    return true;
+}
+
+bool InputReader::atEnd() {
+    fillLine();
+    return mCursor == mEnd;
+}
+
+std::size_t InputReader::remainingSize() const {
+    return static_cast<std::size_t>(mEnd - mCursor);
+}
+
+void InputReader::skipEmptyLines() {
+    while (mCursor != mEnd && *mCursor == '\n') ++mCursor;
+}
+
+void InputReader::nextLine() {
+    /// Go after the end of the current line
+    while (mCursor != mEnd && *mCursor != '\n') ++mCursor;
+    skipEmptyLines();
+}
+
+std::string_view InputReader::remaining() const {
+    return {mCursor, remainingSize()};
+}
+
+void InputReader::advance(const std::size_t size) {
+    mCursor += std::min(size, remainingSize());
+}
+
+void InputReader::releaseConsumed() {
+    if (mMapping == nullptr) return;
+
+    /// Only whole pages are released, by large steps to limit the system calls
+    const auto consumed = static_cast<std::size_t>(mCursor - static_cast<const char *>(mMapping));
+    if (consumed - mReleasedSize < C_RELEASE_SIZE) return;
+    const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t releasedSize = consumed / pageSize * pageSize;
+    madvise(static_cast<char *>(mMapping) + mReleasedSize, releasedSize - mReleasedSize, MADV_DONTNEED);
+    mReleasedSize = releasedSize;
+}
+
+uint32_t InputReader::parseLine(uint32_t *values, const uint32_t maxValues) {
+
+    fillLine();
+    uint32_t nbValues = 0u;
+    const char *position = mCursor;
+
+    while (nbValues < maxValues) {
+
+        /// Skip the blanks between the integers, the line ends at the first line feed
+        while (position != mEnd && (*position == ' ' || *position == '\t' || *position == '\r' ||
+                                    *position == '\v' || *position == '\f'))
+            ++position;
+        if (position == mEnd || *position == '\n') break;
+
+        /// Optional sign, a negative value is wrapped as a stream would do
+        bool negative = false;
+        if (*position == '+' || *position == '-') {
+            negative = *position == '-';
+            ++position;
+        }
+
+        /// Scan the integer, stop reading the line at the first invalid data or on overflow
+        uint32_t value;
+        const auto [end, error] = std::from_chars(position, mEnd, value);
+        if (error != std::errc()) break;
+        position = end;
+
+        values[nbValues++] = negative ? 0u - value : value;
+    }
+
+    return nbValues;
+}
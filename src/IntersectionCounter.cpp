@@ -0,0 +1,136 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include "../headers/IntersectionCounter.h"
+
+void IntersectionCounter::setKernelMaxVertical(const std::size_t maxVertical) {
+    mKernelMaxVertical = maxVertical;
+}
+
+void IntersectionCounter::count(const std::span<const Segment> horizontal, const std::span<const Segment> vertical,
+                                int64_t &nbIntersection, uint32_t &row, uint32_t &column) {
+    sweep(horizontal, vertical, 0u, UINT32_MAX, nbIntersection, row, column);
+}
+
+void IntersectionCounter::count(const std::span<const Segment> horizontal, const std::span<const Segment> vertical,
+                                const uint32_t rowBegin, const uint32_t rowEnd, int64_t &nbIntersection, uint32_t &row,
+                                uint32_t &column) {
+
+    /// A vertical movement is active for the rows ]lo, hi[: keep the part active in the band, ]lo', hi'[ with
+    /// lo' = max(lo, rowBegin-1) and hi' = min(hi, rowEnd)
+    mClipped.clear();
+    for (const auto &segment: vertical) {
+        const uint32_t lo = rowBegin > 0u ? std::max(segment.lo, rowBegin - 1u) : segment.lo;
+        const uint32_t hi = std::min(segment.hi, rowEnd);
+        if (hi > lo + 1u) mClipped.push_back({segment.fixed, lo, hi});
+    }
+
+    sweep(horizontal, mClipped, rowBegin, rowEnd, nbIntersection, row, column);
+}
+
+void IntersectionCounter::sweep(const std::span<const Segment> horizontal, const std::span<const Segment> vertical,
+                                const uint32_t rowBegin, const uint32_t rowEnd, int64_t &nbIntersection, uint32_t &row,
+                                uint32_t &column) {
+
+    /// Nothing can intersect without both kind of movements
+    if (horizontal.empty() || vertical.empty()) return;
+
+    if (vertical.size() <= mKernelMaxVertical) {
+        crossKernel(horizontal, vertical, rowBegin, rowEnd, nbIntersection, row, column);
+        return;
+    }
+
+    /// Compress the columns of the vertical movements: the tree only depends on the number of movements
+    mTree.build(vertical);
+
+    /// A vertical movement is active for the rows strictly inside its outer points: added at lo+1, removed at hi
+    mEvents.clear();
+    for (uint32_t index = 0u; index < vertical.size(); ++index) {
+        if (vertical[index].hi - vertical[index].lo < 2u) continue;  ///< No row strictly inside
+        mEvents.push_back({vertical[index].lo + 1u, 0u, index});
+        mEvents.push_back({vertical[index].hi, 1u, index});
+    }
+    for (uint32_t index = 0u; index < horizontal.size(); ++index)
+        if (horizontal[index].fixed >= rowBegin && horizontal[index].fixed < rowEnd)
+            mEvents.push_back({horizontal[index].fixed, 2u, index});
+
+    std::sort(mEvents.begin(), mEvents.end(), [](const Event &first, const Event &second) {
+        return first.row < second.row || (first.row == second.row && first.kind < second.kind);
+    });
+
+    /// Sweep the rows in ascending order
+    for (const auto &event: mEvents) {
+
+        if (event.kind != 2u) {
+            /// Update the tree with the compressed column of the vertical movement
+            mTree.add(mTree.lowerBound(vertical[event.index].fixed), event.kind == 0u ? 1 : -1);
+            continue;
+        }
+
+        /// Count the active vertical movements between the outer points of the horizontal movement
+        const Segment &segment = horizontal[event.index];
+        const uint32_t first = mTree.lowerBound(segment.lo), last = mTree.upperBound(segment.hi);
+        if (first >= last) continue;
+
+        const int before = mTree.prefix(first);
+        const int crossings = mTree.prefix(last) - before;
+        if (crossings == 0) continue;
+
+        /// Intersections found, increase the number of intersections
+        nbIntersection += crossings;
+
+        /// Rows are swept in ascending order: only a row smaller or equal to the closest one can improve it.
+        /// The smallest crossing column of the movement is the first active column after its starting point.
+        if (segment.fixed <= row) {
+            const uint32_t crossColumn = mTree.column(mTree.find(before + 1));
+            if (segment.fixed < row || crossColumn < column) {
+                row = segment.fixed;
+                column = crossColumn;
+            }
+        }
+    }
+}
+
+void IntersectionCounter::crossKernel(const std::span<const Segment> horizontal,
+                                      const std::span<const Segment> vertical, const uint32_t rowBegin,
+                                      const uint32_t rowEnd, int64_t &nbIntersection, uint32_t &row, uint32_t &column) {
+
+    /// Pack the vertical movements sorted by column: the first movement crossed in a range of columns is the closest
+    mSorted.assign(vertical.begin(), vertical.end());
+    std::sort(mSorted.begin(), mSorted.end(), [](const Segment &first, const Segment &second) {
+        return first.fixed < second.fixed || (first.fixed == second.fixed && first.lo < second.lo);
+    });
+    mKernelColumns.resize(mSorted.size());
+    mKernelLo.resize(mSorted.size());
+    mKernelHi.resize(mSorted.size());
+    for (std::size_t index = 0u; index < mSorted.size(); ++index) {
+        mKernelColumns[index] = mSorted[index].fixed;
+        mKernelLo[index] = mSorted[index].lo;
+        mKernelHi[index] = mSorted[index].hi;
+    }
+
+    for (const auto &segment: horizontal) {
+        if (segment.fixed < rowBegin || segment.fixed >= rowEnd) continue;
+
+        /// Vertical movements in the columns of the horizontal movement, crossed if active on its row
+        const auto first = static_cast<uint32_t>(
+                std::lower_bound(mKernelColumns.begin(), mKernelColumns.end(), segment.lo) - mKernelColumns.begin());
+        const auto last = static_cast<uint32_t>(
+                std::upper_bound(mKernelColumns.begin(), mKernelColumns.end(), segment.hi) - mKernelColumns.begin());
+        if (first >= last) continue;
+
+        const CrossingKernel::Result crossings = CrossingKernel::cross(segment.fixed, mKernelLo.data() + first,
+                                                                       mKernelHi.data() + first, last - first);
+        if (crossings.count == 0u) continue;
+        nbIntersection += crossings.count;
+
+        /// Keep the closest intersection, as the sweep does
+        const uint32_t crossColumn = mKernelColumns[first + crossings.first];
+        if (segment.fixed < row || (segment.fixed == row && crossColumn < column)) {
+            row = segment.fixed;
+            column = crossColumn;
+        }
+    }
+}
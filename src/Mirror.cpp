@@ -34,29 +34,10 @@ uint32_t Mirror::row() const {
     return mRow;
 }
 
-Mirror::edirection Mirror::reflect(const Mirror::edirection incomingDirection) const {
+Mirror::emirrorKind Mirror::kind() const {
+    return mKind;
+}
 
-    /// By default the mirror does not reflect (pass-through). Behaviour associated with kind kindNone
-    edirection reflectedDirection = incomingDirection;
-
-    /// If mirror is of kind kindNone, no reflection: return here.
-    if(mKind == emirrorKind::eKindNone) return reflectedDirection;
-
-    /// For each incoming direction, associate a new direction (reflection) depending on the kind of mirror
-    /// (either rightLeft / or leftRight \)
-    switch (incomingDirection) {
-        case edirection::eDirUp :
-            reflectedDirection = mKind == emirrorKind::eKindRightLeft ? edirection::eDirRight : edirection::eDirLeft;
-            break;
-        case edirection::eDirDown :
-            reflectedDirection = mKind == emirrorKind::eKindRightLeft ? edirection::eDirLeft : edirection::eDirRight;
-            break;
-        case edirection::eDirLeft :
-            reflectedDirection = mKind == emirrorKind::eKindRightLeft ? edirection::eDirDown : edirection::eDirUp;
-            break;
-        case edirection::eDirRight :
-            reflectedDirection = mKind == emirrorKind::eKindRightLeft ? edirection::eDirUp : edirection::eDirDown;
-            break;
-    }
-    return reflectedDirection;
+Mirror::edirection Mirror::reflect(const Mirror::edirection incomingDirection) const {
+    return reflect(mKind, incomingDirection);
 }
@@ -0,0 +1,197 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <tuple>
+#include "../headers/MirrorIndex.h"
+
+/// Number of bits of a digit of the radix sort
+const uint32_t C_RADIX_BITS = 16u;
+
+/// Below this number of keys, a comparison sort is faster than the passes of the radix sort
+const uint32_t C_RADIX_MIN_SIZE = 1u << 12u;
+
+void MirrorIndex::radixSort() {
+
+    const auto size = static_cast<uint32_t>(mOrder.size());
+
+    if (size < C_RADIX_MIN_SIZE) {
+        /// Identifiers are given in increasing order: sorting the pairs by key then identifier keeps the sort stable
+        mPairs.resize(size);
+        for (uint32_t index = 0u; index < size; ++index) mPairs[index] = {mKeys[index], mOrder[index]};
+        std::sort(mPairs.begin(), mPairs.end());
+        for (uint32_t index = 0u; index < size; ++index) std::tie(mKeys[index], mOrder[index]) = mPairs[index];
+        return;
+    }
+
+    mKeysBuffer.resize(size);
+    mOrderBuffer.resize(size);
+    std::vector<uint32_t> &histogram = mHistogram;
+    histogram.resize(1u << C_RADIX_BITS);
+
+    for (uint32_t shift = 0u; shift < 64u; shift += C_RADIX_BITS) {
+
+        /// Count the occurrences of each digit
+        std::fill(histogram.begin(), histogram.end(), 0u);
+        for (const auto key: mKeys) ++histogram[(key >> shift) & ((1u << C_RADIX_BITS) - 1u)];
+
+        /// Every key has the same digit: the pass would not change the order
+        if (histogram[(mKeys.front() >> shift) & ((1u << C_RADIX_BITS) - 1u)] == size) continue;
+
+        /// Starting position of each digit
+        uint32_t position = 0u;
+        for (auto &count: histogram) {
+            const uint32_t digitCount = count;
+            count = position;
+            position += digitCount;
+        }
+
+        /// Stable distribution of the keys and identifiers
+        for (uint32_t index = 0u; index < size; ++index) {
+            const uint32_t target = histogram[(mKeys[index] >> shift) & ((1u << C_RADIX_BITS) - 1u)]++;
+            mKeysBuffer[target] = mKeys[index];
+            mOrderBuffer[target] = mOrder[index];
+        }
+        mKeys.swap(mKeysBuffer);
+        mOrder.swap(mOrderBuffer);
+    }
+}
+
+void MirrorIndex::build(const Safe::MirrorsView &mirrors, const std::array<uint32_t, 2> &laserPos,
+                        const std::array<uint32_t, 2> &detectorPos) {
+
+    /// The mirrors of the view are followed by the virtual mirrors of the laser and the detector
+    const auto nbMirrors = static_cast<uint32_t>(mirrors.size() + 2u);
+    const uint32_t laser = nbMirrors - 2u, detector = nbMirrors - 1u;
+    auto rowOf = [&](const uint32_t index) {
+        return index < laser ? mirrors.rows[index] : (index == laser ? laserPos[0] : detectorPos[0]);
+    };
+    auto columnOf = [&](const uint32_t index) {
+        return index < laser ? mirrors.columns[index] : (index == laser ? laserPos[1] : detectorPos[1]);
+    };
+
+    /// Sort the mirrors in row-major order. The sort is stable: mirrors at the same position keep their Safe order.
+    mKeys.resize(nbMirrors);
+    mOrder.resize(nbMirrors);
+    for (uint32_t index = 0u; index < nbMirrors; ++index) {
+        mKeys[index] = (static_cast<uint64_t>(rowOf(index)) << 32u) | columnOf(index);
+        mOrder[index] = index;
+    }
+    radixSort();
+
+    /// Store the mirrors in row-major order, only the last mirror is kept when several share the same position
+    mRows.clear();
+    mColumns.clear();
+    mKinds.clear();
+    for (uint32_t index = 0u; index < nbMirrors; ++index) {
+        if (index + 1u < nbMirrors && mKeys[index + 1u] == mKeys[index]) continue;  ///< Overwritten by a later mirror
+        const uint32_t mirror = mOrder[index];
+        mRows.push_back(rowOf(mirror));
+        mColumns.push_back(columnOf(mirror));
+        mKinds.push_back(mirror < laser ? mirrors.kinds[mirror] : Mirror::emirrorKind::eKindNone);
+        if (mirror == laser) mLaser = size() - 1u;
+        else if (mirror == detector) mDetector = size() - 1u;
+    }
+
+    /// Link the mirrors along the rows: neighbours in row-major order sharing the same row
+    const uint32_t nbIndexed = size();
+    mSteps.assign(4u * static_cast<std::size_t>(nbIndexed), C_NO_MIRROR);
+    for (uint32_t mirror = 0u; mirror + 1u < nbIndexed; ++mirror) {
+        if (mRows[mirror] != mRows[mirror + 1u]) continue;
+        mSteps[state(mirror, Mirror::edirection::eDirRight)] = mirror + 1u;
+        mSteps[state(mirror + 1u, Mirror::edirection::eDirLeft)] = mirror;
+    }
+
+    /// Sort the identifiers in column-major order, then link the neighbours sharing the same column
+    mKeys.resize(nbIndexed);
+    mOrder.resize(nbIndexed);
+    for (uint32_t mirror = 0u; mirror < nbIndexed; ++mirror) {
+        mKeys[mirror] = (static_cast<uint64_t>(mColumns[mirror]) << 32u) | mRows[mirror];
+        mOrder[mirror] = mirror;
+    }
+    radixSort();
+
+    for (uint32_t index = 0u; index + 1u < nbIndexed; ++index) {
+        const uint32_t upper = mOrder[index], lower = mOrder[index + 1u];
+        if (mColumns[upper] != mColumns[lower]) continue;
+        mSteps[state(upper, Mirror::edirection::eDirDown)] = lower;
+        mSteps[state(lower, Mirror::edirection::eDirUp)] = upper;
+    }
+
+    /// Reflect the beam on each closest mirror: the next state is the direction in which the beam leaves it
+    for (uint32_t current = 0u; current < mSteps.size(); ++current) {
+        const uint32_t closest = mSteps[current];
+        if (closest != C_NO_MIRROR)
+            mSteps[current] = state(closest, Mirror::reflect(mKinds[closest], direction(current)));
+    }
+}
+
+uint32_t MirrorIndex::closest(const uint32_t row, const uint32_t column, const Mirror::edirection direction) const {
+
+    /// Mirrors of a row are contiguous in row-major order, mirrors of a column in column-major order (mOrder)
+    const bool horizontal = direction == Mirror::edirection::eDirLeft || direction == Mirror::edirection::eDirRight;
+    const bool ascending = direction == Mirror::edirection::eDirRight || direction == Mirror::edirection::eDirDown;
+    const uint32_t line = horizontal ? row : column, position = horizontal ? column : row;
+    auto lineOf = [&](const uint32_t rank) { return horizontal ? mRows[rank] : mColumns[mOrder[rank]]; };
+    auto positionOf = [&](const uint32_t rank) { return horizontal ? mColumns[rank] : mRows[mOrder[rank]]; };
+
+    /// First mirror after the position going ascending, first mirror not before it going descending
+    uint32_t first = 0u, count = size();
+    while (count > 0u) {
+        const uint32_t half = count / 2u, middle = first + half;
+        const uint32_t middlePosition = positionOf(middle);
+        if (lineOf(middle) < line ||
+            (lineOf(middle) == line && (middlePosition < position || (ascending && middlePosition == position)))) {
+            first = middle + 1u;
+            count -= half + 1u;
+        } else count = half;
+    }
+
+    /// Going descending, the closest mirror is the one before
+    if (!ascending) {
+        if (first == 0u) return C_NO_MIRROR;
+        --first;
+    }
+    if (first >= size() || lineOf(first) != line) return C_NO_MIRROR;
+    return horizontal ? first : mOrder[first];
+}
+
+void MirrorIndex::findLoops(std::vector<uint8_t> &looping) const {
+
+    /// States not followed yet are unknown, states of the current beam are pending until its end is known
+    constexpr uint8_t C_UNKNOWN = 2u, C_PENDING = 3u;
+    looping.assign(mSteps.size(), C_UNKNOWN);
+    std::vector<uint32_t> beam;
+
+    for (uint32_t start = 0u; start < looping.size(); ++start) {
+        if (looping[start] != C_UNKNOWN) continue;
+
+        /// Follow the beam until it leaves the Safe, reaches a known state, or comes back to its first state
+        beam.clear();
+        uint32_t state = start;
+        while (state != C_NO_STATE && looping[state] == C_UNKNOWN) {
+            looping[state] = C_PENDING;
+            beam.push_back(state);
+            state = next(state);
+        }
+        uint8_t loops = 0u;
+        if (state != C_NO_STATE) loops = looping[state] == C_PENDING ? 1u : looping[state];
+        for (const uint32_t followed: beam) looping[followed] = loops;
+    }
+}
+
+uint32_t MirrorIndex::find(const uint32_t row, const uint32_t column) const {
+
+    /// First mirror not before the position in row-major order
+    uint32_t first = 0u, count = size();
+    while (count > 0u) {
+        const uint32_t half = count / 2u, middle = first + half;
+        if (mRows[middle] < row || (mRows[middle] == row && mColumns[middle] < column)) {
+            first = middle + 1u;
+            count -= half + 1u;
+        } else count = half;
+    }
+
+    return first < size() && mRows[first] == row && mColumns[first] == column ? first : C_NO_MIRROR;
+}
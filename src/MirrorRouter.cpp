@@ -0,0 +1,368 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <bit>
+#include "../headers/MirrorRouter.h"
+
+namespace {
+
+    /// Flag of the events removing a piece from the active pieces of a sweep
+    constexpr uint32_t C_REMOVE = 1u << 31u;
+
+    /**
+     * Direction from a cell to another cell of the same row or column
+     *
+     * @param fromRow, fromColumn: first cell
+     * @param toRow, toColumn: second cell
+     * @return direction of a beam going from the first cell to the second one
+     */
+    Mirror::edirection directionBetween(const uint32_t fromRow, const uint32_t fromColumn, const uint32_t toRow,
+                                        const uint32_t toColumn) {
+        if (fromRow == toRow)
+            return toColumn > fromColumn ? Mirror::edirection::eDirRight : Mirror::edirection::eDirLeft;
+        return toRow > fromRow ? Mirror::edirection::eDirDown : Mirror::edirection::eDirUp;
+    }
+
+    /**
+     * Check if a beam going in a direction goes towards the higher rows or columns
+     *
+     * @param direction: direction of the beam
+     * @return true for the right and down directions
+     */
+    bool towardsHigher(const Mirror::edirection direction) {
+        return direction == Mirror::edirection::eDirRight || direction == Mirror::edirection::eDirDown;
+    }
+}
+
+void MirrorRouter::ActiveSet::reset(const uint32_t size) {
+    mLevels.clear();
+    std::size_t nbWords = std::max<std::size_t>((static_cast<std::size_t>(size) + 63u) / 64u, 1u);
+    for (;;) {
+        mLevels.emplace_back(nbWords, 0u);
+        if (nbWords == 1u) break;
+        nbWords = (nbWords + 63u) / 64u;
+    }
+}
+
+void MirrorRouter::ActiveSet::insert(uint32_t index) {
+    for (auto &level: mLevels) {
+        uint64_t &word = level[index >> 6u];
+        const bool wasEmpty = word == 0u;
+        word |= uint64_t{1} << (index & 63u);
+        if (!wasEmpty) return;  ///< The upper levels already know the word
+        index >>= 6u;
+    }
+}
+
+void MirrorRouter::ActiveSet::erase(uint32_t index) {
+    for (auto &level: mLevels) {
+        uint64_t &word = level[index >> 6u];
+        word &= ~(uint64_t{1} << (index & 63u));
+        if (word != 0u) return;  ///< The word is still used by other indexes
+        index >>= 6u;
+    }
+}
+
+uint32_t MirrorRouter::ActiveSet::next(uint32_t index) const {
+    for (std::size_t level = 0u; level < mLevels.size(); ++level) {
+        const std::size_t word = index >> 6u;
+        if (word >= mLevels[level].size()) return C_NONE;
+        const uint64_t bits = (index & 63u) == 0u ? mLevels[level][word] :
+                              mLevels[level][word] & (~uint64_t{0} << (index & 63u));
+        if (bits != 0u) {
+            /// Go down to the first index of the non-empty word found
+            index = static_cast<uint32_t>(word << 6u) + static_cast<uint32_t>(std::countr_zero(bits));
+            for (std::size_t lower = level; lower > 0u; --lower)
+                index = (index << 6u) + static_cast<uint32_t>(std::countr_zero(mLevels[lower - 1u][index]));
+            return index;
+        }
+        /// Nothing left in the word: search the next non-empty word on the upper level
+        index = static_cast<uint32_t>(word + 1u);
+    }
+    return C_NONE;
+}
+
+void MirrorRouter::buildPieces(const MirrorIndex &index, const uint32_t rows, const uint32_t columns) {
+    const uint32_t nbMirrors = index.size();
+
+    /// Ranges of the rows, walking the mirrors in row-major order. Range identifiers start from 1.
+    mRowRanges.clear();
+    mMirrorRows.resize(nbMirrors);
+    uint32_t nextRow = 1u;
+    for (uint32_t mirror = 0u; mirror < nbMirrors; ++mirror) {
+        const uint32_t row = index.row(mirror);
+        if (row >= nextRow) {
+            if (row > nextRow) mRowRanges.push_back({nextRow, row - 1u});
+            mRowRanges.push_back({row, row});
+            nextRow = row + 1u;
+        }
+        mMirrorRows[mirror] = static_cast<uint32_t>(mRowRanges.size());
+    }
+    if (nextRow <= rows) mRowRanges.push_back({nextRow, rows});
+    const auto nbRowRanges = static_cast<uint32_t>(mRowRanges.size());
+
+    /// Ranges of the columns, walking the mirrors in column-major order. The laser and the detector are outside.
+    const std::span<const uint32_t> columnOrder = index.columnOrder();
+    mColumnRanges.clear();
+    mMirrorColumns.resize(nbMirrors);
+    uint32_t nextColumn = 1u;
+    for (const uint32_t mirror: columnOrder) {
+        const uint32_t column = index.column(mirror);
+        if (column == 0u || column > columns) continue;
+        if (column >= nextColumn) {
+            if (column > nextColumn) mColumnRanges.push_back({nextColumn, column - 1u});
+            mColumnRanges.push_back({column, column});
+            nextColumn = column + 1u;
+        }
+        mMirrorColumns[mirror] = static_cast<uint32_t>(mColumnRanges.size());
+    }
+    if (nextColumn <= columns) mColumnRanges.push_back({nextColumn, columns});
+    const auto nbColumnRanges = static_cast<uint32_t>(mColumnRanges.size());
+    for (const uint32_t mirror: columnOrder) {
+        if (index.column(mirror) == 0u) mMirrorColumns[mirror] = 0u;
+        else if (index.column(mirror) > columns) mMirrorColumns[mirror] = nbColumnRanges + 1u;
+    }
+
+    mPieces.clear();
+    mPieceOf.assign(4u * static_cast<std::size_t>(nbMirrors), C_NONE);
+    auto addPiece = [this](const uint32_t fixed, const uint32_t lo, const uint32_t hi, const uint32_t lowEnd,
+                           const uint32_t highEnd, const Mirror::edirection fromLow,
+                           const Mirror::edirection fromHigh) {
+        const auto piece = static_cast<uint32_t>(mPieces.size());
+        mPieces.push_back({fixed, lo, hi, {lowEnd, highEnd}});
+        if (lowEnd != C_NONE) mPieceOf[MirrorIndex::state(lowEnd, fromLow)] = piece;
+        if (highEnd != C_NONE) mPieceOf[MirrorIndex::state(highEnd, fromHigh)] = piece;
+    };
+
+    /// Pieces of the rows: between the consecutive mirrors of each row, a single piece for a range without mirror.
+    /// The laser and the detector replace the sides of their rows.
+    uint32_t mirror = 0u;
+    for (uint32_t range = 1u; range <= nbRowRanges; ++range) {
+        uint32_t lowEnd = C_NONE, lo = 0u;
+        for (; mirror < nbMirrors && mMirrorRows[mirror] == range; ++mirror) {
+            const uint32_t column = mMirrorColumns[mirror];
+            if (column > 0u)
+                addPiece(range, lo, column, lowEnd, mirror, Mirror::edirection::eDirRight,
+                         Mirror::edirection::eDirLeft);
+            lowEnd = mirror;
+            lo = column;
+        }
+        if (lo <= nbColumnRanges)
+            addPiece(range, lo, nbColumnRanges + 1u, lowEnd, C_NONE, Mirror::edirection::eDirRight,
+                     Mirror::edirection::eDirLeft);
+    }
+    mNbHorizontal = static_cast<uint32_t>(mPieces.size());
+
+    /// Pieces of the columns, the same way
+    std::size_t position = 0u;
+    while (position < columnOrder.size() && mMirrorColumns[columnOrder[position]] == 0u) ++position;
+    for (uint32_t range = 1u; range <= nbColumnRanges; ++range) {
+        uint32_t lowEnd = C_NONE, lo = 0u;
+        for (; position < columnOrder.size() && mMirrorColumns[columnOrder[position]] == range; ++position) {
+            const uint32_t current = columnOrder[position];
+            addPiece(range, lo, mMirrorRows[current], lowEnd, current, Mirror::edirection::eDirDown,
+                     Mirror::edirection::eDirUp);
+            lowEnd = current;
+            lo = mMirrorRows[current];
+        }
+        addPiece(range, lo, nbRowRanges + 1u, lowEnd, C_NONE, Mirror::edirection::eDirDown,
+                 Mirror::edirection::eDirUp);
+    }
+}
+
+Mirror::edirection MirrorRouter::directionOf(const uint32_t node) const {
+    const bool higher = (node & 1u) != 0u;
+    if ((node >> 1u) < mNbHorizontal) return higher ? Mirror::edirection::eDirRight : Mirror::edirection::eDirLeft;
+    return higher ? Mirror::edirection::eDirDown : Mirror::edirection::eDirUp;
+}
+
+uint32_t MirrorRouter::excludedOf(const uint32_t piece) const {
+    if (mParents[piece] == C_NONE) return C_NONE;
+    for (uint32_t node = 2u * piece; node < 2u * piece + 2u; ++node)
+        if (mLayers[node] == mFirstLayers[piece] && mPrevious[node] != C_TURN) return C_NONE;
+    return mParents[piece];
+}
+
+uint32_t MirrorRouter::reach(const MirrorIndex &index, uint32_t node, uint32_t previous, const uint32_t layer) {
+    while (mLayers[node] == C_NONE) {
+        mLayers[node] = layer;
+        mPrevious[node] = previous;
+        const uint32_t piece = node >> 1u;
+        if (mFirstLayers[piece] == C_NONE) {
+            mFirstLayers[piece] = layer;
+            mFrontier.push_back(piece);
+        }
+
+        /// A range without mirror is followed in both directions up to the sides of the Safe
+        if (isBundle(piece)) {
+            mLayers[node ^ 1u] = layer;
+            mPrevious[node ^ 1u] = previous;
+            return C_NONE;
+        }
+
+        /// Follow the beam through the mirror at the end of the piece
+        const uint32_t end = mPieces[piece].ends[node & 1u];
+        if (end == index.detector()) return node;
+        if (end == C_NONE || end == index.laser()) return C_NONE;
+        const Mirror::edirection direction = Mirror::reflect(index.kind(end), directionOf(node));
+        previous = node;
+        node = 2u * mPieceOf[MirrorIndex::state(end, direction)] + (towardsHigher(direction) ? 1u : 0u);
+    }
+    return C_NONE;
+}
+
+void MirrorRouter::sweep(const bool horizontal) {
+
+    /// A piece of the frontier is active for the ranges strictly between its ends
+    mEvents.clear();
+    for (const uint32_t piece: mFrontier) {
+        if ((piece < mNbHorizontal) != horizontal) continue;
+        const Piece &current = mPieces[piece];
+        if (current.lo + 1u >= current.hi) continue;  ///< No cell between the ends
+        mEvents.emplace_back(current.lo + 1u, piece);
+        mEvents.emplace_back(current.hi, piece | C_REMOVE);
+    }
+    if (mEvents.empty()) return;
+    std::sort(mEvents.begin(), mEvents.end());
+
+    /// Pieces of the other orientation, sorted by range as they were built
+    const uint32_t first = horizontal ? mNbHorizontal : 0u;
+    const uint32_t last = horizontal ? static_cast<uint32_t>(mPieces.size()) : mNbHorizontal;
+    std::size_t event = 0u;
+    uint32_t nbActive = 0u;
+    for (uint32_t piece = first; piece < last && event < mEvents.size(); ++piece) {
+
+        /// No active piece: skip the candidates before the next activation
+        if (nbActive == 0u && mPieces[piece].fixed < mEvents[event].first) {
+            piece = static_cast<uint32_t>(std::partition_point(
+                    mPieces.begin() + piece, mPieces.begin() + last, [&](const Piece &skipped) {
+                        return skipped.fixed < mEvents[event].first;
+                    }) - mPieces.begin());
+            if (piece == last) break;
+        }
+        if (mLayers[2u * piece] != C_NONE && mLayers[2u * piece + 1u] != C_NONE) continue;
+        const Piece &candidate = mPieces[piece];
+
+        /// Activate the frontier pieces crossing the range of the candidate
+        for (; event < mEvents.size() && mEvents[event].first <= candidate.fixed; ++event) {
+            const uint32_t active = mEvents[event].second & ~C_REMOVE;
+            if ((mEvents[event].second & C_REMOVE) != 0u) {
+                mActive.erase(mPieces[active].fixed);
+                --nbActive;
+            } else {
+                mActive.insert(mPieces[active].fixed);
+                ++nbActive;
+                mActivePieces[mPieces[active].fixed] = active;
+            }
+        }
+
+        /// First active piece strictly between the ends of the candidate which can turn on it
+        for (uint32_t range = mActive.next(candidate.lo + 1u); range != C_NONE && range < candidate.hi;
+             range = mActive.next(range + 1u)) {
+            if (excludedOf(mActivePieces[range]) == piece) continue;
+            mCrossings.emplace_back(piece, mActivePieces[range]);
+            break;
+        }
+    }
+
+    /// Empty the active set for the next sweep
+    for (; event < mEvents.size(); ++event)
+        if ((mEvents[event].second & C_REMOVE) != 0u) mActive.erase(mPieces[mEvents[event].second & ~C_REMOVE].fixed);
+}
+
+void MirrorRouter::placementsTo(uint32_t node, std::vector<Placement> &placements) const {
+    placements.clear();
+
+    /// Cell where the beam leaves the current piece by a turn, none at the detector
+    uint32_t nextRow = C_NONE, nextColumn = C_NONE;
+    while (mPrevious[node] != C_START) {
+        if (mPrevious[node] != C_TURN) {
+            node = mPrevious[node];
+            nextRow = nextColumn = C_NONE;
+            continue;
+        }
+
+        /// The beam turns from the parent piece on this cell. A range without mirror has no direction of its own.
+        const uint32_t piece = node >> 1u, parent = mParents[piece];
+        const uint32_t row = mCellRows[piece], column = mCellColumns[piece];
+        const Mirror::edirection outgoing = isBundle(piece) ? directionBetween(row, column, nextRow, nextColumn)
+                                                            : directionOf(node);
+
+        /// Node of the parent in the layer it was first reached: followed from its end if possible, otherwise from the
+        /// cell where the beam turned on it
+        uint32_t parentNode = C_NONE;
+        for (uint32_t candidate = 2u * parent; candidate < 2u * parent + 2u; ++candidate) {
+            if (mLayers[candidate] != mFirstLayers[parent]) continue;
+            if (mPrevious[candidate] != C_TURN) {
+                parentNode = candidate;
+                break;
+            }
+        }
+        Mirror::edirection incoming;
+        if (parentNode != C_NONE) incoming = directionOf(parentNode);
+        else {
+            incoming = directionBetween(mCellRows[parent], mCellColumns[parent], row, column);
+            parentNode = 2u * parent + (towardsHigher(incoming) ? 1u : 0u);
+        }
+
+        const Mirror::emirrorKind kind =
+                Mirror::reflect(Mirror::emirrorKind::eKindRightLeft, incoming) == outgoing ?
+                Mirror::emirrorKind::eKindRightLeft : Mirror::emirrorKind::eKindLeftRight;
+        placements.push_back({row, column, kind});
+        node = parentNode;
+        nextRow = row;
+        nextColumn = column;
+    }
+    std::reverse(placements.begin(), placements.end());
+}
+
+int64_t MirrorRouter::route(const MirrorIndex &index, const uint32_t rows, const uint32_t columns,
+                            std::vector<Placement> &placements) {
+    placements.clear();
+    buildPieces(index, rows, columns);
+
+    const auto nbPieces = static_cast<uint32_t>(mPieces.size());
+    mLayers.assign(2u * static_cast<std::size_t>(nbPieces), C_NONE);
+    mPrevious.assign(2u * static_cast<std::size_t>(nbPieces), C_NONE);
+    mFirstLayers.assign(nbPieces, C_NONE);
+    mParents.assign(nbPieces, C_NONE);
+    mCellRows.resize(nbPieces);
+    mCellColumns.resize(nbPieces);
+    const auto nbRanges = static_cast<uint32_t>(std::max(mRowRanges.size(), mColumnRanges.size()) + 2u);
+    mActive.reset(nbRanges);
+    mActivePieces.resize(nbRanges);
+
+    /// Layer 0: the laser beam without any added mirror
+    mFrontier.clear();
+    const uint32_t start = mPieceOf[MirrorIndex::state(index.laser(), Mirror::edirection::eDirRight)];
+    uint32_t goal = reach(index, 2u * start + 1u, C_START, 0u);
+
+    for (uint32_t layer = 1u; goal == C_NONE && !mFrontier.empty(); ++layer) {
+
+        /// Pieces crossing the pieces reached in the previous layer
+        mCrossings.clear();
+        sweep(true);
+        sweep(false);
+
+        /// Turn on each of them, in both directions, at the crossing
+        mFrontier.clear();
+        for (const auto &[piece, parent]: mCrossings) {
+            const uint32_t horizontalPiece = piece < mNbHorizontal ? piece : parent;
+            const uint32_t verticalPiece = piece < mNbHorizontal ? parent : piece;
+            for (uint32_t node = 2u * piece; node < 2u * piece + 2u && goal == C_NONE; ++node) {
+                if (mLayers[node] != C_NONE) continue;
+                mParents[piece] = parent;
+                mCellRows[piece] = mRowRanges[mPieces[horizontalPiece].fixed - 1u].first;
+                mCellColumns[piece] = mColumnRanges[mPieces[verticalPiece].fixed - 1u].first;
+                goal = reach(index, node, C_TURN, layer);
+            }
+            if (goal != C_NONE) break;
+        }
+    }
+
+    if (goal == C_NONE) return -1;
+    placementsTo(goal, placements);
+    return static_cast<int64_t>(placements.size());
+}
@@ -0,0 +1,185 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <iostream>
+#include "../headers/ReferenceSolver.h"
+
+bool ReferenceSolver::solve(const Safe &safe, int64_t &nbSolution, uint32_t &row, uint32_t &column) {
+
+    if (!draw(safe)) return false;
+
+    nbSolution = 0;
+    row = column = 0u;
+    if (reachesDetector()) return true;
+
+    /// Try both kinds of mirror on each empty cell, in lexicographic order
+    for (uint32_t cellRow = 1u; cellRow <= mRows; ++cellRow) {
+        for (uint32_t cellColumn = 1u; cellColumn <= mColumns; ++cellColumn) {
+            Mirror::emirrorKind &mirror = cell(cellRow, cellColumn);
+            if (mirror != Mirror::emirrorKind::eKindNone) continue;
+
+            bool opens = false;
+            for (const auto kind: {Mirror::emirrorKind::eKindRightLeft, Mirror::emirrorKind::eKindLeftRight}) {
+                mirror = kind;
+                opens = opens || reachesDetector();
+            }
+            mirror = Mirror::emirrorKind::eKindNone;
+
+            if (!opens) continue;
+            if (nbSolution == 0) {
+                row = cellRow;
+                column = cellColumn;
+            }
+            ++nbSolution;
+        }
+    }
+
+    if (nbSolution == 0) nbSolution = -1;
+    return true;
+}
+
+bool ReferenceSolver::checkCandidates(const Safe &safe, const std::span<const SafeBreaker::Candidate> candidates,
+                                      const std::span<SafeBreaker::ecandidate> answers) {
+
+    if (!draw(safe)) return false;
+
+    for (std::size_t index = 0u; index < candidates.size(); ++index) {
+        const SafeBreaker::Candidate &candidate = candidates[index];
+
+        if (candidate.row == 0u || candidate.column == 0u || candidate.row > mRows || candidate.column > mColumns ||
+            candidate.kind == Mirror::emirrorKind::eKindNone) {
+            answers[index] = SafeBreaker::ecandidate::eCandidateOutside;
+            continue;
+        }
+        Mirror::emirrorKind &mirror = cell(candidate.row, candidate.column);
+        if (mirror != Mirror::emirrorKind::eKindNone) {
+            answers[index] = SafeBreaker::ecandidate::eCandidateOccupied;
+            continue;
+        }
+
+        /// Place the mirror for a single simulation
+        mirror = candidate.kind;
+        answers[index] = reachesDetector() ? SafeBreaker::ecandidate::eCandidateOpens
+                                           : SafeBreaker::ecandidate::eCandidateCloses;
+        mirror = Mirror::emirrorKind::eKindNone;
+    }
+    return true;
+}
+
+bool ReferenceSolver::enumerateSolutions(const Safe &safe, const SolutionEnumerator::Sink &sink) {
+
+    if (!draw(safe)) return false;
+    if (reachesDetector()) return true;
+
+    for (uint32_t cellRow = 1u; cellRow <= mRows; ++cellRow) {
+        for (uint32_t cellColumn = 1u; cellColumn <= mColumns; ++cellColumn) {
+            Mirror::emirrorKind &mirror = cell(cellRow, cellColumn);
+            if (mirror != Mirror::emirrorKind::eKindNone) continue;
+
+            for (const auto kind: {Mirror::emirrorKind::eKindRightLeft, Mirror::emirrorKind::eKindLeftRight}) {
+                mirror = kind;
+                const bool opens = reachesDetector();
+                mirror = Mirror::emirrorKind::eKindNone;
+                if (opens) sink(cellRow, cellColumn, kind);
+            }
+        }
+    }
+    return true;
+}
+
+bool ReferenceSolver::minimumMirrors(const Safe &safe, const uint32_t maxMirrors, int64_t &minimum) {
+
+    if (!draw(safe)) return false;
+
+    /// Sets of increasing size: the first one opening the Safe is the smallest
+    for (uint32_t nbMirrors = 0u; nbMirrors <= maxMirrors; ++nbMirrors) {
+        if (placeMirrors(0u, nbMirrors)) {
+            minimum = nbMirrors;
+            return true;
+        }
+    }
+    minimum = -1;
+    return true;
+}
+
+bool ReferenceSolver::placeMirrors(const std::size_t first, const uint32_t nbMirrors) {
+    if (nbMirrors == 0u) return reachesDetector();
+
+    for (std::size_t index = first; index < mCells.size(); ++index) {
+        if (mCells[index] != Mirror::emirrorKind::eKindNone) continue;
+        for (const auto kind: {Mirror::emirrorKind::eKindRightLeft, Mirror::emirrorKind::eKindLeftRight}) {
+            mCells[index] = kind;
+            const bool opens = placeMirrors(index + 1u, nbMirrors - 1u);
+            mCells[index] = Mirror::emirrorKind::eKindNone;
+            if (opens) return true;
+        }
+    }
+    return false;
+}
+
+bool ReferenceSolver::checkPlacements(const Safe &safe, const std::span<const MirrorRouter::Placement> placements,
+                                      bool &opens) {
+
+    if (!draw(safe)) return false;
+
+    opens = false;
+    for (const MirrorRouter::Placement &placement: placements) {
+        /// A mirror outside the Safe, or on a cell already holding a mirror, does not open it
+        if (placement.row == 0u || placement.column == 0u || placement.row > mRows || placement.column > mColumns)
+            return true;
+        if (placement.kind == Mirror::emirrorKind::eKindNone ||
+            cell(placement.row, placement.column) != Mirror::emirrorKind::eKindNone)
+            return true;
+        cell(placement.row, placement.column) = placement.kind;
+    }
+    opens = reachesDetector();
+    return true;
+}
+
+bool ReferenceSolver::draw(const Safe &safe) {
+
+    if (static_cast<uint64_t>(safe.rows()) * safe.columns() > C_MAX_CELLS) {
+        std::cerr << "Safe of " << safe.rows() << "x" << safe.columns() << " cells too big for the reference solver !"
+                  << std::endl;
+        return false;
+    }
+
+    mRows = safe.rows();
+    mColumns = safe.columns();
+    mCells.assign(static_cast<std::size_t>(mRows) * mColumns, Mirror::emirrorKind::eKindNone);
+    const Safe::MirrorsView mirrors = safe.mirrors();
+    for (std::size_t mirror = 0u; mirror < mirrors.size(); ++mirror)
+        cell(mirrors.rows[mirror], mirrors.columns[mirror]) = mirrors.kinds[mirror];
+    return true;
+}
+
+bool ReferenceSolver::reachesDetector() const {
+
+    /// The laser enters the first row from the left
+    int64_t row = 1, column = 1;
+    auto direction = Mirror::edirection::eDirRight;
+
+    /// A beam never loops, since it starts from the outside: each cell is crossed at most once in each direction
+    for (uint64_t step = 0u; step <= 4u * static_cast<uint64_t>(mRows) * mColumns; ++step) {
+        if (row < 1 || row > mRows || column < 1 || column > mColumns)
+            return row == mRows && column == static_cast<int64_t>(mColumns) + 1;
+
+        direction = Mirror::reflect(mCells[static_cast<std::size_t>(row - 1) * mColumns + column - 1], direction);
+        switch (direction) {
+            case Mirror::edirection::eDirRight:
+                ++column;
+                break;
+            case Mirror::edirection::eDirLeft:
+                --column;
+                break;
+            case Mirror::edirection::eDirUp:
+                --row;
+                break;
+            case Mirror::edirection::eDirDown:
+                ++row;
+                break;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,215 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <tuple>
+#include "../headers/ResultCache.h"
+
+namespace {
+
+    /// Magic bytes and version of a cache file
+    constexpr std::array<char, 4> C_MAGIC = {'S', 'A', 'M', 'C'};
+    constexpr uint32_t C_VERSION = 2u;
+
+    /**
+     * Header of an entry in a cache file, followed by the rows, the columns and the kinds of the mirrors
+     */
+    struct FileEntry {
+        uint64_t low, high;  ///< Hash of the Safe
+        uint32_t rows, columns;  ///< Size of the Safe
+        uint32_t row, column;  ///< Closest solution
+        uint64_t nbMirrors;  ///< Number of mirrors
+        int64_t nbSolution;  ///< Result of the Safe
+    };
+    static_assert(sizeof(FileEntry) == 48u, "Cache file entries must not have padding");
+
+    /**
+     * Mix the bits of a value (finalizer of splitmix64): close values give unrelated hashes.
+     *
+     * @param value: value to mix
+     * @return mixed value
+     */
+    uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27u)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31u);
+    }
+
+    /**
+     * Retrieve the mirrors of a Safe as seen by the SafeBreaker: sorted by position, only the last mirror added on a
+     * position is kept.
+     *
+     * @param rows, columns, kinds: mirrors in the order they were added
+     * @return mirrors sorted by position
+     */
+    std::vector<std::tuple<uint32_t, uint32_t, Mirror::emirrorKind>> canonical(
+            const std::span<const uint32_t> rows, const std::span<const uint32_t> columns,
+            const std::span<const Mirror::emirrorKind> kinds) {
+        std::vector<uint32_t> order(rows.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [&](const uint32_t first, const uint32_t second) {
+            return std::tie(rows[first], columns[first]) < std::tie(rows[second], columns[second]);
+        });
+        std::vector<std::tuple<uint32_t, uint32_t, Mirror::emirrorKind>> mirrors;
+        for (std::size_t index = 0u; index < order.size(); ++index) {
+            const uint32_t mirror = order[index];
+            if (index + 1u < order.size() && rows[order[index + 1u]] == rows[mirror] &&
+                columns[order[index + 1u]] == columns[mirror])
+                continue;  ///< Overwritten by a later mirror
+            mirrors.emplace_back(rows[mirror], columns[mirror], kinds[mirror]);
+        }
+        return mirrors;
+    }
+}
+
+ResultCache::ResultCache(const std::size_t capacity) : mCapacity(capacity) {}
+
+void ResultCache::setCapacity(const std::size_t capacity) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCapacity.store(capacity);
+    while (mEntries.size() > capacity) remove(std::prev(mEntries.end()));
+}
+
+bool ResultCache::enabled() const {
+    return mCapacity.load() > 0u;
+}
+
+ResultCache::Key ResultCache::hash(const Safe &safe) {
+
+    /// Sum of the hash of each mirror, with two independent seeds: the order of the mirrors does not matter
+    const Safe::MirrorsView mirrors = safe.mirrors();
+    Key key;
+    for (std::size_t index = 0u; index < mirrors.size(); ++index) {
+        const uint64_t mirror = (static_cast<uint64_t>(mirrors.rows[index]) << 32u | mirrors.columns[index]) ^
+                                (static_cast<uint64_t>(mirrors.kinds[index]) << 62u);
+        key.low += mix(mirror ^ 0x9E3779B97F4A7C15ull);
+        key.high += mix(mirror ^ 0xD1B54A32D192ED03ull);
+    }
+
+    /// The size of the Safe and the number of mirrors complete the hash
+    const uint64_t size = static_cast<uint64_t>(safe.rows()) << 32u | safe.columns();
+    key.low = mix(key.low ^ mix(size) ^ mirrors.size());
+    key.high = mix(key.high ^ mix(size ^ 0x8CB92BA72F3D8DD7ull) ^ mirrors.size());
+    return key;
+}
+
+bool ResultCache::sameSafe(const Entry &entry, const Safe &safe) {
+    const Safe::MirrorsView mirrors = safe.mirrors();
+    if (entry.rows != safe.rows() || entry.columns != safe.columns() || entry.mirrorRows.size() != mirrors.size())
+        return false;
+
+    /// Same Safe resubmitted: the mirrors are usually given in the same order
+    if (std::equal(mirrors.rows.begin(), mirrors.rows.end(), entry.mirrorRows.begin()) &&
+        std::equal(mirrors.columns.begin(), mirrors.columns.end(), entry.mirrorColumns.begin()) &&
+        std::equal(mirrors.kinds.begin(), mirrors.kinds.end(), entry.kinds.begin()))
+        return true;
+
+    /// Otherwise compare the mirrors seen by the SafeBreaker
+    return canonical(entry.mirrorRows, entry.mirrorColumns, entry.kinds) ==
+           canonical(mirrors.rows, mirrors.columns, mirrors.kinds);
+}
+
+bool ResultCache::find(const Key &key, const Safe &safe, Result &result) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    const auto found = mIndex.find(key);
+    if (found == mIndex.end() || !sameSafe(*found->second, safe)) return false;
+
+    /// Most recently used entry
+    mEntries.splice(mEntries.begin(), mEntries, found->second);
+    result = found->second->result;
+    return true;
+}
+
+void ResultCache::insert(const Key &key, const Safe &safe, const Result &result) {
+    if (!enabled()) return;
+
+    const Safe::MirrorsView mirrors = safe.mirrors();
+    Entry entry{key, safe.rows(), safe.columns(), {mirrors.rows.begin(), mirrors.rows.end()},
+                {mirrors.columns.begin(), mirrors.columns.end()}, {mirrors.kinds.begin(), mirrors.kinds.end()}, result};
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    add(std::move(entry));
+}
+
+void ResultCache::add(Entry &&entry) {
+
+    /// A Safe bigger than the whole cache is not kept
+    if (entry.mirrorRows.size() > C_MAX_MIRRORS || mCapacity == 0u) return;
+
+    if (const auto found = mIndex.find(entry.key); found != mIndex.end()) remove(found->second);
+
+    mNbMirrors += entry.mirrorRows.size();
+    mEntries.push_front(std::move(entry));
+    mIndex[mEntries.front().key] = mEntries.begin();
+
+    while (mEntries.size() > mCapacity || mNbMirrors > C_MAX_MIRRORS) remove(std::prev(mEntries.end()));
+}
+
+void ResultCache::remove(const std::list<Entry>::iterator entry) {
+    mNbMirrors -= entry->mirrorRows.size();
+    mIndex.erase(entry->key);
+    mEntries.erase(entry);
+}
+
+bool ResultCache::load(const std::string &fileName) {
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file.is_open()) return true;  ///< No cache saved yet
+
+    std::array<char, 4> magic{};
+    uint32_t version = 0u;
+    file.read(magic.data(), magic.size());
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    if (!file || magic != C_MAGIC || version != C_VERSION) return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    /// Entries are saved the most recently used first: each one is added behind the previous ones
+    FileEntry header{};
+    while (mEntries.size() < mCapacity && file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        if (header.nbMirrors > C_MAX_MIRRORS) return false;
+        Entry entry{{header.low, header.high}, header.rows, header.columns, std::vector<uint32_t>(header.nbMirrors),
+                    std::vector<uint32_t>(header.nbMirrors), std::vector<Mirror::emirrorKind>(header.nbMirrors),
+                    {header.nbSolution, header.row, header.column}};
+        file.read(reinterpret_cast<char *>(entry.mirrorRows.data()),
+                  static_cast<std::streamsize>(header.nbMirrors * sizeof(uint32_t)));
+        file.read(reinterpret_cast<char *>(entry.mirrorColumns.data()),
+                  static_cast<std::streamsize>(header.nbMirrors * sizeof(uint32_t)));
+        file.read(reinterpret_cast<char *>(entry.kinds.data()),
+                  static_cast<std::streamsize>(header.nbMirrors * sizeof(Mirror::emirrorKind)));
+        if (!file) return false;
+        if (mIndex.count(entry.key) > 0u || mNbMirrors + header.nbMirrors > C_MAX_MIRRORS) continue;
+
+        mNbMirrors += header.nbMirrors;
+        mEntries.push_back(std::move(entry));
+        mIndex[mEntries.back().key] = std::prev(mEntries.end());
+    }
+    return true;
+}
+
+bool ResultCache::save(const std::string &fileName) {
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file.write(C_MAGIC.data(), C_MAGIC.size());
+    file.write(reinterpret_cast<const char *>(&C_VERSION), sizeof(C_VERSION));
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto &entry: mEntries) {
+        const FileEntry header{entry.key.low, entry.key.high, entry.rows, entry.columns, entry.result.row,
+                               entry.result.column, entry.mirrorRows.size(), entry.result.nbSolution};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(entry.mirrorRows.data()),
+                   static_cast<std::streamsize>(entry.mirrorRows.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char *>(entry.mirrorColumns.data()),
+                   static_cast<std::streamsize>(entry.mirrorColumns.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char *>(entry.kinds.data()),
+                   static_cast<std::streamsize>(entry.kinds.size() * sizeof(Mirror::emirrorKind)));
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,274 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <charconv>
+#include "../headers/ResultWriter.h"
+
+namespace {
+    /// Biggest number of solution (or of bytes) stored by a binary record
+    constexpr uint64_t C_MAX_BINARY_COUNT = (uint64_t{1} << 48u) - 1u;
+
+    /**
+     * Append an integer to a string without any temporary stream.
+     *
+     * @param text: string to append to
+     * @param value: integer to append
+     */
+    template<typename T>
+    void appendInteger(std::string &text, const T value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+    }
+}
+
+ResultWriter::~ResultWriter() {
+    close();
+}
+
+bool ResultWriter::open(const std::string &fileName, const eformat format) {
+    close();
+    mFormat = format;
+    mFile.open(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+    mLastFlush = std::chrono::steady_clock::now();
+    return mFile.is_open();
+}
+
+void ResultWriter::setFlushPolicy(const std::size_t flushBytes, const std::chrono::milliseconds flushInterval) {
+    mFlushBytes = flushBytes;
+    mFlushInterval = flushInterval;
+}
+
+void ResultWriter::formatText(std::string &text, const uint32_t caseId, const int64_t nbSolution, const uint32_t row,
+                              const uint32_t column) {
+    /// Basic state
+    text.append("Case ");
+    appendInteger(text, caseId);
+    text.append(": ");
+
+    /// If impossible to solve the case, add "impossible", otherwise add the number of solution
+    if (nbSolution < 0) text.append("impossible");
+    else appendInteger(text, nbSolution);
+
+    /// If at least one solution exist, add the position given in parameters
+    if (nbSolution > 0) {
+        text.push_back(' ');
+        appendInteger(text, row);
+        text.push_back(' ');
+        appendInteger(text, column);
+    }
+}
+
+void ResultWriter::write(const uint32_t caseId, const int64_t nbSolution, const uint32_t row, const uint32_t column) {
+
+    if (!mFile.is_open()) return;
+
+    const estatus status = nbSolution < 0 ? estatus::eStatusImpossible :
+                           (nbSolution == 0 ? estatus::eStatusOpened : estatus::eStatusSolutions);
+
+    switch (mFormat) {
+        case eformat::eFormatText:
+            formatText(mBuffer, caseId, nbSolution, row, column);
+            mBuffer.push_back('\n');
+            break;
+        case eformat::eFormatJsonLines:
+            mBuffer.append("{\"case\":");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(",\"status\":\"");
+            mBuffer.append(status == estatus::eStatusImpossible ? "impossible" :
+                           (status == estatus::eStatusOpened ? "opened" : "solutions"));
+            mBuffer.append("\",\"count\":");
+            appendInteger(mBuffer, nbSolution > 0 ? nbSolution : 0);
+            if (nbSolution > 0) {
+                mBuffer.append(",\"row\":");
+                appendInteger(mBuffer, row);
+                mBuffer.append(",\"column\":");
+                appendInteger(mBuffer, column);
+            }
+            mBuffer.append("}\n");
+            break;
+        case eformat::eFormatBinary: {
+            /// A count bigger than 48 bits (only possible on a large grid) is saturated
+            const uint64_t count = nbSolution > 0 ? std::min<uint64_t>(nbSolution, C_MAX_BINARY_COUNT) : 0u;
+            const BinaryRecord record{caseId, static_cast<uint32_t>(count), nbSolution > 0 ? row : 0u,
+                                      nbSolution > 0 ? column : 0u, status, 0u, static_cast<uint16_t>(count >> 32u)};
+            mBuffer.append(reinterpret_cast<const char *>(&record), sizeof(record));
+            break;
+        }
+    }
+
+    /// Flush when the buffer is full or the last flush is too old
+    if (mBuffer.size() >= mFlushBytes) flush();
+    else flushIfDue();
+}
+
+void ResultWriter::writeSolution(const uint32_t caseId, const uint32_t row, const uint32_t column, const bool slash) {
+
+    if (!mFile.is_open()) return;
+
+    switch (mFormat) {
+        case eformat::eFormatText:
+            mBuffer.append("Case ");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(" solution: ");
+            appendInteger(mBuffer, row);
+            mBuffer.push_back(' ');
+            appendInteger(mBuffer, column);
+            mBuffer.append(slash ? " /\n" : " \\\n");
+            break;
+        case eformat::eFormatJsonLines:
+            mBuffer.append("{\"case\":");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(",\"row\":");
+            appendInteger(mBuffer, row);
+            mBuffer.append(",\"column\":");
+            appendInteger(mBuffer, column);
+            mBuffer.append(slash ? ",\"kind\":\"/\"}\n" : ",\"kind\":\"\\\\\"}\n");
+            break;
+        case eformat::eFormatBinary: {
+            const BinaryRecord record{caseId, 0u, row, column, estatus::eStatusPlacement,
+                                      static_cast<uint8_t>(slash ? 0u : 1u), 0u};
+            mBuffer.append(reinterpret_cast<const char *>(&record), sizeof(record));
+            break;
+        }
+    }
+
+    if (mBuffer.size() >= mFlushBytes) flush();
+}
+
+void ResultWriter::writeMinimum(const uint32_t caseId, const int64_t nbMirrors,
+                                const std::span<const MirrorRouter::Placement> placements) {
+
+    if (!mFile.is_open()) return;
+
+    switch (mFormat) {
+        case eformat::eFormatText:
+            mBuffer.append("Case ");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(" minimum: ");
+            if (nbMirrors < 0) mBuffer.append("impossible");
+            else appendInteger(mBuffer, nbMirrors);
+            for (const auto &placement: placements) {
+                mBuffer.push_back(' ');
+                appendInteger(mBuffer, placement.row);
+                mBuffer.push_back(' ');
+                appendInteger(mBuffer, placement.column);
+                mBuffer.append(placement.kind == Mirror::emirrorKind::eKindRightLeft ? " /" : " \\");
+            }
+            mBuffer.push_back('\n');
+            break;
+        case eformat::eFormatJsonLines:
+            mBuffer.append("{\"case\":");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(",\"minimum\":");
+            appendInteger(mBuffer, nbMirrors);
+            mBuffer.append(",\"mirrors\":[");
+            for (std::size_t index = 0u; index < placements.size(); ++index) {
+                mBuffer.append(index == 0u ? "{\"row\":" : ",{\"row\":");
+                appendInteger(mBuffer, placements[index].row);
+                mBuffer.append(",\"column\":");
+                appendInteger(mBuffer, placements[index].column);
+                mBuffer.append(placements[index].kind == Mirror::emirrorKind::eKindRightLeft ? ",\"kind\":\"/\"}"
+                                                                                               : ",\"kind\":\"\\\\\"}");
+            }
+            mBuffer.append("]}\n");
+            break;
+        case eformat::eFormatBinary: {
+            const BinaryRecord record{caseId, nbMirrors > 0 ? static_cast<uint32_t>(nbMirrors) : 0u, 0u, 0u,
+                                      estatus::eStatusMinimum, 0u, 0u};
+            mBuffer.append(reinterpret_cast<const char *>(&record), sizeof(record));
+            for (const auto &placement: placements) {
+                const BinaryRecord mirror{caseId, 0u, placement.row, placement.column, estatus::eStatusPlacement,
+                                          static_cast<uint8_t>(placement.kind == Mirror::emirrorKind::eKindRightLeft ?
+                                                               0u : 1u), 0u};
+                mBuffer.append(reinterpret_cast<const char *>(&mirror), sizeof(mirror));
+            }
+            break;
+        }
+    }
+
+    if (mBuffer.size() >= mFlushBytes) flush();
+}
+
+void ResultWriter::writeMemory(const uint32_t caseId, const AllocationTracker::Usage &usage) {
+
+    if (!mFile.is_open()) return;
+
+    const uint64_t growth = usage.growthBytes();
+    switch (mFormat) {
+        case eformat::eFormatText:
+            mBuffer.append("Case ");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(" memory: peak ");
+            appendInteger(mBuffer, usage.peakBytes);
+            mBuffer.append(" bytes (+");
+            appendInteger(mBuffer, growth);
+            mBuffer.push_back(')');
+            for (std::size_t phase = 0u; phase < AllocationTracker::C_NB_PHASES; ++phase) {
+                mBuffer.append(", ");
+                mBuffer.append(AllocationTracker::phaseName(static_cast<AllocationTracker::ephase>(phase)));
+                mBuffer.push_back(' ');
+                appendInteger(mBuffer, usage.phases[phase].allocations);
+                mBuffer.append(" allocations ");
+                appendInteger(mBuffer, usage.phases[phase].bytes);
+                mBuffer.append(" bytes");
+            }
+            mBuffer.push_back('\n');
+            break;
+        case eformat::eFormatJsonLines:
+            mBuffer.append("{\"case\":");
+            appendInteger(mBuffer, caseId);
+            mBuffer.append(",\"peak_bytes\":");
+            appendInteger(mBuffer, usage.peakBytes);
+            mBuffer.append(",\"growth_bytes\":");
+            appendInteger(mBuffer, growth);
+            for (std::size_t phase = 0u; phase < AllocationTracker::C_NB_PHASES; ++phase) {
+                mBuffer.append(",\"");
+                mBuffer.append(AllocationTracker::phaseName(static_cast<AllocationTracker::ephase>(phase)));
+                mBuffer.append("\":{\"allocations\":");
+                appendInteger(mBuffer, usage.phases[phase].allocations);
+                mBuffer.append(",\"bytes\":");
+                appendInteger(mBuffer, usage.phases[phase].bytes);
+                mBuffer.push_back('}');
+            }
+            mBuffer.append("}\n");
+            break;
+        case eformat::eFormatBinary: {
+            const uint64_t peak = std::min<uint64_t>(usage.peakBytes, C_MAX_BINARY_COUNT);
+            const BinaryRecord record{caseId, static_cast<uint32_t>(peak), 0u, 0u, estatus::eStatusMemory, 0u,
+                                      static_cast<uint16_t>(peak >> 32u)};
+            mBuffer.append(reinterpret_cast<const char *>(&record), sizeof(record));
+            break;
+        }
+    }
+
+    if (mBuffer.size() >= mFlushBytes) flush();
+}
+
+void ResultWriter::flushIfDue() {
+    if (!mBuffer.empty() && std::chrono::steady_clock::now() - mLastFlush >= mFlushInterval) flush();
+}
+
+void ResultWriter::flush() {
+    if (mFile.is_open() && !mBuffer.empty()) {
+        mFile.write(mBuffer.data(), static_cast<std::streamsize>(mBuffer.size()));
+        mFile.flush();
+    }
+    mBuffer.clear();
+    mLastFlush = std::chrono::steady_clock::now();
+}
+
+void ResultWriter::close() {
+    flush();
+    if (mFile.is_open()) mFile.close();
+}
+
+bool ResultWriter::parseFormat(const std::string &name, eformat &format) {
+    if (name == "text") format = eformat::eFormatText;
+    else if (name == "jsonl") format = eformat::eFormatJsonLines;
+    else if (name == "binary") format = eformat::eFormatBinary;
+    else return false;
+    return true;
+}
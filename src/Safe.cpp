@@ -2,38 +2,58 @@
  * Created by Aurelien Chagnon
  */
 
+#include <algorithm>
 #include "../headers/Safe.h"
 
-/// Max number of mRows/mColumns
-const uint32_t C_MAX_LENGTH = 1000000u;
-
-Safe::Safe(const uint32_t nbRows, const uint32_t nbColumns) : mRows(nbRows), mColumns(nbColumns), mMirrors(){
+Safe::Safe(const uint32_t nbRows, const uint32_t nbColumns) : mRows(nbRows), mColumns(nbColumns), mMirrorRows(),
+mMirrorColumns(), mMirrorKinds(){
     /// Check validity of the number of mRows/mColumns
     if(nbRows > C_MAX_LENGTH || nbColumns > C_MAX_LENGTH || nbRows < 1u || nbColumns < 1u)
-        std::cerr << "Invalid number of row/column: expected between 1 and 1000000, got " << nbRows << " and " <<
-                  nbColumns << " instead." << std::endl;
+        std::cerr << "Invalid number of row/column: expected between 1 and " << C_MAX_LENGTH << ", got " << nbRows <<
+                  " and " << nbColumns << " instead." << std::endl;
+}
+
+void Safe::setLargeGrid(const bool largeGrid) {
+    mLargeGrid = largeGrid;
+}
+
+bool Safe::largeGrid() const {
+    return mLargeGrid;
+}
+
+void Safe::checkLength(const uint32_t length) const {
+    const uint32_t maxLength = mLargeGrid ? C_LARGE_MAX_LENGTH : C_MAX_LENGTH;
+    if (length > maxLength || length < 1u)
+        std::cerr << "Invalid number of row/column: expected between 1 and " << maxLength << ", got " << length <<
+                  " instead." << std::endl;
+}
+
+void Safe::checkNbMirrors(const std::size_t nbRightLeft, const std::size_t nbLeftRight) const {
+    if (mLargeGrid) {
+        /// Only the total is bounded, by the identifiers of the SafeBreaker
+        if (nbRightLeft + nbLeftRight > C_LARGE_MAX_MIRRORS)
+            std::cerr << "Number of mirrors should not be superior to " << C_LARGE_MAX_MIRRORS << " on a large grid !"
+                      << std::endl;
+    } else if (nbRightLeft > C_MAX_MIRRORS || nbLeftRight > C_MAX_MIRRORS)
+        std::cerr << "Number of mirrors should not be superior to " << C_MAX_MIRRORS << " for each kind !" << std::endl;
 }
 
 void Safe::setColumns(const uint32_t newColumns) {
     /// Check validity of the number of columns
-    if(newColumns > C_MAX_LENGTH || newColumns < 1u)
-        std::cerr << "Invalid number of column: expected between 1 and 1000000, got " << newColumns << " instead." <<
-                  std::endl;
+    checkLength(newColumns);
     mColumns = newColumns;  ///< Change the number of columns in the Safe
 
-    /// Remove mirrors that are outside the safe
-    mMirrors.remove_if([newColumns](Mirror mirr){ return mirr.column() > newColumns; });
+    /// Remove mirrors that are outside the safe, only if the safe is reduced below the position of a mirror
+    if (mMaxMirrorColumn > newColumns) removeOutsideMirrors();
 }
 
 void Safe::setRows(const uint32_t newRows) {
     /// Check validity of the number of rows
-    if(newRows > C_MAX_LENGTH || newRows < 1u)
-        std::cerr << "Invalid number of row/column: expected between 1 and 1000000, got " << newRows << " instead." <<
-                  std::endl;
+    checkLength(newRows);
     mRows = newRows;  ///< Change the number of rows in the Safe
 
-    /// Remove mirrors that are outside the safe
-    mMirrors.remove_if([newRows](Mirror mirr){ return mirr.row() > newRows; });
+    /// Remove mirrors that are outside the safe, only if the safe is reduced below the position of a mirror
+    if (mMaxMirrorRow > newRows) removeOutsideMirrors();
 }
 
 void Safe::setContext(const uint32_t contextRows, const uint32_t contextColumns) {
@@ -41,8 +61,26 @@ void Safe::setContext(const uint32_t contextRows, const uint32_t contextColumns)
     setColumns(contextColumns);  ///< Change the number of columns in the Safe
 }
 
-std::list<Mirror> Safe::mirrors() const{
-    return mMirrors;  ///< Return the list of mirrors inside the Safe
+Safe::MirrorsView Safe::mirrors() const{
+    return {mMirrorRows, mMirrorColumns, mMirrorKinds};  ///< Return a view of the mirrors inside the Safe
+}
+
+void Safe::removeOutsideMirrors() {
+    /// Compact the arrays, keeping the order of the mirrors inside the Safe, and compute the new biggest positions
+    std::size_t kept = 0u;
+    mMaxMirrorRow = mMaxMirrorColumn = 0u;
+    for (std::size_t index = 0u; index < mMirrorRows.size(); ++index) {
+        if (mMirrorRows[index] > mRows || mMirrorColumns[index] > mColumns) continue;
+        mMirrorRows[kept] = mMirrorRows[index];
+        mMirrorColumns[kept] = mMirrorColumns[index];
+        mMirrorKinds[kept] = mMirrorKinds[index];
+        mMaxMirrorRow = std::max(mMaxMirrorRow, mMirrorRows[kept]);
+        mMaxMirrorColumn = std::max(mMaxMirrorColumn, mMirrorColumns[kept]);
+        ++kept;
+    }
+    mMirrorRows.resize(kept);
+    mMirrorColumns.resize(kept);
+    mMirrorKinds.resize(kept);
 }
 
 uint32_t Safe::rows() const {
@@ -54,16 +92,60 @@ uint32_t Safe::columns() const {
 }
 
 void Safe::clearMirrors() {
-    mMirrors.clear();  ///< Clear the mirror list, now empty
+    /// Clear the mirror arrays, now empty. The memory is kept for the next mirrors.
+    mMirrorRows.clear();
+    mMirrorColumns.clear();
+    mMirrorKinds.clear();
+    mMaxMirrorRow = mMaxMirrorColumn = 0u;
+}
+
+void Safe::reserveMirrors(const std::size_t nbMirrors) {
+    mMirrorRows.reserve(nbMirrors);
+    mMirrorColumns.reserve(nbMirrors);
+    mMirrorKinds.reserve(nbMirrors);
 }
 
 void Safe::addMirror(const uint32_t rowPosition, const uint32_t columnPosition, const Mirror::emirrorKind kind) {
     if(rowPosition <= mRows && columnPosition <= mColumns && rowPosition > 0u && columnPosition > 0u) {
-        /// Create a new Mirror and push it back if the mirror is inside the Safe
-        mMirrors.emplace_back(rowPosition, columnPosition, kind);
+        /// Add the new mirror at the end of the arrays if the mirror is inside the Safe
+        mMirrorRows.push_back(rowPosition);
+        mMirrorColumns.push_back(columnPosition);
+        mMirrorKinds.push_back(kind);
+        mMaxMirrorRow = std::max(mMaxMirrorRow, rowPosition);
+        mMaxMirrorColumn = std::max(mMaxMirrorColumn, columnPosition);
     }
     else
         /// The mirror is outside the Safe, it is not created nor added to the list
         std::cerr << "New mirror (" << rowPosition << ", " << columnPosition <<
                   ") is outside the Safe, mirror not added !" << std::endl;
 }
+
+void Safe::assignMirrors(const std::span<const uint32_t> rows, const std::span<const uint32_t> columns,
+                         const std::size_t nbRightLeft) {
+    clearMirrors();
+
+    /// Smallest and biggest positions, checked against the Safe before copying
+    uint32_t minRow = UINT32_MAX, minColumn = UINT32_MAX;
+    for (std::size_t index = 0u; index < rows.size(); ++index) {
+        minRow = std::min(minRow, rows[index]);
+        minColumn = std::min(minColumn, columns[index]);
+        mMaxMirrorRow = std::max(mMaxMirrorRow, rows[index]);
+        mMaxMirrorColumn = std::max(mMaxMirrorColumn, columns[index]);
+    }
+
+    if (rows.empty() || (minRow > 0u && minColumn > 0u && mMaxMirrorRow <= mRows && mMaxMirrorColumn <= mColumns)) {
+        /// Every mirror is inside the Safe: copy the arrays at once
+        mMirrorRows.assign(rows.begin(), rows.end());
+        mMirrorColumns.assign(columns.begin(), columns.end());
+        mMirrorKinds.assign(rows.size(), Mirror::emirrorKind::eKindLeftRight);
+        std::fill_n(mMirrorKinds.begin(), std::min(nbRightLeft, rows.size()), Mirror::emirrorKind::eKindRightLeft);
+        return;
+    }
+
+    /// Some mirrors are outside the Safe: add them one by one to report and skip them
+    mMaxMirrorRow = mMaxMirrorColumn = 0u;
+    reserveMirrors(rows.size());
+    for (std::size_t index = 0u; index < rows.size(); ++index)
+        addMirror(rows[index], columns[index], index < nbRightLeft ? Mirror::emirrorKind::eKindRightLeft
+                                                                   : Mirror::emirrorKind::eKindLeftRight);
+}
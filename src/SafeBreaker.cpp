@@ -2,34 +2,73 @@
  * Created by Aurelien Chagnon
  */
 
+#include <algorithm>
+#include <memory>
+#include "../headers/AllocationTracker.h"
 #include "../headers/SafeBreaker.h"
 
-SafeBreaker::SafeBreaker(Safe safeToBreak): mSafe(std::move(safeToBreak)), mMirrorsInColumns(), mMirrorsInRows(),
-mForwardRows(), mForwardColumns(), mBackwardRows(), mBackwardColumns(){
+SafeBreaker::SafeBreaker(const Safe &safeToBreak) {
+    reset(safeToBreak);
+}
+
+void SafeBreaker::reset(const Safe &safeToBreak) {
+
+    /// Size of the Safe to open
+    mRows = safeToBreak.rows();
+    mColumns = safeToBreak.columns();
 
     /// Laser position: (row: 1, column: 0). Laser is considered being outside of the Safe
     mLaserPos = {1u, 0u};
 
     /// Detector position: (row: maxRow, column: maxColumn+1). Detector is considered being outside of the Safe
-    mDetectorPos = {mSafe.rows(), mSafe.columns() + 1u};
+    mDetectorPos = {mRows, mColumns + 1u};
 
-    /// Create two (2) maps to link non empty Rows/Columns to the ordered map of Mirrors contained in each one of them.
-    /// This helps reducing computing time when looking for the solutions to open the Safe.
-    for(auto &mirror: mSafe.mirrors()){
-        std::vector<uint32_t> position = mirror.position();
-        mMirrorsInRows[position.at(0)][position.at(1)] = mirror;  ///< operator [] automatically creates new entry
-        mMirrorsInColumns[position.at(1)][position.at(0)] = mirror;
+    /// Index the mirrors, sorted by rows and by columns, with the closest mirror in each direction.
+    /// The laser and the detector are represented by virtual mirrors. The mirrors of the Safe are read in place.
+    {
+        AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseIndex);
+        mMirrorIndex.build(safeToBreak.mirrors(), mLaserPos, mDetectorPos);
     }
 
-    /// Add virtual mirrors to represent the laser and the detector
-    mMirrorsInRows[1][0] = Mirror(mLaserPos, Mirror::emirrorKind::eKindNone);
-    mMirrorsInRows[mDetectorPos.at(0)][mDetectorPos.at(1)] = Mirror(mDetectorPos, Mirror::emirrorKind::eKindNone);
+    /// A trajectory can not reflect more than twice on the same mirror (once on each side): the number of segments of
+    /// a trajectory is bounded by twice the number of mirrors, plus the last movement to the end of the Safe.
+    const std::size_t maxSegments = 2u * mMirrorIndex.size() + 1u;
+    AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSegments);
+    mArena.reset();
+    mForward = {mArena.allocate<Segment>(maxSegments)};
+    mBackward = {mArena.allocate<Segment>(maxSegments)};
 }
 
-void SafeBreaker::solve(int &nbSolution, uint32_t &row, uint32_t &column){
+void SafeBreaker::setThreadPool(ThreadPool *pool) {
+    mPool = pool;
+}
+
+void SafeBreaker::setThresholds(const Thresholds &thresholds) {
+    mThresholds = thresholds;
+    mIntersectionCounter.setKernelMaxVertical(thresholds.kernelMaxVertical);
+    for (auto &counter: mBandCounters) counter.setKernelMaxVertical(thresholds.kernelMaxVertical);
+}
+
+void SafeBreaker::solve(int64_t &nbSolution, uint32_t &row, uint32_t &column){
+    solveCase<false>(nbSolution, row, column, nullptr);
+}
+
+void SafeBreaker::solve(int64_t &nbSolution, uint32_t &row, uint32_t &column, CaseStats &stats){
+    solveCase<true>(nbSolution, row, column, &stats);
+}
+
+template<bool WithStats>
+void SafeBreaker::solveCase(int64_t &nbSolution, uint32_t &row, uint32_t &column, CaseStats *stats){
+
+    /// Phases which may be skipped take no time
+    if constexpr (WithStats) stats->backwardNs = stats->intersectNs = 0u;
 
     /// Compute the Laser beam trajectory
-    const bool detectorReached = computeTrajectories();
+    bool detectorReached;
+    {
+        AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseSegments);
+        detectorReached = traceTrajectories<WithStats>(stats);
+    }
 
     /// Check if laser beam reaches detector already
     if(detectorReached){
@@ -40,194 +79,356 @@ void SafeBreaker::solve(int &nbSolution, uint32_t &row, uint32_t &column){
     else{
         /// Laser does not reach the detector, check intersections between the laser beam and the backward trajectory
         /// to determine the number of solutions and their positions
+        std::chrono::steady_clock::time_point start;
+        if constexpr (WithStats) start = std::chrono::steady_clock::now();
+        AllocationTracker::Scope scope(AllocationTracker::ephase::ePhaseIntersection);
         checkIntersections(nbSolution, row, column);
+        if constexpr (WithStats) stats->intersectNs = CaseStats::elapsedNs(start);
 
         /// No intersection: no solution, impossible to open the Safe
         if(nbSolution==0u) nbSolution = -1;
     }
+
+    /// Counters are deduced from the trajectories: every segment but the last one ends on a mirror, and each
+    /// horizontal segment is queried once against the vertical segments of the other trajectory.
+    if constexpr (WithStats) {
+        stats->segments = stats->mirrorsVisited = stats->columnsProbed = 0u;
+        for (const Trajectory *trajectory: {&mForward, &mBackward}) {
+            if (trajectory == &mBackward && detectorReached) break;  ///< No backward trajectory
+            const std::size_t nbSegments = trajectory->nbHorizontal + trajectory->nbVertical;
+            stats->segments += nbSegments;
+            stats->mirrorsVisited += nbSegments > 0u ? nbSegments - 1u : 0u;
+        }
+        if (!detectorReached) {
+            stats->columnsProbed = (mBackward.nbVertical ? mForward.nbHorizontal : 0u) +
+                                   (mForward.nbVertical ? mBackward.nbHorizontal : 0u);
+        }
+        stats->intersections = nbSolution > 0 ? static_cast<uint64_t>(nbSolution) : 0u;
+    }
 }
 
 bool SafeBreaker::computeTrajectories(){
+    return traceTrajectories<false>(nullptr);
+}
+
+template<bool WithStats>
+bool SafeBreaker::traceTrajectories(CaseStats *stats){
+
+    /// Big cases trace both trajectories at the same time when a pool is given
+    if (mPool != nullptr && mPool->size() > 1u && mMirrorIndex.size() >= mThresholds.parallelMinMirrors)
+        return traceTrajectoriesConcurrently<WithStats>(stats);
 
     /// Init status of reached detector by laser, false at the beginning
     bool detectorReached = false;
 
     /// Forward laser beam: start from the laser position and direction to the right.
-    std::vector<uint32_t> forwardPos(mLaserPos);  ///< By copy
-    Mirror::edirection forwardDir = Mirror::edirection::eDirRight;
-
     /// Compute laser trajectory
-    trajectoryTracking(mForwardRows, mForwardColumns, forwardPos, forwardDir);
+    std::chrono::steady_clock::time_point start;
+    if constexpr (WithStats) start = std::chrono::steady_clock::now();
+    const std::array<uint32_t, 2> forwardPos = trajectoryTracking(mForward, mMirrorIndex.laser(),
+                                                                  Mirror::edirection::eDirRight);
+    if constexpr (WithStats) stats->forwardNs = CaseStats::elapsedNs(start);
 
     /// Check if detector is reached by laser, ie the laser beam has stopped in the detector position
     if(forwardPos == mDetectorPos) detectorReached = true;  ///< Detector reached by Laser
     else{
         /// The detector is not reached by the laser, compute the backward trajectory.
         /// "Backward" laser beam: start from detector position and direction to the left.
-        std::vector<uint32_t> backwardPos(mDetectorPos);  ///< By copy
-        Mirror::edirection backwardDir = Mirror::edirection::eDirLeft;
-
         /// Compute backward trajectory
-        trajectoryTracking(mBackwardRows, mBackwardColumns, backwardPos, backwardDir);
+        if constexpr (WithStats) start = std::chrono::steady_clock::now();
+        trajectoryTracking(mBackward, mMirrorIndex.detector(), Mirror::edirection::eDirLeft);
+        if constexpr (WithStats) stats->backwardNs = CaseStats::elapsedNs(start);
     }
 
     return detectorReached;
 }
 
-void SafeBreaker::trajectoryTracking(std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>>& rows,
-                                      std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>>& columns,
-                                      std::vector<uint32_t>& currentPos,
-                                      Mirror::edirection& currentDirection) {
-
-    /// Create a virtual mirror to represent the end of Safe when no mirror is in the path
-    std::vector<uint32_t> endOfSafe = {0, 0};
-
-    /// Index indicating which part of the position of mirrors is discriminating in the search. Either 0 or 1.
-    /// Ex:
-    /// If the direction is to the right, the search occurs in a single precise row.
-    /// Thus the index indicates that the discriminating data is the column position on this row.
-    uint8_t index;
-
-    /// Pointer to the list of Mirror to search in: the list should represent a single row or column for optimization time
-    const std::map<uint32_t, Mirror> *searchVector;
-
-    /// Map of segments to add the new movement segment to.
-    std::list<std::vector<uint32_t>> *segmentMap;
-
-    /// If the end of the Safe has not been reached, ie the trajectory is not over, redo operation
-    while (currentPos != endOfSafe) {
-
-        /// Set the endOfSafe at current position before computation of exact position
-        endOfSafe = currentPos;
-
-        /// Determine the position of the end of the Safe, the list of mirror to search in (the row or column) and the index
-        /// depending on the incoming direction of the laser beam.
-        /// Note: the [] operator creates a new empty list if the key is unknown, ie there is no mirror in this row/column.
-        switch (currentDirection) {
-            case Mirror::edirection::eDirLeft:
-                endOfSafe.at(1) = 0u;  ///< End at the far left of the Safe (outside)
-                searchVector = &mMirrorsInRows[currentPos.at(0)];  ///< Get the row where the current position is
-                index = 1u;  ///< Indicates the columns
-                segmentMap = &rows[currentPos.at(0)];  ///< Movement will be added in the rows map
-                break;
-            case Mirror::edirection::eDirRight:
-                endOfSafe.at(1) = mSafe.columns() + 1u;  ///< End at the far right of the Safe (outside)
-                searchVector = &mMirrorsInRows[currentPos.at(0)];  ///< Get the row where the current position is
-                index = 1u;  ///< Indicates the columns
-                segmentMap = &rows[currentPos.at(0)];  ///< Movement will be added in the rows map
-                break;
-            case Mirror::edirection::eDirUp:
-                endOfSafe.at(0) = 0u;  ///< End at the top of the Safe (outside)
-                searchVector = &mMirrorsInColumns[currentPos.at(1)];  ///< Get the column where the current position is
-                index = 0u;  ///< Indicates the rows
-                segmentMap = &columns[currentPos.at(1)];  ///< Movement will be added in the columns map
-                break;
-            case Mirror::edirection::eDirDown:
-                endOfSafe.at(0) = mSafe.rows() + 1u;  ///< End at the bottom of the Safe (outside)
-                searchVector = &mMirrorsInColumns[currentPos.at(1)];  ///< Get the column where the current position is
-                index = 0u;  ///< Indicates the rows
-                segmentMap = &columns[currentPos.at(1)];  ///< Movement will be added in the columns map
-                break;
+template<bool WithStats>
+bool SafeBreaker::traceTrajectoriesConcurrently(CaseStats *stats) {
+
+    /// The backward trajectory is offered to the workers. Only a claimed trajectory reads the breaker, which waits for it.
+    const auto progress = std::make_shared<TraceProgress>();
+    mPool->submit([this, progress]() {
+        if (progress->claimed.exchange(true)) return;
+        std::chrono::steady_clock::time_point start;
+        if constexpr (WithStats) start = std::chrono::steady_clock::now();
+        trajectoryTracking(mBackward, mMirrorIndex.detector(), Mirror::edirection::eDirLeft, &progress->cancelled);
+        if constexpr (WithStats) progress->backwardNs = CaseStats::elapsedNs(start);
+        progress->finished.store(true, std::memory_order_release);
+        progress->finished.notify_all();
+    });
+
+    /// Forward laser beam, in the calling thread
+    std::chrono::steady_clock::time_point start;
+    if constexpr (WithStats) start = std::chrono::steady_clock::now();
+    const bool detectorReached = trajectoryTracking(mForward, mMirrorIndex.laser(), Mirror::edirection::eDirRight) ==
+                                 mDetectorPos;
+    if constexpr (WithStats) stats->forwardNs = CaseStats::elapsedNs(start);
+
+    /// The backward trajectory is not needed anymore if the detector is reached
+    if (detectorReached) progress->cancelled.store(true);
+
+    /// No worker has started the backward trajectory: compute it here, or make sure no worker will start it
+    if (!progress->claimed.exchange(true)) {
+        if (!detectorReached) {
+            if constexpr (WithStats) start = std::chrono::steady_clock::now();
+            trajectoryTracking(mBackward, mMirrorIndex.detector(), Mirror::edirection::eDirLeft);
+            if constexpr (WithStats) stats->backwardNs = CaseStats::elapsedNs(start);
         }
+        return detectorReached;
+    }
 
-        /// The next mirror is at the end of the Safe before the search.
-        /// If it stays the same after the search, the trajectory has stopped.
-        Mirror nextMirror(endOfSafe, Mirror::emirrorKind::eKindNone);
-
-        /// Get the current mirror at current position.
-        auto currentMirror = searchVector->find(currentPos[index]);
-
-        /// Retrieve next mirror in path according to direction
-        switch (currentDirection) {
-            case Mirror::edirection::eDirRight:
-            case Mirror::edirection::eDirDown:
-                /// Next mirror is next in the list, if exists. Remember, list.end() is not in the list itself.
-                ++currentMirror;
-                if (currentMirror != searchVector->end()) nextMirror = currentMirror->second;
-                break;
-            case Mirror::edirection::eDirUp:
-            case Mirror::edirection::eDirLeft:
-                /// Next mirror is previous in the list, if exists. List.begin() is part of the list itself.
-                if (currentMirror != searchVector->begin()) {
-                    --currentMirror;
-                    nextMirror = currentMirror->second;
-                }
-                break;
-        }
+    /// Wait for the worker computing the backward trajectory, stopped early if cancelled
+    progress->finished.wait(false, std::memory_order_acquire);
+    if constexpr (WithStats) {
+        if (!detectorReached) stats->backwardNs = progress->backwardNs;
+    }
+    return detectorReached;
+}
+
+template<bool AlongRow>
+bool SafeBreaker::move(Trajectory &trajectory, uint32_t &state, std::array<uint32_t, 2> &endPos) const {
+
+    /// Current position, on a mirror (or the laser/detector)
+    const uint32_t currentMirror = MirrorIndex::mirror(state);
+    const uint32_t row = mMirrorIndex.row(currentMirror), column = mMirrorIndex.column(currentMirror);
+
+    /// Next mirror in path and the direction it reflects the beam to: a single access in the index
+    const uint32_t nextState = mMirrorIndex.next(state);
+    const uint32_t nextMirror = MirrorIndex::mirror(nextState);
+
+    /// Position of the next step: the next mirror or the end of the Safe (outside) when no mirror is in the path.
+    /// Only the column changes along a row, only the row along a column.
+    std::array<uint32_t, 2> nextPos{row, column};
+    if constexpr (AlongRow) {
+        nextPos[1] = nextState != MirrorIndex::C_NO_STATE ? mMirrorIndex.column(nextMirror) :
+                     MirrorIndex::direction(state) == Mirror::edirection::eDirRight ? mColumns + 1u : 0u;
+        if (nextPos[1] != column)
+            trajectory.buffer[trajectory.nbHorizontal++] = {row, std::min(column, nextPos[1]), std::max(column, nextPos[1])};
+    } else {
+        nextPos[0] = nextState != MirrorIndex::C_NO_STATE ? mMirrorIndex.row(nextMirror) :
+                     MirrorIndex::direction(state) == Mirror::edirection::eDirDown ? mRows + 1u : 0u;
+        if (nextPos[0] != row)
+            trajectory.buffer[trajectory.buffer.size() - ++trajectory.nbVertical] = {column, std::min(row, nextPos[0]),
+                                                                                      std::max(row, nextPos[0])};
+    }
+
+    /// The end of the Safe, or the laser or the detector on its border, has been reached: the trajectory is over
+    if (nextState == MirrorIndex::C_NO_STATE || nextMirror == mMirrorIndex.laser() ||
+        nextMirror == mMirrorIndex.detector()) {
+        endPos = nextPos;
+        return false;
+    }
 
-        /// Add movement in the associated segment map
-        const std::pair<uint32_t, uint32_t> minmaxPosition = std::minmax({currentPos.at(index),
-                                                                          nextMirror.position().at(index)});
-        segmentMap->push_back({minmaxPosition.first, minmaxPosition.second});
+    /// Move to the next mirror, in the direction reflected by the mirror
+    state = nextState;
+    return true;
+}
 
-        /// Move to the next step (mirror or end of Safe)
-        currentPos = nextMirror.position();
+std::array<uint32_t, 2> SafeBreaker::trajectoryTracking(Trajectory &trajectory, const uint32_t currentMirror,
+                                                        const Mirror::edirection currentDirection,
+                                                        const std::atomic<bool> *cancelled) {
 
-        /// Get the new direction for the next step
-        currentDirection = nextMirror.reflect(currentDirection);
+    /// The trajectory starts empty
+    trajectory.nbHorizontal = trajectory.nbVertical = 0u;
+
+    /// Follow the links of the index until there is no more mirror in the path. Every mirror turns the beam: movements
+    /// alternate between a row and a column, so the axis of each movement is known at compile time.
+    uint32_t state = MirrorIndex::state(currentMirror, currentDirection);
+    std::array<uint32_t, 2> endPos{};
+    for (uint32_t step = 1u;; ++step) {
+
+        /// A cancelled trajectory stops where it is, its segments are not used
+        if (cancelled != nullptr && step % C_CANCEL_INTERVAL == 0u && cancelled->load(std::memory_order_relaxed))
+            return {mMirrorIndex.row(MirrorIndex::mirror(state)), mMirrorIndex.column(MirrorIndex::mirror(state))};
+
+        if (!move<true>(trajectory, state, endPos)) return endPos;
+        if (!move<false>(trajectory, state, endPos)) return endPos;
     }
 }
 
-void SafeBreaker::getIntersection(const std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>>& rowsMap,
-                                  const std::unordered_map<uint32_t, std::list<std::vector<uint32_t>>>& columnsMap,
-                                  int& nbIntersection, std::vector<uint32_t*>& closestIntersection) {
+void SafeBreaker::checkIntersections(int64_t &nbIntersection, uint32_t &row, uint32_t &column) {
 
-    /// For movements in the rows, find movements in the columns that can intersect with the row
-    for(const auto& [row, listOfMovementsInRows]:rowsMap) {
-        for(const auto& moveInRow: listOfMovementsInRows){
+    /// At beginning, consider the Safe impossible to open with closest solution being the farthest position possible
+    nbIntersection = 0;
+    row = mRows;
+    column = mColumns;
+
+    /// Big cases are split into bands of rows when a pool is given
+    const std::size_t nbSegments = mForward.nbHorizontal + mForward.nbVertical + mBackward.nbHorizontal +
+                                   mBackward.nbVertical;
+    if (mPool != nullptr && mPool->size() > 1u && nbSegments >= mThresholds.parallelMinSegments) {
+        checkIntersectionsByBands(nbIntersection, row, column);
+        return;
+    }
 
-            /// Find movements in columns
-            for (uint32_t column = moveInRow.at(0); column <= moveInRow.at(1) ; ++column) {
+    /// Compute the intersection between movement along mRows during forward trajectory
+    /// and movement along mColumns during backward trajectory
+    mIntersectionCounter.count(mForward.horizontal(), mBackward.vertical(), nbIntersection, row, column);
 
-                /// Find if a list of movements exists in this given column
-                auto listOfMovementsInCol = columnsMap.find(column);
+    /// Compute the intersection between movement along mColumns during forward trajectory
+    /// and movement along mRows during backward trajectory
+    mIntersectionCounter.count(mBackward.horizontal(), mForward.vertical(), nbIntersection, row, column);
 
-                /// A list of movement has been found in the column
-                if(listOfMovementsInCol != columnsMap.end()){
+}
 
-                    /// Check for each movements if they intersect the row. Break when one is found (is unique).
-                    for(const auto &moveInCol: listOfMovementsInCol->second){
+void SafeBreaker::checkIntersectionsByBands(int64_t &nbIntersection, uint32_t &row, uint32_t &column) {
 
-                        /// The movement intersects the row if and only if the row is between its starting and stopping point
-                        const std::pair<uint32_t, uint32_t> minmaxPos = std::minmax({moveInCol.at(0),
-                                                                                     moveInCol.at(1),
-                                                                                     row});
-                        if((minmaxPos.first != row) && (minmaxPos.second != row)){
+    /// Bands of rows holding about the same number of horizontal movements, from a sample of their rows. Each pair of
+    /// trajectories has one band per worker: a vertical movement crossing several bands is counted in each of them.
+    const uint32_t nbBands = mPool->size();
+    std::vector<uint32_t> sample;
+    for (const Trajectory *trajectory: {&mForward, &mBackward}) {
+        const std::span<const Segment> horizontal = trajectory->horizontal();
+        const std::size_t step = std::max<std::size_t>(1u, horizontal.size() / 1024u);
+        for (std::size_t index = 0u; index < horizontal.size(); index += step) sample.push_back(horizontal[index].fixed);
+    }
+    std::sort(sample.begin(), sample.end());
 
-                            /// Intersection found, increase the number of intersections
-                            ++nbIntersection;
+    std::vector<uint32_t> limits = {0u};
+    for (uint32_t band = 1u; band < nbBands && !sample.empty(); ++band) {
+        const uint32_t limit = sample[sample.size() * band / nbBands];
+        if (limit > limits.back()) limits.push_back(limit);
+    }
+    limits.push_back(mRows + 2u);  ///< After the last row of the movements, ie the virtual row below the Safe
+
+    mBands.clear();
+    for (uint32_t pair = 0u; pair < 2u; ++pair)
+        for (std::size_t band = 0u; band + 1u < limits.size(); ++band)
+            mBands.push_back({pair, limits[band], limits[band + 1u], 0, mRows, mColumns});
+    if (mBandCounters.size() < mBands.size()) {
+        mBandCounters.resize(mBands.size());
+        for (auto &counter: mBandCounters) counter.setKernelMaxVertical(mThresholds.kernelMaxVertical);
+    }
 
-                            /// Check if the new intersection is the closest so far, keep it in memory if true.
-                            if((row <= *closestIntersection.at(0)) && (column <= *closestIntersection.at(1))) {
-                                *closestIntersection.at(0) = row;
-                                *closestIntersection.at(1) = column;
-                            }
+    /// Execute the next bands until none is left. Only a claimed band reads the breaker, which waits for it.
+    const auto progress = std::make_shared<BandProgress>();
+    const auto total = static_cast<uint32_t>(mBands.size());
+    auto executeBands = [this, progress, total]() {
+        for (uint32_t index = progress->next.fetch_add(1u); index < total; index = progress->next.fetch_add(1u)) {
+            Band &band = mBands[index];
+            const Trajectory &rows = band.pair == 0u ? mForward : mBackward;
+            const Trajectory &columns = band.pair == 0u ? mBackward : mForward;
+            mBandCounters[index].count(rows.horizontal(), columns.vertical(), band.rowBegin, band.rowEnd,
+                                       band.nbIntersection, band.row, band.column);
+            if (progress->finished.fetch_add(1u, std::memory_order_acq_rel) + 1u == total)
+                progress->finished.notify_all();
+        }
+    };
+    for (uint32_t worker = 1u; worker < mPool->size(); ++worker) mPool->submit(executeBands);
+    executeBands();
+
+    /// Wait for the bands still executed by the workers
+    for (uint32_t finished = progress->finished.load(std::memory_order_acquire); finished < total;
+         finished = progress->finished.load(std::memory_order_acquire))
+        progress->finished.wait(finished);
+
+    /// Merge the bands: the total count, and the lexicographically smallest of the closest intersections
+    for (const auto &band: mBands) {
+        nbIntersection += band.nbIntersection;
+        if (band.nbIntersection > 0 && (band.row < row || (band.row == row && band.column < column))) {
+            row = band.row;
+            column = band.column;
+        }
+    }
+}
 
-                            /// There can only have one intersection between a given row and a given column,
-                            /// break the loop search when found.
-                            break;
-                        }
-                    }
+void SafeBreaker::checkCandidates(const std::span<const Candidate> candidates, const std::span<ecandidate> answers) {
+
+    /// Both trajectories are needed, even if the laser reaches the detector. The loops are only found if needed.
+    mLoopingStates.clear();
+    const bool detectorReached = trajectoryTracking(mForward, mMirrorIndex.laser(), Mirror::edirection::eDirRight) ==
+                                 mDetectorPos;
+    trajectoryTracking(mBackward, mMirrorIndex.detector(), Mirror::edirection::eDirLeft);
+    mForwardCells.build(mForward.horizontal(), mForward.vertical(), mLaserPos);
+    mBackwardCells.build(mBackward.horizontal(), mBackward.vertical(), mDetectorPos);
+
+    for (std::size_t index = 0u; index < candidates.size(); ++index) {
+        const Candidate &candidate = candidates[index];
+
+        if (candidate.row == 0u || candidate.column == 0u || candidate.row > mRows || candidate.column > mColumns ||
+            candidate.kind == Mirror::emirrorKind::eKindNone)
+            answers[index] = ecandidate::eCandidateOutside;
+        else if (mMirrorIndex.find(candidate.row, candidate.column) != MirrorIndex::C_NO_MIRROR)
+            answers[index] = ecandidate::eCandidateOccupied;
+        else {
+            /// The laser beam is unchanged if it does not pass on the cell
+            const CandidateIndex::Visit forward = mForwardCells.firstVisit(candidate.row, candidate.column);
+            bool opens = detectorReached;
+            if (forward.step != CandidateIndex::C_NOT_VISITED) {
+                const CandidateIndex::Visit backward = mBackwardCells.firstVisit(candidate.row, candidate.column);
+                const Mirror::edirection reflected = Mirror::reflect(candidate.kind, forward.direction);
+                if (!detectorReached) {
+                    /// Reflected on the cell, the beam follows the backward trajectory in reverse up to the detector
+                    opens = backward.step != CandidateIndex::C_NOT_VISITED &&
+                            reflected == Mirror::opposite(backward.direction);
+                } else {
+                    /// The backward trajectory is the laser beam in reverse: its first passage is the last one of the
+                    /// laser beam. Otherwise, the reflected beam comes back only around a loop of mirrors.
+                    opens = (backward.direction != forward.direction &&
+                             backward.direction != Mirror::opposite(forward.direction)) ||
+                            loops(candidate.row, candidate.column, reflected);
                 }
             }
+            answers[index] = opens ? ecandidate::eCandidateOpens : ecandidate::eCandidateCloses;
         }
     }
 }
 
-void SafeBreaker::checkIntersections(int &nbIntersection, uint32_t &row, uint32_t &column) const{
+bool SafeBreaker::loops(const uint32_t row, const uint32_t column, const Mirror::edirection direction) {
+    if (mLoopingStates.empty()) mMirrorIndex.findLoops(mLoopingStates);
 
-    /// At beginning, consider the Safe impossible to open with closest solution being the farthest position possible
-    nbIntersection = 0;
-    row = mSafe.rows();
-    column = mSafe.columns();
-    std::vector<uint32_t*> closestSolution = {&row, &column};
+    /// The beam leaving the cell reaches the closest mirror, or leaves the Safe
+    const uint32_t mirror = mMirrorIndex.closest(row, column, direction);
+    if (mirror == MirrorIndex::C_NO_MIRROR) return false;
+    const Mirror::edirection reflected = Mirror::reflect(mMirrorIndex.kind(mirror), direction);
+    return mLoopingStates[MirrorIndex::state(mirror, reflected)] == 1u;
+}
 
-    /// Compute the intersection between movement along mRows during forward trajectory
-    /// and movement along mColumns during backward trajectory
-    getIntersection(mForwardRows, mBackwardColumns, nbIntersection, closestSolution);
+uint64_t SafeBreaker::enumerateSolutions(const SolutionEnumerator::Sink &sink) {
 
-    /// Compute the intersection between movement along mColumns during forward trajectory
-    /// and movement along mRows during backward trajectory
-    getIntersection(mBackwardRows, mForwardColumns, nbIntersection, closestSolution);
+    /// Placing a mirror cannot improve a laser already reaching the detector: no solution is enumerated
+    if (trajectoryTracking(mForward, mMirrorIndex.laser(), Mirror::edirection::eDirRight) == mDetectorPos) return 0u;
+    trajectoryTracking(mBackward, mMirrorIndex.detector(), Mirror::edirection::eDirLeft);
+
+    movementDirections(mForward, mLaserPos, mForwardDirections);
+    movementDirections(mBackward, mDetectorPos, mBackwardDirections);
+
+    const std::size_t nbForward = mForward.nbHorizontal, nbBackward = mBackward.nbHorizontal;
+    return mSolutionEnumerator.enumerate(
+            {mForward.horizontal(), std::span(mForwardDirections).first(nbForward),
+             mForward.vertical(), std::span(mForwardDirections).subspan(nbForward)},
+            {mBackward.horizontal(), std::span(mBackwardDirections).first(nbBackward),
+             mBackward.vertical(), std::span(mBackwardDirections).subspan(nbBackward)},
+            sink);
+}
 
+int64_t SafeBreaker::minimumMirrors(std::vector<MirrorRouter::Placement> &placements) {
+    return mMirrorRouter.route(mMirrorIndex, mRows, mColumns, placements);
+}
+
+void SafeBreaker::movementDirections(const Trajectory &trajectory, std::array<uint32_t, 2> start,
+                                     std::vector<Mirror::edirection> &directions) {
+
+    /// Movements along the rows and the columns alternate, starting along a row. The direction of a movement is given by
+    /// the outer point it starts from.
+    const std::span<const Segment> horizontal = trajectory.horizontal(), vertical = trajectory.vertical();
+    directions.resize(horizontal.size() + vertical.size());
+    for (std::size_t step = 0u; step < directions.size(); ++step) {
+        if (step % 2u == 0u) {
+            if (step / 2u >= horizontal.size()) break;  ///< Should never be reached, movements alternate
+            const Segment &segment = horizontal[step / 2u];
+            const bool right = segment.lo == start[1];
+            directions[step / 2u] = right ? Mirror::edirection::eDirRight : Mirror::edirection::eDirLeft;
+            start[1] = right ? segment.hi : segment.lo;
+        } else {
+            if (step / 2u >= vertical.size()) break;  ///< Should never be reached, movements alternate
+            /// Vertical movements are stored from the end of the buffer, ie in reverse order of the trajectory
+            const std::size_t index = vertical.size() - 1u - step / 2u;
+            const Segment &segment = vertical[index];
+            const bool down = segment.lo == start[0];
+            directions[horizontal.size() + index] = down ? Mirror::edirection::eDirDown : Mirror::edirection::eDirUp;
+            start[0] = down ? segment.hi : segment.lo;
+        }
+    }
 }
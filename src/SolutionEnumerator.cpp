@@ -0,0 +1,116 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include "../headers/SolutionEnumerator.h"
+
+uint64_t SolutionEnumerator::enumerate(const Movements &forward, const Movements &backward, const Sink &sink) {
+
+    /// Pair 0: forward rows with backward columns, pair 1: backward rows with forward columns
+    const std::array<const Movements *, 2> rows = {&forward, &backward}, columns = {&backward, &forward};
+
+    mEvents.clear();
+    for (uint32_t pair = 0u; pair < 2u; ++pair) {
+        mTrees[pair].build(columns[pair]->vertical);
+        mActiveDirections[pair].assign(mTrees[pair].size(), Mirror::edirection::eDirDown);
+
+        /// A vertical movement is active for the rows strictly inside its outer points: added at lo+1, removed at hi
+        const std::span<const Segment> vertical = columns[pair]->vertical;
+        for (uint32_t index = 0u; index < vertical.size(); ++index) {
+            if (vertical[index].hi - vertical[index].lo < 2u) continue;  ///< No row strictly inside
+            mEvents.push_back({vertical[index].lo + 1u, 0u, pair, 0u, index});
+            mEvents.push_back({vertical[index].hi, 1u, pair, 0u, index});
+        }
+        const std::span<const Segment> horizontal = rows[pair]->horizontal;
+        for (uint32_t index = 0u; index < horizontal.size(); ++index)
+            mEvents.push_back({horizontal[index].fixed, 2u, pair, horizontal[index].lo, index});
+    }
+
+    std::sort(mEvents.begin(), mEvents.end(), [](const Event &first, const Event &second) {
+        if (first.row != second.row) return first.row < second.row;
+        if (first.kind != second.kind) return first.kind < second.kind;
+        if (first.pair != second.pair) return first.pair < second.pair;
+        return first.lo < second.lo;
+    });
+
+    /**
+     * Stream of the crossings of a pair in a row: the queried horizontal movements are disjoint and sorted by column, and
+     * the crossings of a movement are the active columns of ranks ]before, after] in the tree.
+     */
+    struct Stream {
+        std::size_t event;  ///< Next query event of the pair
+        std::size_t end;  ///< End of the query events of the pair
+        int rank;  ///< Rank of the current crossing in the tree
+        int last;  ///< Rank of the last crossing of the current movement
+        uint32_t compressed;  ///< Compressed column of the current crossing
+    };
+
+    uint64_t nbSolution = 0u;
+    std::size_t event = 0u;
+    while (event < mEvents.size()) {
+
+        const uint32_t row = mEvents[event].row;
+
+        /// Update the trees with the compressed column of the vertical movements, keeping their direction
+        for (; event < mEvents.size() && mEvents[event].row == row && mEvents[event].kind != 2u; ++event) {
+            const Event &update = mEvents[event];
+            ColumnTree &tree = mTrees[update.pair];
+            const uint32_t compressed = tree.lowerBound(columns[update.pair]->vertical[update.index].fixed);
+            tree.add(compressed, update.kind == 0u ? 1 : -1);
+            if (update.kind == 0u)
+                mActiveDirections[update.pair][compressed] = columns[update.pair]->verticalDirections[update.index];
+        }
+
+        /// Split the queries of the row by pair
+        std::array<Stream, 2> streams{};
+        for (uint32_t pair = 0u; pair < 2u; ++pair) {
+            streams[pair].event = event;
+            for (; event < mEvents.size() && mEvents[event].row == row && mEvents[event].pair == pair; ++event);
+            streams[pair].end = event;
+        }
+
+        /// Move a stream to its next crossing, false when the stream is exhausted
+        auto advance = [&](const uint32_t pair) {
+            Stream &stream = streams[pair];
+            const ColumnTree &tree = mTrees[pair];
+            while (stream.rank >= stream.last) {
+                if (stream.event == stream.end) return false;
+                const Segment &segment = rows[pair]->horizontal[mEvents[stream.event++].index];
+                const uint32_t first = tree.lowerBound(segment.lo), last = tree.upperBound(segment.hi);
+                if (first >= last) continue;
+                stream.rank = tree.prefix(first);
+                stream.last = tree.prefix(last);
+            }
+            stream.compressed = tree.find(++stream.rank);
+            return true;
+        };
+
+        /// Merge both streams by column, the pair of the forward rows first on the same cell
+        std::array<bool, 2> pending = {advance(0u), advance(1u)};
+        while (pending[0] || pending[1]) {
+            const uint32_t pair =
+                    !pending[1] || (pending[0] && mTrees[0].column(streams[0].compressed) <=
+                                                  mTrees[1].column(streams[1].compressed)) ? 0u : 1u;
+            const Stream &stream = streams[pair];
+            const uint32_t column = mTrees[pair].column(stream.compressed);
+
+            /// The mirror sends the forward beam into the opposite of the beam coming from the detector
+            const Mirror::edirection horizontalDirection =
+                    rows[pair]->horizontalDirections[mEvents[stream.event - 1u].index];
+            const Mirror::edirection verticalDirection = mActiveDirections[pair][stream.compressed];
+            const Mirror::edirection forwardDirection = pair == 0u ? horizontalDirection : verticalDirection;
+            const Mirror::edirection backwardDirection = pair == 0u ? verticalDirection : horizontalDirection;
+            const Mirror::emirrorKind kind =
+                    Mirror::reflect(Mirror::emirrorKind::eKindRightLeft, forwardDirection) ==
+                    Mirror::opposite(backwardDirection) ? Mirror::emirrorKind::eKindRightLeft
+                                                        : Mirror::emirrorKind::eKindLeftRight;
+
+            sink(row, column, kind);
+            ++nbSolution;
+            pending[pair] = advance(pair);
+        }
+    }
+
+    return nbSolution;
+}
@@ -0,0 +1,144 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../headers/ResultWriter.h"
+#include "../headers/SolverDaemon.h"
+
+SolverDaemon::SolverDaemon(const uint32_t nbThreads) : mPool(nbThreads) {}
+
+void SolverDaemon::setCache(const std::size_t capacity) {
+    mCache.setCapacity(capacity);
+}
+
+void SolverDaemon::setLargeGrid(const bool largeGrid) {
+    mLargeGrid = largeGrid;
+}
+
+std::unique_ptr<SafeBreaker> SolverDaemon::takeBreaker() {
+    {
+        std::lock_guard<std::mutex> lock(mBreakersMutex);
+        if (!mBreakers.empty()) {
+            std::unique_ptr<SafeBreaker> breaker = std::move(mBreakers.back());
+            mBreakers.pop_back();
+            return breaker;
+        }
+    }
+    auto breaker = std::make_unique<SafeBreaker>();
+    breaker->setThreadPool(&mPool);
+    return breaker;
+}
+
+void SolverDaemon::releaseBreaker(std::unique_ptr<SafeBreaker> breaker) {
+    std::lock_guard<std::mutex> lock(mBreakersMutex);
+    mBreakers.push_back(std::move(breaker));
+}
+
+bool SolverDaemon::send(const int output, const std::string &content) {
+    for (std::size_t written = 0u; written < content.size();) {
+        const ssize_t size = ::write(output, content.data() + written, content.size() - written);
+        if (size < 0 && errno == EINTR) continue;
+        if (size <= 0) return false;
+        written += static_cast<std::size_t>(size);
+    }
+    return true;
+}
+
+void SolverDaemon::serveStream(const int input, const int output) {
+    std::unique_ptr<SafeBreaker> breaker = takeBreaker();
+    CaseReader reader;
+    reader.setLargeGrid(mLargeGrid);
+    reader.open(input);
+
+    std::shared_ptr<Safe> safe;
+    std::string results;
+    bool connected = true;
+    for (uint32_t caseId = 0u; connected && reader.nextCase(safe); ++caseId) {
+
+        /// Solve the case, unless the same Safe has already been solved
+        ResultCache::Result result;
+        const ResultCache::Key key = mCache.enabled() ? ResultCache::hash(*safe) : ResultCache::Key{};
+        if (!mCache.enabled() || !mCache.find(key, *safe, result)) {
+            breaker->reset(*safe);
+            breaker->solve(result.nbSolution, result.row, result.column);
+            if (mCache.enabled()) mCache.insert(key, *safe, result);
+        }
+
+        ResultWriter::formatText(results, caseId, result.nbSolution, result.row, result.column);
+        results.push_back('\n');
+
+        /// Send the results before waiting for the next case, or when many are buffered
+        if (!reader.hasCase() || results.size() >= C_SEND_BYTES) {
+            connected = send(output, results);
+            results.clear();
+        }
+    }
+    if (connected) send(output, results);
+
+    releaseBreaker(std::move(breaker));
+}
+
+bool SolverDaemon::serve(const std::string &socketPath) {
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Invalid socket path " << socketPath << " !" << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1u);
+
+    /// A socket left by a previous daemon is replaced, any other file is kept
+    struct stat status{};
+    if (stat(socketPath.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            std::cerr << "File " << socketPath << " already exists and is not a socket !" << std::endl;
+            return false;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0 || bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on socket " << socketPath << ": " << std::strerror(errno) << " !" << std::endl;
+        if (listener >= 0) ::close(listener);
+        return false;
+    }
+
+    /// A client closing its connection early must not stop the daemon
+    std::signal(SIGPIPE, SIG_IGN);
+
+    /// One thread per connection, the breakers and the workers are shared
+    for (;;) {
+        const int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::cerr << "Cannot accept a connection on socket " << socketPath << ": " << std::strerror(errno) << " !"
+                      << std::endl;
+            break;
+        }
+        mNbConnections.fetch_add(1u);
+        std::thread([this, connection]() {
+            serveStream(connection, connection);
+            ::close(connection);
+            if (mNbConnections.fetch_sub(1u) == 1u) mNbConnections.notify_all();
+        }).detach();
+    }
+
+    /// Wait for the connections being served: they use the daemon
+    ::close(listener);
+    unlink(socketPath.c_str());
+    for (uint32_t nbConnections = mNbConnections.load(); nbConnections > 0u; nbConnections = mNbConnections.load())
+        mNbConnections.wait(nbConnections);
+    return false;
+}
@@ -0,0 +1,377 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+#include "../headers/SolverSession.h"
+
+namespace {
+    /// Number of bits of a digit of the radix sort
+    const uint32_t C_RADIX_BITS = 16u;
+
+    /// Below this number of movements, a comparison sort is faster than the passes of the radix sort
+    const std::size_t C_RADIX_MIN_SIZE = 1u << 12u;
+
+    /**
+     * Check if a direction is along a row
+     *
+     * @param direction: direction to check
+     * @return true for left or right
+     */
+    bool isHorizontal(const Mirror::edirection direction) {
+        return direction == Mirror::edirection::eDirLeft || direction == Mirror::edirection::eDirRight;
+    }
+}
+
+SolverSession::SolverSession(const Safe &safe) : mRows(safe.rows()), mColumns(safe.columns()) {
+
+    /// Laser at the left of the first row, detector at the right of the last row, both outside of the Safe
+    mLaserPos = {1u, 0u};
+    mDetectorPos = {mRows, mColumns + 1u};
+
+    /// Map the mirrors in their rows and columns, a later mirror replaces an earlier one at the same position
+    const Safe::MirrorsView mirrors = safe.mirrors();
+    for (std::size_t index = 0u; index < mirrors.size(); ++index) {
+        mMirrorsInRows[mirrors.rows[index]][mirrors.columns[index]] = mirrors.kinds[index];
+        mMirrorsInColumns[mirrors.columns[index]][mirrors.rows[index]] = mirrors.kinds[index];
+    }
+
+    /// Both trajectories are always kept: the backward one is needed as soon as the detector is not reached anymore
+    trace(mForward, mLaserPos, Mirror::edirection::eDirRight);
+    trace(mBackward, mDetectorPos, Mirror::edirection::eDirLeft);
+    index(mForward, 0u);
+    index(mBackward, 0u);
+}
+
+bool SolverSession::addMirror(const uint32_t row, const uint32_t column, const Mirror::emirrorKind kind) {
+
+    if (row == 0u || column == 0u || row > mRows || column > mColumns) {
+        std::cerr << "New mirror (" << row << ", " << column << ") is outside the Safe, mirror not added !" << std::endl;
+        return false;
+    }
+    if (kind == Mirror::emirrorKind::eKindNone) return false;  ///< Not a mirror
+
+    /// Insert the mirror, or change the kind of the mirror already there
+    const auto [mirror, inserted] = mMirrorsInRows[row].try_emplace(column, kind);
+    if (!inserted) {
+        if (mirror->second == kind) return false;  ///< Same mirror, nothing changes
+        mirror->second = kind;
+    }
+    mMirrorsInColumns[column][row] = kind;
+
+    mWork = 0u;
+    retrace(mForward, mBackward, row, column);
+    retrace(mBackward, mForward, row, column);
+    return true;
+}
+
+bool SolverSession::removeMirror(const uint32_t row, const uint32_t column) {
+
+    const auto rowMirrors = mMirrorsInRows.find(row);
+    if (rowMirrors == mMirrorsInRows.end() || rowMirrors->second.erase(column) == 0u) return false;
+    if (rowMirrors->second.empty()) mMirrorsInRows.erase(rowMirrors);
+
+    const auto columnMirrors = mMirrorsInColumns.find(column);
+    columnMirrors->second.erase(row);
+    if (columnMirrors->second.empty()) mMirrorsInColumns.erase(columnMirrors);
+
+    mWork = 0u;
+    retrace(mForward, mBackward, row, column);
+    retrace(mBackward, mForward, row, column);
+    return true;
+}
+
+void SolverSession::query(int64_t &nbSolution, uint32_t &row, uint32_t &column) {
+
+    /// Laser has reached the detector without having to add any mirror, no solution needed
+    if (mForward.end == mDetectorPos) {
+        nbSolution = 0;
+        row = column = 0u;
+        return;
+    }
+
+    if (mRecount) recount();
+
+    /// No intersection: no solution, impossible to open the Safe
+    nbSolution = mNbCrossings;
+    row = mRows;
+    column = mColumns;
+    if (nbSolution == 0) {
+        nbSolution = -1;
+        return;
+    }
+
+    /// The closest solution is in the first row having crossings
+    row = mRowCrossings.begin()->first;
+    column = closestColumn(row);
+}
+
+void SolverSession::trace(Trajectory &trajectory, std::array<uint32_t, 2> position, Mirror::edirection direction) {
+
+    while (true) {
+
+        /// Ordered mirrors of the row or column of the movement, and the coordinate moving along it
+        const bool horizontal = isHorizontal(direction);
+        const auto &lines = horizontal ? mMirrorsInRows : mMirrorsInColumns;
+        const uint32_t line = horizontal ? position[0] : position[1];
+        const uint32_t current = horizontal ? position[1] : position[0];
+        const bool ascending = direction == Mirror::edirection::eDirRight || direction == Mirror::edirection::eDirDown;
+
+        /// Closest mirror in the direction, or the end of the Safe (outside) when no mirror is in the path
+        uint32_t next = ascending ? (horizontal ? mColumns : mRows) + 1u : 0u;
+        Mirror::emirrorKind kind = Mirror::emirrorKind::eKindNone;
+        const auto mirrors = lines.find(line);
+        if (mirrors != lines.end()) {
+            if (ascending) {
+                const auto mirror = mirrors->second.upper_bound(current);
+                if (mirror != mirrors->second.end()) std::tie(next, kind) = *mirror;
+            } else {
+                const auto mirror = mirrors->second.lower_bound(current);
+                if (mirror != mirrors->second.begin()) std::tie(next, kind) = *std::prev(mirror);
+            }
+        }
+
+        /// Add the movement, indexed by its row or column once the trajectory is traced
+        trajectory.segments.push_back({line, std::min(current, next), std::max(current, next)});
+        trajectory.directions.push_back(direction);
+
+        /// Move to the next position
+        if (horizontal) position[1] = next;
+        else position[0] = next;
+
+        /// The end of the Safe has been reached, the trajectory is over
+        if (kind == Mirror::emirrorKind::eKindNone) {
+            trajectory.end = position;
+            return;
+        }
+        direction = Mirror::reflect(kind, direction);
+    }
+}
+
+void SolverSession::retrace(Trajectory &trajectory, const Trajectory &other, const uint32_t row,
+                            const uint32_t column) {
+
+    /// First movement passing on the cell: the first one of its row or of its column containing it
+    auto firstContaining = [&trajectory](const Trajectory::Lines &lines, const uint32_t line,
+                                         const uint32_t position) {
+        const auto [begin, end] = linesBetween(lines, line, line);
+        for (auto movement = begin; movement != end; ++movement) {
+            const Segment &segment = trajectory.segments[movement->second];
+            if (segment.lo <= position && position <= segment.hi) return movement->second;
+        }
+        return static_cast<uint32_t>(trajectory.segments.size());
+    };
+    const uint32_t first = std::min(firstContaining(trajectory.rowSegments, row, column),
+                                    firstContaining(trajectory.columnSegments, column, row));
+    if (first == trajectory.segments.size()) return;  ///< The trajectory does not pass on the cell
+
+    /// Remove the movements from the first one passing on the cell, with their crossings
+    updateCrossings(trajectory, other, first, -1);
+    const std::array<uint32_t, 2> start = startOf(trajectory, first);
+    const Mirror::edirection direction = trajectory.directions[first];
+    auto removed = [first](const std::pair<uint32_t, uint32_t> &movement) { return movement.second >= first; };
+    std::erase_if(trajectory.rowSegments, removed);
+    std::erase_if(trajectory.columnSegments, removed);
+    trajectory.segments.resize(first);
+    trajectory.directions.resize(first);
+
+    /// Trace the rest of the trajectory again from the start of the removed movement, and add its crossings
+    trace(trajectory, start, direction);
+    index(trajectory, first);
+    updateCrossings(trajectory, other, first, 1);
+}
+
+void SolverSession::updateCrossings(const Trajectory &trajectory, const Trajectory &other, const uint32_t first,
+                                    const int64_t sign) {
+
+    /// Beyond this work, counting every crossing again is cheaper. The movements themselves are part of the work.
+    const std::size_t maxWork = std::max((mForward.segments.size() + mBackward.segments.size()) / C_MAX_WORK_FRACTION,
+                                         C_MIN_MAX_WORK);
+    mWork += trajectory.segments.size() - first;
+    if (mWork > maxWork) mRecount = true;
+
+    for (auto index = static_cast<std::size_t>(first); index < trajectory.segments.size() && !mRecount; ++index) {
+        const Segment &segment = trajectory.segments[index];
+
+        if (isHorizontal(trajectory.directions[index])) {
+            /// Vertical movements of the other trajectory in the columns of the movement, crossed if active on its row
+            int64_t nbCrossings = 0;
+            const auto [begin, end] = linesBetween(other.columnSegments, segment.lo, segment.hi);
+            mWork += end - begin;
+            for (auto movement = begin; movement != end; ++movement) {
+                const Segment &vertical = other.segments[movement->second];
+                if (vertical.lo < segment.fixed && segment.fixed < vertical.hi) ++nbCrossings;
+            }
+            if (nbCrossings > 0) addCrossings(segment.fixed, sign * nbCrossings);
+        } else if (segment.hi - segment.lo >= 2u) {
+            /// Horizontal movements of the other trajectory in the rows strictly inside the movement
+            const auto [begin, end] = linesBetween(other.rowSegments, segment.lo + 1u, segment.hi - 1u);
+            mWork += end - begin;
+            for (auto movement = begin; movement != end; ++movement) {
+                const Segment &horizontal = other.segments[movement->second];
+                if (horizontal.lo <= segment.fixed && segment.fixed <= horizontal.hi) {
+                    addCrossings(movement->first, sign);
+                    ++mWork;
+                }
+            }
+        }
+
+        if (mWork > maxWork) mRecount = true;
+    }
+}
+
+void SolverSession::addCrossings(const uint32_t row, const int64_t nbCrossings) {
+    mNbCrossings += nbCrossings;
+    const auto [crossings, inserted] = mRowCrossings.try_emplace(row, 0);
+    crossings->second += nbCrossings;
+    if (crossings->second == 0) mRowCrossings.erase(crossings);
+}
+
+void SolverSession::recount() {
+
+    /// Gather the movements along the rows and the columns of each trajectory
+    auto split = [](const Trajectory &trajectory, std::vector<Segment> &rows, std::vector<Segment> &columns) {
+        rows.clear();
+        columns.clear();
+        for (std::size_t index = 0u; index < trajectory.segments.size(); ++index)
+            (isHorizontal(trajectory.directions[index]) ? rows : columns).push_back(trajectory.segments[index]);
+    };
+    split(mForward, mForwardRows, mForwardColumns);
+    split(mBackward, mBackwardRows, mBackwardColumns);
+
+    /// Intersections between the trajectories, as SafeBreaker::checkIntersections
+    mNbCrossings = 0;
+    mRowCrossings.clear();
+    countRows(mForwardRows, mBackwardColumns);
+    countRows(mBackwardRows, mForwardColumns);
+    mRecount = false;
+}
+
+void SolverSession::countRows(const std::vector<Segment> &horizontal, const std::vector<Segment> &vertical) {
+
+    /// Nothing can intersect without both kind of movements
+    if (horizontal.empty() || vertical.empty()) return;
+
+    /// A vertical movement is active for the rows strictly inside its outer points: added at lo+1, removed at hi
+    mTree.build(vertical);
+    mEvents.clear();
+    for (uint32_t index = 0u; index < vertical.size(); ++index) {
+        if (vertical[index].hi - vertical[index].lo < 2u) continue;  ///< No row strictly inside
+        mEvents.push_back({vertical[index].lo + 1u, 0u, index});
+        mEvents.push_back({vertical[index].hi, 1u, index});
+    }
+    for (uint32_t index = 0u; index < horizontal.size(); ++index)
+        mEvents.push_back({horizontal[index].fixed, 2u, index});
+
+    std::sort(mEvents.begin(), mEvents.end(), [](const Event &first, const Event &second) {
+        return first.row < second.row || (first.row == second.row && first.kind < second.kind);
+    });
+
+    /// Sweep the rows in ascending order, counting the active vertical movements between the outer points of each
+    /// horizontal movement. The rows come in order: they are merged in the crossings of the rows in a single pass.
+    auto rowCrossings = mRowCrossings.begin();
+    for (const auto &event: mEvents) {
+        if (event.kind != 2u) {
+            mTree.add(mTree.lowerBound(vertical[event.index].fixed), event.kind == 0u ? 1 : -1);
+            continue;
+        }
+        const Segment &segment = horizontal[event.index];
+        const int nbCrossings = mTree.prefix(mTree.upperBound(segment.hi)) - mTree.prefix(mTree.lowerBound(segment.lo));
+        if (nbCrossings == 0) continue;
+        mNbCrossings += nbCrossings;
+        while (rowCrossings != mRowCrossings.end() && rowCrossings->first < segment.fixed) ++rowCrossings;
+        if (rowCrossings != mRowCrossings.end() && rowCrossings->first == segment.fixed)
+            rowCrossings->second += nbCrossings;
+        else rowCrossings = mRowCrossings.emplace_hint(rowCrossings, segment.fixed, nbCrossings);
+    }
+}
+
+uint32_t SolverSession::closestColumn(const uint32_t row) const {
+
+    /// First vertical movement of the other trajectory active on the row, in the columns of each horizontal movement
+    uint32_t column = mColumns + 1u;
+    for (const auto &[rows, columns]: {std::pair{&mForward, &mBackward}, std::pair{&mBackward, &mForward}}) {
+        const auto [begin, end] = linesBetween(rows->rowSegments, row, row);
+        for (auto movement = begin; movement != end; ++movement) {
+            const Segment &segment = rows->segments[movement->second];
+            if (segment.lo >= column) continue;  ///< Only bigger columns
+            const auto [first, last] = linesBetween(columns->columnSegments, segment.lo, std::min(segment.hi, column));
+            const auto crossed = std::find_if(first, last, [&](const std::pair<uint32_t, uint32_t> &vertical) {
+                return columns->segments[vertical.second].lo < row && row < columns->segments[vertical.second].hi;
+            });
+            if (crossed != last) column = crossed->first;
+        }
+    }
+    return column;
+}
+
+void SolverSession::index(Trajectory &trajectory, const uint32_t first) {
+
+    /// Append the movements to the rows or the columns, then merge them with the sorted previous ones
+    const std::size_t nbRows = trajectory.rowSegments.size(), nbColumns = trajectory.columnSegments.size();
+    for (auto index = first; index < trajectory.segments.size(); ++index)
+        (isHorizontal(trajectory.directions[index]) ? trajectory.rowSegments : trajectory.columnSegments)
+                .emplace_back(trajectory.segments[index].fixed, index);
+    for (const auto &[lines, nbSorted]: {std::pair{&trajectory.rowSegments, nbRows},
+                                         std::pair{&trajectory.columnSegments, nbColumns}}) {
+        sortLines(*lines, nbSorted);
+        const auto middle = lines->begin() + static_cast<std::ptrdiff_t>(nbSorted);
+        mMergedLines.resize(lines->size());
+        std::merge(lines->begin(), middle, middle, lines->end(), mMergedLines.begin());
+        lines->swap(mMergedLines);
+    }
+}
+
+void SolverSession::sortLines(Trajectory::Lines &lines, const std::size_t first) {
+
+    /// Movements are added in increasing order of index: sorting the pairs by row or column then index keeps the order
+    const auto begin = lines.begin() + static_cast<std::ptrdiff_t>(first);
+    const std::size_t size = lines.size() - first;
+    if (size < C_RADIX_MIN_SIZE) {
+        std::sort(begin, lines.end());
+        return;
+    }
+
+    mMergedLines.resize(size);
+    mHistogram.resize(1u << C_RADIX_BITS);
+    for (uint32_t shift = 0u; shift < 32u; shift += C_RADIX_BITS) {
+
+        /// Count the occurrences of each digit, then the starting position of each digit
+        std::fill(mHistogram.begin(), mHistogram.end(), 0u);
+        for (auto movement = begin; movement != lines.end(); ++movement)
+            ++mHistogram[(movement->first >> shift) & ((1u << C_RADIX_BITS) - 1u)];
+        uint32_t position = 0u;
+        for (auto &count: mHistogram) position += std::exchange(count, position);
+
+        /// Stable distribution of the movements, then back in the list
+        for (auto movement = begin; movement != lines.end(); ++movement)
+            mMergedLines[mHistogram[(movement->first >> shift) & ((1u << C_RADIX_BITS) - 1u)]++] = *movement;
+        std::copy(mMergedLines.begin(), mMergedLines.end(), begin);
+    }
+}
+
+std::pair<SolverSession::Trajectory::Lines::const_iterator, SolverSession::Trajectory::Lines::const_iterator>
+SolverSession::linesBetween(const Trajectory::Lines &lines, const uint32_t lo, const uint32_t hi) {
+    if (lo > hi) return {lines.end(), lines.end()};
+    auto before = [](const std::pair<uint32_t, uint32_t> &movement, const uint32_t line) {
+        return movement.first < line;
+    };
+    auto after = [](const uint32_t line, const std::pair<uint32_t, uint32_t> &movement) {
+        return line < movement.first;
+    };
+    const auto begin = std::lower_bound(lines.begin(), lines.end(), lo, before);
+    return {begin, std::upper_bound(begin, lines.end(), hi, after)};
+}
+
+std::array<uint32_t, 2> SolverSession::startOf(const Trajectory &trajectory, const uint32_t index) {
+    const Segment &segment = trajectory.segments[index];
+    switch (trajectory.directions[index]) {
+        case Mirror::edirection::eDirRight: return {segment.fixed, segment.lo};
+        case Mirror::edirection::eDirLeft: return {segment.fixed, segment.hi};
+        case Mirror::edirection::eDirDown: return {segment.lo, segment.fixed};
+        case Mirror::edirection::eDirUp: return {segment.hi, segment.fixed};
+    }
+    return {segment.fixed, segment.lo};
+}
@@ -0,0 +1,96 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <utility>
+#include "../headers/StatsWriter.h"
+
+namespace {
+    /// Name of each statistic in the JSON objects
+    const std::array<std::pair<const char *, uint64_t CaseStats::*>, 9> C_FIELDS = {{
+            {"parse_ns", &CaseStats::parseNs},
+            {"build_ns", &CaseStats::buildNs},
+            {"forward_ns", &CaseStats::forwardNs},
+            {"backward_ns", &CaseStats::backwardNs},
+            {"intersect_ns", &CaseStats::intersectNs},
+            {"mirrors_visited", &CaseStats::mirrorsVisited},
+            {"segments", &CaseStats::segments},
+            {"columns_probed", &CaseStats::columnsProbed},
+            {"intersections", &CaseStats::intersections},
+    }};
+
+    /**
+     * Append an integer to a string without any temporary stream.
+     *
+     * @param text: string to append to
+     * @param value: integer to append
+     */
+    void appendInteger(std::string &text, const uint64_t value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+    }
+}
+
+StatsWriter::~StatsWriter() {
+    close();
+}
+
+bool StatsWriter::open(const std::string &fileName) {
+    close();
+    mFile.open(fileName, std::ios::out | std::ios::trunc);
+    mNbCases = 0u;
+    mTotal = mMax = {};
+    return mFile.is_open();
+}
+
+bool StatsWriter::isOpen() const {
+    return mFile.is_open();
+}
+
+void StatsWriter::appendFields(std::string &text, const CaseStats &stats) {
+    for (std::size_t index = 0u; index < C_FIELDS.size(); ++index) {
+        if (index > 0u) text.push_back(',');
+        text.push_back('"');
+        text.append(C_FIELDS[index].first);
+        text.append("\":");
+        appendInteger(text, stats.*C_FIELDS[index].second);
+    }
+}
+
+void StatsWriter::write(const uint32_t caseId, const CaseStats &stats) {
+
+    if (!mFile.is_open()) return;
+
+    mLine.assign("{\"case\":");
+    appendInteger(mLine, caseId);
+    mLine.push_back(',');
+    appendFields(mLine, stats);
+    mLine.append("}\n");
+    mFile << mLine;
+
+    /// Aggregate the statistics
+    ++mNbCases;
+    for (const auto &[name, field]: C_FIELDS) {
+        mTotal.*field += stats.*field;
+        mMax.*field = std::max(mMax.*field, stats.*field);
+    }
+}
+
+void StatsWriter::close() {
+
+    if (!mFile.is_open()) return;
+
+    mLine.assign("{\"aggregate\":{\"cases\":");
+    appendInteger(mLine, mNbCases);
+    mLine.append(",\"total\":{");
+    appendFields(mLine, mTotal);
+    mLine.append("},\"max\":{");
+    appendFields(mLine, mMax);
+    mLine.append("}}}\n");
+    mFile << mLine;
+    mFile.close();
+}
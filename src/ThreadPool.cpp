@@ -0,0 +1,112 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include "../headers/ThreadPool.h"
+
+namespace {
+    /// Pool and index of the worker executing the current thread, if any
+    thread_local const ThreadPool *tCurrentPool = nullptr;
+    thread_local uint32_t tCurrentIndex = 0u;
+}
+
+uint32_t ThreadPool::resolveThreads(const uint32_t nbThreads) {
+    if (nbThreads > 0u) return nbThreads;
+    const unsigned int nbCores = std::thread::hardware_concurrency();  ///< Can be 0 if unknown
+    return nbCores > 0u ? nbCores : 1u;
+}
+
+ThreadPool::ThreadPool(const uint32_t nbThreads) {
+    const uint32_t nbWorkers = resolveThreads(nbThreads);
+
+    /// Create every queue before starting the workers: any worker can steal from any queue
+    for (uint32_t index = 0u; index < nbWorkers; ++index) mQueues.push_back(std::make_unique<Queue>());
+    for (uint32_t index = 0u; index < nbWorkers; ++index) mWorkers.emplace_back(&ThreadPool::work, this, index);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mStop = true;
+    }
+    mSleepCondition.notify_all();
+    for (auto &worker: mWorkers) worker.join();
+}
+
+uint32_t ThreadPool::size() const {
+    return static_cast<uint32_t>(mWorkers.size());
+}
+
+uint32_t ThreadPool::workerIndex() const {
+    return tCurrentPool == this ? tCurrentIndex : size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+
+    /// A worker keeps its own tasks, other tasks are distributed over the workers in turn
+    uint32_t index = workerIndex();
+    if (index == size()) index = mNextQueue.fetch_add(1u, std::memory_order_relaxed) % size();
+
+    /// Count the task before queuing it so the counter never goes below zero. The lock avoids missing a worker about
+    /// to sleep.
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mNbPending.fetch_add(1u, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mQueues[index]->mutex);
+        mQueues[index]->tasks.push_back(std::move(task));
+    }
+
+    /// Wake up a sleeping worker
+    mSleepCondition.notify_one();
+}
+
+bool ThreadPool::takeTask(const uint32_t index, std::function<void()> &task) {
+
+    /// Most recent task of the own queue first: its data is the most likely to still be in cache
+    {
+        Queue &queue = *mQueues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            mNbPending.fetch_sub(1u, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    /// Then steal the oldest task of another worker
+    for (uint32_t offset = 1u; offset < mQueues.size(); ++offset) {
+        Queue &queue = *mQueues[(index + offset) % mQueues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            mNbPending.fetch_sub(1u, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::work(const uint32_t index) {
+
+    tCurrentPool = this;
+    tCurrentIndex = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (takeTask(index, task)) {
+            task();
+            task = nullptr;  ///< Release the data captured by the task
+            continue;
+        }
+
+        /// Nothing to do: sleep until a task is submitted or the pool is stopped
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleepCondition.wait(lock, [this] { return mStop || mNbPending.load(std::memory_order_acquire) > 0u; });
+        if (mStop && mNbPending.load(std::memory_order_acquire) == 0u) return;
+    }
+}
@@ -2,10 +2,140 @@
  * Created by Aurelien Chagnon
  */
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
 #include "../headers/Api.h"
+#include "../headers/SolverDaemon.h"
+
+namespace {
+    /**
+     * Parse the value of a numerical option.
+     *
+     * @param[in] text: value of the option
+     * @param[out] value: parsed value
+     * @return true if the whole text is a valid unsigned integer
+     */
+    template<typename T>
+    bool parseNumber(const char *text, T &value) {
+        const char *end = text + std::strlen(text);
+        const auto result = std::from_chars(text, end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    /// Options, each followed by its value except --enumerate, --minimum, --memory and --large-grid:
+    /// --input FILE and --output FILE to choose the input and output files (input.txt and output.log by default),
+    /// --threads N to override the number of threads (one per core by default),
+    /// --queue N and --queue-bytes N to bound the cases read and not written yet (4 per thread and 256 MiB by default),
+    /// --format text|jsonl|binary to choose the format of the output file,
+    /// --flush-bytes N and --flush-ms N to choose when the output file is written,
+    /// --stats FILE to save the statistics of each phase of each case as JSON Lines,
+    /// --candidates FILE and --answers FILE to check candidate mirrors (answers in candidates.log by default),
+    /// --enumerate to save every solution of each case in the output file,
+    /// --minimum to save the minimum number of mirrors opening each case a single mirror does not open,
+    /// --memory to save the heap allocations of each phase of each case and display the cases using the most,
+    /// --large-grid to accept Safes up to 2^31 rows and columns and a billion mirrors,
+    /// --cache N to keep the results of the last N Safes solved and --cache-file FILE to keep them between runs,
+    /// --serve SOCKET to answer the cases sent on a Unix socket, or on the standard input with --serve -. The daemon
+    /// only takes --threads, --cache and --large-grid, the other options are rejected.
+    std::string inputFileName = "input.txt", outputFileName = "output.log", statsFileName;
+    std::string candidatesFileName, answersFileName = "candidates.log";
+    uint32_t nbThreads = 0u;
+    std::size_t queueCases = 0u, queueBytes = Api::C_QUEUE_BYTES;
+    ResultWriter::eformat format = ResultWriter::eformat::eFormatText;
+    std::size_t flushBytes = 1u << 20u;
+    uint32_t flushMilliseconds = 1000u;
+    bool enumerate = false, minimum = false, memory = false, largeGrid = false;
+    std::size_t cacheCapacity = 0u;
+    std::string cacheFileName, socketPath;
+
+    /// Options used by the daemon, and the first option given which is not
+    static constexpr std::array<const char *, 4> daemonOptions = {"--serve", "--threads", "--cache", "--large-grid"};
+    const char *fileOption = nullptr;
+
+    for (int index = 1; index < argc; ++index) {
+        if (!fileOption && std::none_of(daemonOptions.begin(), daemonOptions.end(), [&](const char *option) {
+            return std::strcmp(argv[index], option) == 0;
+        })) fileOption = argv[index];
+
+        if (std::strcmp(argv[index], "--enumerate") == 0) {
+            enumerate = true;
+            continue;
+        }
+        if (std::strcmp(argv[index], "--minimum") == 0) {
+            minimum = true;
+            continue;
+        }
+        if (std::strcmp(argv[index], "--memory") == 0) {
+            memory = true;
+            continue;
+        }
+        if (std::strcmp(argv[index], "--large-grid") == 0) {
+            largeGrid = true;
+            continue;
+        }
+
+        const bool hasValue = index + 1 < argc;
+
+        if (hasValue && std::strcmp(argv[index], "--input") == 0) inputFileName = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--output") == 0) outputFileName = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--stats") == 0) statsFileName = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--candidates") == 0) candidatesFileName = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--answers") == 0) answersFileName = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--serve") == 0) socketPath = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--cache-file") == 0) cacheFileName = argv[index + 1];
+        else if (hasValue && std::strcmp(argv[index], "--cache") == 0 && parseNumber(argv[index + 1], cacheCapacity)) {}
+        else if (hasValue && std::strcmp(argv[index], "--threads") == 0 && parseNumber(argv[index + 1], nbThreads)) {}
+        else if (hasValue && std::strcmp(argv[index], "--queue") == 0 && parseNumber(argv[index + 1], queueCases)) {}
+        else if (hasValue && std::strcmp(argv[index], "--queue-bytes") == 0 && parseNumber(argv[index + 1], queueBytes)) {}
+        else if (hasValue && std::strcmp(argv[index], "--format") == 0 && ResultWriter::parseFormat(argv[index + 1], format)) {}
+        else if (hasValue && std::strcmp(argv[index], "--flush-bytes") == 0 && parseNumber(argv[index + 1], flushBytes)) {}
+        else if (hasValue && std::strcmp(argv[index], "--flush-ms") == 0 && parseNumber(argv[index + 1], flushMilliseconds)) {}
+        else {
+            std::cerr << "Unknown option " << argv[index] << " ! Usage: " << argv[0] << " [--input FILE]"
+                      << " [--output FILE] [--threads N] [--queue N] [--queue-bytes N] [--format text|jsonl|binary]"
+                      << " [--flush-bytes N] [--flush-ms N] [--stats FILE] [--candidates FILE] [--answers FILE]"
+                      << " [--enumerate] [--minimum] [--memory] [--large-grid] [--cache N] [--cache-file FILE]"
+                      << " [--serve SOCKET|-]"
+                      << std::endl;
+            return 1;
+        }
+        ++index;  ///< Skip the value of the option
+    }
+
+    /// Daemon: results are sent back to the client, the input and output files are not used
+    if (!socketPath.empty()) {
+        if (fileOption) {
+            std::cerr << "Option " << fileOption << " is not supported by the daemon ! Usage: " << argv[0]
+                      << " --serve SOCKET|- [--threads N] [--cache N] [--large-grid]" << std::endl;
+            return 1;
+        }
+        SolverDaemon daemon(nbThreads);
+        daemon.setCache(cacheCapacity);
+        daemon.setLargeGrid(largeGrid);
+        if (socketPath != "-") return daemon.serve(socketPath) ? 0 : 1;
+        daemon.serveStream(STDIN_FILENO, STDOUT_FILENO);
+        return 0;
+    }
+
+    Api api(inputFileName, outputFileName);
+    api.setThreads(nbThreads);
+    api.setQueueLimits(queueCases, queueBytes);
+    api.setOutputFormat(format);
+    api.setFlushPolicy(flushBytes, std::chrono::milliseconds(flushMilliseconds));
+    api.setStatsFile(statsFileName);
+    api.setCandidatesFiles(candidatesFileName, answersFileName);
+    api.setEnumerate(enumerate);
+    api.setMinimum(minimum);
+    api.setMemoryAccounting(memory);
+    api.setCache(cacheCapacity, cacheFileName);
+    api.setLargeGrid(largeGrid);
 
-int main() {
-    Api api("input.txt", "output.log");
     api.launch();
     return 0;
 }
@@ -0,0 +1,312 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../headers/CaseReader.h"
+#include "../headers/SafeBreaker.h"
+
+/**
+ * Benchmark of the solver phases over the stress tests and synthetic inputs.
+ *
+ * Each input is solved several times. For each phase (parse, index build, trajectories, intersections), the median and
+ * the 99th percentile of the runs are reported. The medians can be saved as a JSON baseline and compared with a
+ * previous baseline: the benchmark fails when a phase is slower than its baseline by more than a threshold.
+ *
+ * The medians are absolute times: a baseline is only meaningful on the machine which wrote it, and must be written
+ * again on the target machine, and after any change meant to make the solver faster.
+ */
+
+#ifndef SAFEANDMIRRORS_TESTS_DIR
+#define SAFEANDMIRRORS_TESTS_DIR "Tests"
+#endif
+
+namespace {
+
+    /// Phases of the solver which are measured
+    const std::vector<std::string> C_PHASES = {"parse", "build", "trace", "intersect", "total"};
+
+    /// Below this difference (milliseconds), a slower phase is considered as noise and not a regression
+    const double C_NOISE_MS = 0.5;
+
+    /**
+     * Input of the benchmark
+     */
+    struct Input {
+        std::string name;  ///< Name of the input in the report
+        std::string path;  ///< Path of the input file
+    };
+
+    /**
+     * Options of the benchmark
+     */
+    struct Options {
+        uint32_t repeat = 10u;  ///< Number of measured runs per input
+        uint32_t warmup = 1u;  ///< Number of runs before the measured ones
+        double threshold = 0.25;  ///< Relative slow down accepted before a regression
+        std::string baseline;  ///< Baseline to compare with, if any
+        std::string writeBaseline;  ///< File to save the medians in, if any
+        std::string testsDir = SAFEANDMIRRORS_TESTS_DIR;  ///< Directory of the stress tests
+        std::vector<std::string> files;  ///< Additional input files
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Elapsed time in milliseconds since a time point.
+     *
+     * @param start: time point
+     * @return elapsed milliseconds
+     */
+    double elapsedMs(const Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    /**
+     * Solve every case of an input once and add the time of each phase to the samples.
+     *
+     * @param input: input to solve
+     * @param breaker: breaker reused for every case
+     * @param samples: times of each phase, one sample per run
+     */
+    void run(const Input &input, SafeBreaker &breaker, std::map<std::string, std::vector<double>> &samples) {
+
+        std::map<std::string, double> times;
+
+        /// Parse every case first
+        Clock::time_point start = Clock::now();
+        CaseReader reader;
+        if (!reader.open(input.path)) {
+            std::cerr << "Cannot open file " << input.path << " !" << std::endl;
+            return;
+        }
+        std::vector<std::shared_ptr<const Safe>> safes;
+        std::shared_ptr<Safe> safe;
+        while (reader.nextCase(safe)) safes.push_back(safe);
+        times["parse"] = elapsedMs(start);
+
+        /// Then solve them phase by phase
+        for (const auto &caseSafe: safes) {
+            start = Clock::now();
+            breaker.reset(*caseSafe);
+            times["build"] += elapsedMs(start);
+
+            start = Clock::now();
+            const bool detectorReached = breaker.computeTrajectories();
+            times["trace"] += elapsedMs(start);
+
+            if (!detectorReached) {
+                int64_t nbSolution;
+                uint32_t row, column;
+                start = Clock::now();
+                breaker.checkIntersections(nbSolution, row, column);
+                times["intersect"] += elapsedMs(start);
+            }
+        }
+        times["total"] = times["parse"] + times["build"] + times["trace"] + times["intersect"];
+
+        for (const auto &phase: C_PHASES) samples[phase].push_back(times[phase]);
+    }
+
+    /**
+     * Value of a sorted set of samples at a given percentile, using the nearest rank.
+     *
+     * @param sorted: sorted samples, not empty
+     * @param percentile: percentile between 0 and 100
+     * @return value at the percentile
+     */
+    double percentile(const std::vector<double> &sorted, const double percentile) {
+        const auto rank = static_cast<std::size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<std::size_t>(rank, 1u, sorted.size()) - 1u];
+    }
+
+    /**
+     * Write the synthetic inputs in the temporary directory.
+     *
+     * @return synthetic inputs
+     */
+    std::vector<Input> writeSyntheticInputs() {
+        std::vector<Input> inputs;
+        std::mt19937 generator(20220101u);
+        const std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+        /// Maximum number of rows, columns and mirrors, placed randomly
+        {
+            std::uniform_int_distribution<uint32_t> position(1u, 1000000u);
+            std::ostringstream text;
+            text << "1000000 1000000 200000 200000\n";
+            for (uint32_t index = 0u; index < 400000u; ++index)
+                text << position(generator) << ' ' << position(generator) << '\n';
+            inputs.push_back({"SyntheticRandomMax", (directory / "bench_random_max.txt").string()});
+            std::ofstream(inputs.back().path) << text.str();
+        }
+
+        /// Many small cases
+        {
+            std::uniform_int_distribution<uint32_t> size(1u, 50u), count(0u, 20u);
+            std::ostringstream text;
+            for (uint32_t index = 0u; index < 20000u; ++index) {
+                const uint32_t rows = size(generator), columns = size(generator);
+                const uint32_t nbRightLeft = count(generator), nbLeftRight = count(generator);
+                text << rows << ' ' << columns << ' ' << nbRightLeft << ' ' << nbLeftRight << '\n';
+                std::uniform_int_distribution<uint32_t> row(1u, rows), column(1u, columns);
+                for (uint32_t mirror = 0u; mirror < nbRightLeft + nbLeftRight; ++mirror)
+                    text << row(generator) << ' ' << column(generator) << '\n';
+            }
+            inputs.push_back({"SyntheticManySmall", (directory / "bench_many_small.txt").string()});
+            std::ofstream(inputs.back().path) << text.str();
+        }
+
+        return inputs;
+    }
+
+    /**
+     * Read a flat JSON object of numbers: {"name": value, ...}.
+     *
+     * @param fileName: name of the JSON file
+     * @param[out] values: values read
+     * @return true if the file could be read
+     */
+    bool readBaseline(const std::string &fileName, std::map<std::string, double> &values) {
+        std::ifstream file(fileName);
+        if (!file.is_open()) return false;
+        std::stringstream content;
+        content << file.rdbuf();
+        const std::string text = content.str();
+
+        std::size_t position = 0u;
+        while ((position = text.find('"', position)) != std::string::npos) {
+            const std::size_t endName = text.find('"', position + 1u);
+            if (endName == std::string::npos) break;
+            const std::string name = text.substr(position + 1u, endName - position - 1u);
+            std::size_t valueStart = text.find(':', endName);
+            if (valueStart == std::string::npos) break;
+            valueStart = text.find_first_not_of(" \t\r\n", valueStart + 1u);
+            double value = 0.0;
+            const auto result = std::from_chars(text.data() + valueStart, text.data() + text.size(), value);
+            if (result.ec == std::errc()) values[name] = value;
+            position = static_cast<std::size_t>(result.ptr - text.data());
+        }
+        return true;
+    }
+
+    /**
+     * Parse the command line options.
+     *
+     * @param[in] argc, argv: command line
+     * @param[out] options: parsed options
+     * @return true if every option is valid
+     */
+    bool parseOptions(const int argc, char *argv[], Options &options) {
+        for (int index = 1; index < argc; ++index) {
+            const std::string option = argv[index];
+            const bool hasValue = index + 1 < argc;
+            const char *value = hasValue ? argv[index + 1] : "";
+            const char *valueEnd = value + std::strlen(value);
+            if (hasValue && option == "--repeat" && std::from_chars(value, valueEnd, options.repeat).ec == std::errc() &&
+                options.repeat > 0u) {}
+            else if (hasValue && option == "--warmup" && std::from_chars(value, valueEnd, options.warmup).ec == std::errc()) {}
+            else if (hasValue && option == "--threshold" && std::from_chars(value, valueEnd, options.threshold).ec == std::errc()) {}
+            else if (hasValue && option == "--baseline") options.baseline = value;
+            else if (hasValue && option == "--write-baseline") options.writeBaseline = value;
+            else if (hasValue && option == "--tests-dir") options.testsDir = value;
+            else if (option.rfind("--", 0) != 0) {
+                options.files.push_back(option);
+                continue;
+            } else {
+                std::cerr << "Unknown option " << option << " ! Usage: " << argv[0] << " [--repeat N] [--warmup N]"
+                          << " [--threshold ratio] [--baseline file.json] [--write-baseline file.json]"
+                          << " [--tests-dir dir] [input files...]" << std::endl;
+                return false;
+            }
+            ++index;  ///< Skip the value of the option
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) return 2;
+
+    /// Stress tests, synthetic inputs and additional files
+    std::vector<Input> inputs;
+    for (const char *name: {"StressTest2", "StressTest5", "StressTest6"}) {
+        const std::filesystem::path path = std::filesystem::path(options.testsDir) / (std::string(name) + ".txt");
+        if (std::filesystem::exists(path)) inputs.push_back({name, path.string()});
+        else std::cerr << "Stress test " << path.string() << " not found, skipped." << std::endl;
+    }
+    for (auto &input: writeSyntheticInputs()) inputs.push_back(std::move(input));
+    for (const auto &file: options.files) inputs.push_back({std::filesystem::path(file).stem().string(), file});
+
+    /// Measure each input and report the median and 99th percentile of each phase, in milliseconds
+    std::map<std::string, double> medians;
+    SafeBreaker breaker;
+    std::cout << std::left << std::setw(24) << "input" << std::setw(12) << "phase" << std::right << std::setw(12)
+              << "median_ms" << std::setw(12) << "p99_ms" << std::endl;
+    for (const auto &input: inputs) {
+        std::map<std::string, std::vector<double>> samples, warmupSamples;
+        for (uint32_t index = 0u; index < options.warmup; ++index) run(input, breaker, warmupSamples);
+        for (uint32_t index = 0u; index < options.repeat; ++index) run(input, breaker, samples);
+
+        for (const auto &phase: C_PHASES) {
+            std::vector<double> &phaseSamples = samples[phase];
+            if (phaseSamples.empty()) continue;
+            std::sort(phaseSamples.begin(), phaseSamples.end());
+            const double median = percentile(phaseSamples, 50.0), p99 = percentile(phaseSamples, 99.0);
+            medians[input.name + "/" + phase] = median;
+            std::cout << std::left << std::setw(24) << input.name << std::setw(12) << phase << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(12) << median << std::setw(12) << p99 << std::endl;
+        }
+    }
+
+    /// Save the medians as a new baseline
+    if (!options.writeBaseline.empty()) {
+        std::ofstream file(options.writeBaseline);
+        file << "{\n";
+        for (auto entry = medians.begin(); entry != medians.end(); ++entry)
+            file << "  \"" << entry->first << "\": " << std::fixed << std::setprecision(3) << entry->second
+                 << (std::next(entry) == medians.end() ? "\n" : ",\n");
+        file << "}\n";
+    }
+
+    /// Compare with the baseline: fail if a phase is slower than the accepted threshold
+    if (!options.baseline.empty()) {
+        std::map<std::string, double> baseline;
+        if (!readBaseline(options.baseline, baseline)) {
+            std::cerr << "Cannot open baseline " << options.baseline << " !" << std::endl;
+            return 2;
+        }
+        uint32_t nbRegressions = 0u;
+        for (const auto &[name, median]: medians) {
+            const auto reference = baseline.find(name);
+            if (reference == baseline.end()) continue;
+            if (median > reference->second * (1.0 + options.threshold) && median - reference->second > C_NOISE_MS) {
+                std::cout << "REGRESSION " << name << ": " << median << " ms, baseline " << reference->second
+                          << " ms" << std::endl;
+                ++nbRegressions;
+            }
+        }
+        if (nbRegressions > 0u) {
+            std::cout << nbRegressions << " regression(s) above " << options.threshold * 100.0 << "%" << std::endl;
+            return 1;
+        }
+        std::cout << "No regression above " << options.threshold * 100.0 << "%" << std::endl;
+    }
+
+    return 0;
+}
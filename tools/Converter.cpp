@@ -0,0 +1,108 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "../headers/BinaryCaseFormat.h"
+#include "../headers/CaseReader.h"
+
+/**
+ * Converter of input files between the text format of input.txt and the binary format of the cases.
+ *
+ * text2bin writes every case of an input file (text or binary) in the binary format, raw by default or delta-encoded
+ * with --delta. bin2text writes every case of an input file (binary or text) in the text format. Mirrors outside their
+ * Safe are dropped, as when solving.
+ */
+
+namespace {
+
+    /**
+     * Append an integer to a text without any temporary stream.
+     *
+     * @param text: text to append to
+     * @param value: integer to append
+     */
+    void append(std::string &text, const uint32_t value) {
+        char digits[16];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+    }
+
+    /**
+     * Append a case in the format of input.txt
+     *
+     * @param text: text to append to
+     * @param safe: Safe of the case
+     */
+    void appendText(std::string &text, const Safe &safe) {
+        const Safe::MirrorsView mirrors = safe.mirrors();
+        uint32_t nbRightLeft = 0u;
+        for (const auto kind: mirrors.kinds) nbRightLeft += kind == Mirror::emirrorKind::eKindRightLeft ? 1u : 0u;
+
+        append(text, safe.rows());
+        text += ' ';
+        append(text, safe.columns());
+        text += ' ';
+        append(text, nbRightLeft);
+        text += ' ';
+        append(text, static_cast<uint32_t>(mirrors.size()) - nbRightLeft);
+        text += '\n';
+
+        /// Mirrors of kind / first, then mirrors of kind \ .
+        for (const auto kind: {Mirror::emirrorKind::eKindRightLeft, Mirror::emirrorKind::eKindLeftRight}) {
+            for (std::size_t index = 0u; index < mirrors.size(); ++index) {
+                if (mirrors.kinds[index] != kind) continue;
+                append(text, mirrors.rows[index]);
+                text += ' ';
+                append(text, mirrors.columns[index]);
+                text += '\n';
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    const bool textToBinary = argc >= 4 && std::strcmp(argv[1], "text2bin") == 0;
+    const bool binaryToText = argc == 4 && std::strcmp(argv[1], "bin2text") == 0;
+    const bool delta = textToBinary && argc == 5 && std::strcmp(argv[4], "--delta") == 0;
+    if ((!textToBinary && !binaryToText) || (textToBinary && argc == 5 && !delta) || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " text2bin input output [--delta]" << std::endl
+                  << "       " << argv[0] << " bin2text input output" << std::endl;
+        return 1;
+    }
+
+    CaseReader reader;
+    if (!reader.open(argv[2])) {
+        std::cerr << "Cannot open file " << argv[2] << " !" << std::endl;
+        return 1;
+    }
+    std::ofstream file(argv[3], std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open file " << argv[3] << " !" << std::endl;
+        return 1;
+    }
+
+    const auto encoding = delta ? BinaryCaseFormat::eencoding::eEncodingDelta : BinaryCaseFormat::eencoding::eEncodingRaw;
+    std::string content;
+    if (textToBinary) BinaryCaseFormat::writeFileHeader(content);
+
+    std::shared_ptr<Safe> safe;
+    while (reader.nextCase(safe)) {
+        if (textToBinary) BinaryCaseFormat::writeCase(content, *safe, encoding);
+        else appendText(content, *safe);
+
+        /// Write by chunks to bound the memory of the content
+        if (content.size() > (1u << 20u)) {
+            file.write(content.data(), static_cast<std::streamsize>(content.size()));
+            content.clear();
+        }
+    }
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return 0;
+}
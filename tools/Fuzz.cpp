@@ -0,0 +1,975 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "../headers/Api.h"
+#include "../headers/BinaryCaseFormat.h"
+#include "../headers/CrossingKernel.h"
+#include "../headers/ReferenceSolver.h"
+#include "../headers/SafeBreaker.h"
+#include "../headers/SolverSession.h"
+#include "Random.h"
+
+/**
+ * Differential fuzzer of the SafeBreaker against the ReferenceSolver.
+ *
+ * Random small Safes are drawn from a seed, and solved by both solvers: the number of solutions and the closest
+ * solution must be the same. Both solvers also check every candidate placement of a mirror, of each kind or of none, on
+ * each cell of the Safe and around it: the answers (opens, closes, occupied, outside) must be the same. Every solution
+ * (row, column, kind of mirror) is enumerated by both solvers: the lists, in lexicographic order, must be the same. On
+ * Safes of at most 16 cells which a single mirror does not open, the minimum number of mirrors of the SafeBreaker must
+ * be the one found by trying every set of up to 3 mirrors, and its mirrors must open the Safe. The first Safe giving
+ * different results is shrunk, by removing mirrors, rows and columns as long as the results still differ, and written
+ * in the format of input.txt. The time spent by each solver is reported.
+ *
+ * Small Safes only take the paths of small cases. With --pool N, the SafeBreaker is given a pool of N workers and the
+ * sizes from which it takes the paths of big cases are drawn for each Safe, down to 0: small Safes are then also
+ * counted by the sweep instead of the kernel, by bands of rows, and traced concurrently.
+ *
+ * Each Safe is then stretched to a large grid of 2^31 rows and columns, by inserting empty rows and columns between
+ * its own: the SafeBreaker must give the same solutions, at the rows and columns of the Safe in the grid.
+ *
+ * Each Safe is then edited --edits times (4 by default) in a SolverSession, by adding, replacing or removing a mirror
+ * on a random cell: after each edit, the session must give the same results as the SafeBreaker solving the edited Safe.
+ *
+ * Along with each Safe, random packed movements are tested against a row by the CrossingKernel, with each instruction
+ * set supported by the processor: the count and the first crossing must be the same as one movement at a time.
+ *
+ * With --threads N, the Safes are also written, by batches, in an input file with malformed lines between them, and
+ * solved by the Api with one thread and with N threads: both output files must be the same. They are solved again with
+ * N threads and a cache saved in a file, then from the same cases in the binary format with the cache file loaded.
+ *
+ * Usage: fuzz [--seed N] [--cases N] [--max-length N] [--max-mirrors N] [--pool N] [--edits N] [--threads N]
+ *             [--output file]
+ */
+
+namespace {
+
+    /// Position of a mirror: row and column
+    using Position = std::array<uint32_t, 2>;
+
+    /// Solution of a Safe: row and column of the mirror to place, and its kind
+    using Solution = std::tuple<uint32_t, uint32_t, Mirror::emirrorKind>;
+
+    /**
+     * Case of the fuzzer, the mirrors being added to the Safe as an input file gives them: / first, then \ .
+     */
+    struct Case {
+        uint32_t rows = 0u, columns = 0u;  ///< Size of the Safe
+        std::vector<Position> rightLeft, leftRight;  ///< Mirrors / and mirrors \ .
+        SafeBreaker::Thresholds thresholds;  ///< Sizes from which the SafeBreaker takes the paths of big cases
+    };
+
+    /**
+     * Results of a Safe given by a solver
+     */
+    struct Result {
+        int64_t nbSolution = 0;  ///< Number of solutions
+        uint32_t row = 0u, column = 0u;  ///< Closest solution, only meaningful with solutions
+        std::vector<SafeBreaker::ecandidate> answers;  ///< Answer of each candidate placement, if checked
+        std::vector<Solution> solutions;  ///< Every solution in the order enumerated, if enumerated
+        /// Minimum number of mirrors opening a small Safe a single mirror does not open, -1 if more than tried or none
+        int64_t minimum = 0;
+        bool placementsOpen = true;  ///< The mirrors given with the minimum open the Safe
+
+        bool operator==(const Result &other) const {
+            return nbSolution == other.nbSolution && (nbSolution <= 0 || (row == other.row && column == other.column))
+                   && answers == other.answers && solutions == other.solutions && minimum == other.minimum &&
+                   placementsOpen == other.placementsOpen;
+        }
+    };
+
+    /// Biggest Safe, in cells, whose minimum number of mirrors is checked, and biggest number of mirrors tried
+    constexpr uint32_t C_MINIMUM_MAX_CELLS = 16u;
+    constexpr uint32_t C_MINIMUM_MAX_MIRRORS = 3u;
+
+    /**
+     * Options of the fuzzer
+     */
+    struct Options {
+        uint64_t seed = 1u;  ///< Seed of the pseudo-random generator
+        uint64_t cases = 100000u;  ///< Number of Safes to compare
+        uint32_t maxLength = 10u;  ///< Maximum number of rows and of columns
+        uint32_t maxMirrors = 30u;  ///< Maximum number of mirrors of both kinds
+        uint32_t pool = 0u;  ///< Number of workers of the pool of the SafeBreaker, 0 for no pool
+        uint32_t edits = 4u;  ///< Number of edits of each Safe checked with a SolverSession
+        uint32_t threads = 0u;  ///< Number of threads of the Api compared with a single thread, 0 for no comparison
+        std::string output;  ///< File receiving the shrunk case, standard output if empty
+    };
+
+    /**
+     * Build the Safe of a case
+     *
+     * @param fuzzCase: case to build
+     * @return Safe with the mirrors of the case, / first then \ .
+     */
+    Safe build(const Case &fuzzCase) {
+        Safe safe(fuzzCase.rows, fuzzCase.columns);
+        for (const auto &[row, column]: fuzzCase.rightLeft)
+            safe.addMirror(row, column, Mirror::emirrorKind::eKindRightLeft);
+        for (const auto &[row, column]: fuzzCase.leftRight)
+            safe.addMirror(row, column, Mirror::emirrorKind::eKindLeftRight);
+        return safe;
+    }
+
+    /**
+     * Case stretched to a large grid: empty rows are inserted between the rows of the case, and empty columns between
+     * and around its columns. The laser and the detector stay on the first and the last row, the beam crosses the same
+     * mirrors and the solutions only lie on the rows and columns of the case.
+     */
+    struct Stretch {
+        uint32_t rows = 1u, columns = 1u;  ///< Size of the large grid
+        std::vector<uint32_t> rowOf, columnOf;  ///< Row (column) of the large grid of each row (column) of the case
+    };
+
+    /**
+     * Draw distinct lines of a large grid, in increasing order
+     *
+     * @param random: pseudo-random generator
+     * @param count: number of lines
+     * @param first, last: range of the lines
+     * @return lines drawn
+     */
+    std::vector<uint32_t> drawLines(Random &random, const uint32_t count, const uint32_t first, const uint32_t last) {
+        std::vector<uint32_t> lines;
+        do {
+            lines.clear();
+            for (uint32_t line = 0u; line < count; ++line) lines.push_back(random.between(first, last));
+            std::sort(lines.begin(), lines.end());
+        } while (std::adjacent_find(lines.begin(), lines.end()) != lines.end());
+        return lines;
+    }
+
+    /**
+     * Draw how a case is stretched to a grid of Safe::C_LARGE_MAX_LENGTH rows (unless it has a single row) and columns
+     *
+     * @param random: pseudo-random generator
+     * @param fuzzCase: case to stretch
+     * @return stretch of the case, the row (column) 0 of the case being the row (column) 0 of the grid
+     */
+    Stretch drawStretch(Random &random, const Case &fuzzCase) {
+        Stretch stretch;
+        stretch.rows = fuzzCase.rows == 1u ? 1u : Safe::C_LARGE_MAX_LENGTH;
+        stretch.columns = Safe::C_LARGE_MAX_LENGTH;
+
+        stretch.rowOf = {0u, 1u};
+        if (fuzzCase.rows > 1u) {
+            const std::vector<uint32_t> rows = drawLines(random, fuzzCase.rows - 2u, 2u, stretch.rows - 1u);
+            stretch.rowOf.insert(stretch.rowOf.end(), rows.begin(), rows.end());
+            stretch.rowOf.push_back(stretch.rows);
+        }
+        stretch.columnOf = {0u};
+        const std::vector<uint32_t> columns = drawLines(random, fuzzCase.columns, 1u, stretch.columns);
+        stretch.columnOf.insert(stretch.columnOf.end(), columns.begin(), columns.end());
+        return stretch;
+    }
+
+    /**
+     * Build the Safe of a case stretched to a large grid
+     *
+     * @param fuzzCase: case to build
+     * @param stretch: rows and columns of the case in the large grid
+     * @return Safe in large grid mode with the mirrors of the case, / first then \ .
+     */
+    Safe build(const Case &fuzzCase, const Stretch &stretch) {
+        Safe safe;
+        safe.setLargeGrid(true);
+        safe.setContext(stretch.rows, stretch.columns);
+        for (const auto &[row, column]: fuzzCase.rightLeft)
+            safe.addMirror(stretch.rowOf[row], stretch.columnOf[column], Mirror::emirrorKind::eKindRightLeft);
+        for (const auto &[row, column]: fuzzCase.leftRight)
+            safe.addMirror(stretch.rowOf[row], stretch.columnOf[column], Mirror::emirrorKind::eKindLeftRight);
+        return safe;
+    }
+
+    /**
+     * Move a line of a large grid back to the case, 0 if it is not a line of the case
+     *
+     * @param lines: line of the large grid of each line of the case
+     * @param line: line of the large grid
+     * @return line of the case
+     */
+    uint32_t lineOfCase(const std::vector<uint32_t> &lines, const uint32_t line) {
+        const auto found = std::lower_bound(lines.begin() + 1, lines.end(), line);
+        return found != lines.end() && *found == line ? static_cast<uint32_t>(found - lines.begin()) : 0u;
+    }
+
+    /**
+     * Both solvers, with the time they spent
+     */
+    struct Solvers {
+        SafeBreaker breaker;
+        ReferenceSolver reference;
+        std::chrono::nanoseconds breakerTime{0}, referenceTime{0};
+        /// Placements checked in the last case: each kind, none included, on each cell and around the Safe
+        std::vector<SafeBreaker::Candidate> candidates;
+        /// Mirrors given by the SafeBreaker with the minimum number of mirrors of the last case
+        std::vector<MirrorRouter::Placement> placements;
+
+        /**
+         * Solve a case with both solvers, check every candidate placement and enumerate every solution. The minimum
+         * number of mirrors of a small Safe a single mirror does not open is also searched.
+         *
+         * @param[in] fuzzCase: case to solve
+         * @param[out] fast, slow: results of the SafeBreaker and of the ReferenceSolver
+         * @return true if the results are the same
+         */
+        bool compare(const Case &fuzzCase, Result &fast, Result &slow) {
+            const Safe safe = build(fuzzCase);
+            candidates.clear();
+            for (uint32_t row = 0u; row <= fuzzCase.rows + 1u; ++row)
+                for (uint32_t column = 0u; column <= fuzzCase.columns + 1u; ++column)
+                    for (const auto kind: {Mirror::emirrorKind::eKindNone, Mirror::emirrorKind::eKindRightLeft,
+                                           Mirror::emirrorKind::eKindLeftRight})
+                        candidates.push_back({row, column, kind});
+            fast.answers.resize(candidates.size());
+            slow.answers.resize(candidates.size());
+
+            auto start = std::chrono::steady_clock::now();
+            breaker.setThresholds(fuzzCase.thresholds);
+            breaker.reset(safe);
+            breaker.solve(fast.nbSolution, fast.row, fast.column);
+            breaker.checkCandidates(candidates, fast.answers);
+            fast.solutions.clear();
+            breaker.enumerateSolutions([&fast](const uint32_t row, const uint32_t column,
+                                               const Mirror::emirrorKind kind) {
+                fast.solutions.emplace_back(row, column, kind);
+            });
+            const bool withMinimum = fast.nbSolution < 0 && fuzzCase.rows * fuzzCase.columns <= C_MINIMUM_MAX_CELLS;
+            placements.clear();
+            fast.minimum = withMinimum ? breaker.minimumMirrors(placements) : 0;
+            auto end = std::chrono::steady_clock::now();
+            breakerTime += end - start;
+
+            start = end;
+            reference.solve(safe, slow.nbSolution, slow.row, slow.column);
+            reference.checkCandidates(safe, candidates, slow.answers);
+            slow.solutions.clear();
+            reference.enumerateSolutions(safe, [&slow](const uint32_t row, const uint32_t column,
+                                                       const Mirror::emirrorKind kind) {
+                slow.solutions.emplace_back(row, column, kind);
+            });
+            slow.minimum = 0;
+            if (withMinimum) reference.minimumMirrors(safe, C_MINIMUM_MAX_MIRRORS, slow.minimum);
+            end = std::chrono::steady_clock::now();
+            referenceTime += end - start;
+
+            /// The mirrors of the SafeBreaker must open the Safe. Beyond the mirrors tried, it must find more or none.
+            fast.placementsOpen = slow.placementsOpen = true;
+            if (fast.minimum > 0) {
+                reference.checkPlacements(safe, placements, fast.placementsOpen);
+                fast.placementsOpen = fast.placementsOpen &&
+                                      placements.size() == static_cast<std::size_t>(fast.minimum);
+            }
+            if (fast.minimum > static_cast<int64_t>(C_MINIMUM_MAX_MIRRORS)) fast.minimum = -1;
+            return fast == slow;
+        }
+    };
+
+    /**
+     * Solve a case stretched to a large grid with the SafeBreaker, and move its solutions back to the case: they must
+     * be the solutions of the case.
+     *
+     * @param[in] breaker: breaker solving the stretched Safe
+     * @param[in] fuzzCase: case to stretch
+     * @param[in] stretch: rows and columns of the case in the large grid
+     * @param[in] fast: results of the SafeBreaker for the case
+     * @param[out] large: results for the stretched Safe, moved back to the case
+     * @return true if the results are the same
+     */
+    bool compareLargeGrid(SafeBreaker &breaker, const Case &fuzzCase, const Stretch &stretch, const Result &fast,
+                          Result &large) {
+        const Safe safe = build(fuzzCase, stretch);
+        breaker.setThresholds(fuzzCase.thresholds);
+        breaker.reset(safe);
+        breaker.solve(large.nbSolution, large.row, large.column);
+        large.row = lineOfCase(stretch.rowOf, large.row);
+        large.column = lineOfCase(stretch.columnOf, large.column);
+        large.solutions.clear();
+        breaker.enumerateSolutions([&](const uint32_t row, const uint32_t column, const Mirror::emirrorKind kind) {
+            large.solutions.emplace_back(lineOfCase(stretch.rowOf, row), lineOfCase(stretch.columnOf, column), kind);
+        });
+        return large.nbSolution == fast.nbSolution && (fast.nbSolution <= 0 ||
+               (large.row == fast.row && large.column == fast.column)) && large.solutions == fast.solutions;
+    }
+
+    /**
+     * Edit a case in a SolverSession, and compare the session with the SafeBreaker after each edit.
+     *
+     * @param[in] breaker: breaker solving each edited Safe
+     * @param[in] random: pseudo-random generator drawing the edits
+     * @param[in] fuzzCase: case to edit
+     * @param[in] nbEdits: number of edits
+     * @param[out] fast, slow: results of the SafeBreaker and of the session after the last edit
+     * @param[out] edits: edits done, one per line
+     * @return true if the results are the same after each edit
+     */
+    bool compareEdits(SafeBreaker &breaker, Random &random, const Case &fuzzCase, const uint32_t nbEdits, Result &fast,
+                      Result &slow, std::ostream &edits) {
+
+        /// Mirror of each cell, the last mirror of a cell being kept as by the solvers
+        std::map<Position, Mirror::emirrorKind> cells;
+        for (const auto &position: fuzzCase.rightLeft) cells[position] = Mirror::emirrorKind::eKindRightLeft;
+        for (const auto &position: fuzzCase.leftRight) cells[position] = Mirror::emirrorKind::eKindLeftRight;
+
+        /// Only the number of solutions and the closest one are compared
+        for (Result *result: {&fast, &slow}) {
+            result->answers.clear();
+            result->solutions.clear();
+            result->minimum = 0;
+            result->placementsOpen = true;
+        }
+
+        SolverSession session(build(fuzzCase));
+        for (uint32_t edit = 0u; edit < nbEdits; ++edit) {
+
+            /// Remove the mirror of a random cell, or add a mirror of a random kind, replacing the one there if any
+            const Position position{random.between(1u, fuzzCase.rows), random.between(1u, fuzzCase.columns)};
+            const auto kind = random.between(0u, 2u);
+            edits << "  " << (kind == 0u ? "remove" : kind == 1u ? "add /" : "add \\") << " at (" << position[0] << ", "
+                  << position[1] << ")" << std::endl;
+            if (kind == 0u) {
+                session.removeMirror(position[0], position[1]);
+                cells.erase(position);
+            } else {
+                const auto mirror = kind == 1u ? Mirror::emirrorKind::eKindRightLeft
+                                               : Mirror::emirrorKind::eKindLeftRight;
+                session.addMirror(position[0], position[1], mirror);
+                cells[position] = mirror;
+            }
+
+            Safe safe(fuzzCase.rows, fuzzCase.columns);
+            for (const auto &[cell, mirror]: cells) safe.addMirror(cell[0], cell[1], mirror);
+            breaker.reset(safe);
+            breaker.solve(fast.nbSolution, fast.row, fast.column);
+            session.query(slow.nbSolution, slow.row, slow.column);
+            if (!(fast == slow)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Packed vertical movements tested by the CrossingKernel, and the row tested
+     */
+    struct Movements {
+        uint32_t row = 0u;  ///< Row tested
+        std::vector<uint32_t> lo, hi;  ///< Outer points of each movement
+    };
+
+    /**
+     * Draw random movements and a row, their number covering the blocks of each instruction set and their tails. The
+     * values are drawn close to each other, around 0, the sign bit or the maximum, so the unsigned comparisons of the
+     * vectors are checked; a few are drawn around another of these values.
+     *
+     * @param random: pseudo-random generator
+     * @return random movements
+     */
+    Movements drawMovements(Random &random) {
+        static constexpr std::array<uint32_t, 3> C_BASES{0u, 1u << 31u, UINT32_MAX - 8u};
+        const uint32_t base = C_BASES[random.between(0u, 2u)];
+        auto value = [&]() {
+            return (random.between(0u, 7u) == 0u ? C_BASES[random.between(0u, 2u)] : base) + random.between(0u, 8u);
+        };
+
+        Movements movements;
+        movements.row = value();
+        const uint32_t size = random.between(0u, 40u);
+        for (uint32_t movement = 0u; movement < size; ++movement) {
+            movements.lo.push_back(value());
+            movements.hi.push_back(value());
+        }
+        return movements;
+    }
+
+    /**
+     * Retrieve the name of an instruction set of the CrossingKernel
+     *
+     * @param instructionSet: instruction set to name
+     * @return name of the instruction set
+     */
+    const char *instructionSetName(const CrossingKernel::einstructionSet instructionSet) {
+        switch (instructionSet) {
+            case CrossingKernel::einstructionSet::eInstructionSetScalar: return "scalar";
+            case CrossingKernel::einstructionSet::eInstructionSetSse2: return "SSE2";
+            case CrossingKernel::einstructionSet::eInstructionSetAvx2: return "AVX2";
+        }
+        return "unknown";
+    }
+
+    /**
+     * Test movements with each instruction set supported by the processor, from the scalar one to the best one.
+     *
+     * @param[in] movements: movements and row to test
+     * @param[out] results: result of each instruction set, the scalar one first
+     * @return true if every instruction set gives the result of the scalar one
+     */
+    bool compareKernels(const Movements &movements, std::vector<CrossingKernel::Result> &results) {
+        results.clear();
+        const auto size = static_cast<uint32_t>(movements.lo.size());
+        for (auto instructionSet = CrossingKernel::einstructionSet::eInstructionSetScalar;;
+             instructionSet = static_cast<CrossingKernel::einstructionSet>(static_cast<int>(instructionSet) + 1)) {
+            results.push_back(CrossingKernel::cross(instructionSet, movements.row, movements.lo.data(),
+                                                    movements.hi.data(), size));
+            if (instructionSet == CrossingKernel::instructionSet()) break;
+        }
+        return std::all_of(results.begin(), results.end(), [&](const CrossingKernel::Result &result) {
+            return result.count == results.front().count && result.first == results.front().first;
+        });
+    }
+
+    /**
+     * Display movements and the result of each instruction set
+     *
+     * @param movements: movements and row tested
+     * @param results: result of each instruction set, the scalar one first
+     */
+    void displayKernels(const Movements &movements, const std::vector<CrossingKernel::Result> &results) {
+        std::cerr << "  row " << movements.row << ", movements (lo, hi):";
+        for (std::size_t movement = 0u; movement < movements.lo.size(); ++movement)
+            std::cerr << " (" << movements.lo[movement] << ", " << movements.hi[movement] << ")";
+        std::cerr << std::endl;
+        for (std::size_t index = 0u; index < results.size(); ++index)
+            std::cerr << "  " << instructionSetName(static_cast<CrossingKernel::einstructionSet>(index)) << ": "
+                      << results[index].count << " crossed, first " << results[index].first << std::endl;
+    }
+
+    /// Number of cases solved by the Api at once, and number of Safes kept by its cache when filled by a batch: the
+    /// batch does not fit in it
+    constexpr uint32_t C_PIPELINE_CASES = 512u;
+    constexpr std::size_t C_PIPELINE_CACHE = 64u;
+
+    /// Lines which do not describe a case, written between the cases solved by the Api: the previous case is solved
+    /// again
+    constexpr std::array<const char *, 4> C_MALFORMED_LINES{"7 7", "5", "1 2 3 4 5", "x"};
+
+    /**
+     * Stream buffer discarding what is written in it. It has no state: the threads of the Api may write in it at once.
+     */
+    class DiscardBuffer : public std::streambuf {
+    protected:
+        int overflow(const int character) override { return traits_type::not_eof(character); }
+        std::streamsize xsputn(const char *, const std::streamsize count) override { return count; }
+    };
+
+    /**
+     * Solve an input file with the Api and read its output file. The display of the Api is discarded.
+     *
+     * @param input: path of the input file
+     * @param output: path of the output file
+     * @param nbThreads: number of threads of the Api
+     * @param cacheCapacity: number of Safes kept by the cache of the Api, 0 for no cache
+     * @param cacheFile: cache file of the Api, loaded then saved
+     * @return content of the output file
+     */
+    std::string runApi(const std::string &input, const std::string &output, const uint32_t nbThreads,
+                       const std::size_t cacheCapacity = 0u, const std::string &cacheFile = {}) {
+        DiscardBuffer discarded;
+        std::streambuf *const display = std::cout.rdbuf(&discarded);
+        std::streambuf *const errors = std::cerr.rdbuf(&discarded);
+        {
+            Api api(input, output);
+            api.setThreads(nbThreads);
+            api.setCache(cacheCapacity, cacheFile);
+            api.launch();
+        }
+        std::cout.rdbuf(display);
+        std::cerr.rdbuf(errors);
+
+        std::ifstream file(output, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    /// Runs of the Api compared with a single thread on the text input
+    enum class epipelineRun {
+        ePipelineRunThreads,  ///< Text input, several threads
+        ePipelineRunCache,  ///< Text input, several threads and an empty cache, saved in a file
+        ePipelineRunBinary,  ///< Binary input, several threads and the cache loaded from the file, kept until the end
+        ePipelineRunNone  ///< Every run gives the output of a single thread
+    };
+
+    /**
+     * Solve the same cases with the Api with one thread, then with several threads, with a cache and from a binary
+     * input. The repeated Safes of the malformed lines are found in the cache, and the last Safes of the text input in
+     * the cache file loaded back.
+     *
+     * @param[in] text, binary: content of the input file, in text and in binary format
+     * @param[in] nbThreads: number of threads compared with a single thread
+     * @param[out] single, other: output files with one thread and of the first run giving another output
+     * @return first run giving another output, ePipelineRunNone if none
+     */
+    epipelineRun comparePipeline(const std::string &text, const std::string &binary, const uint32_t nbThreads,
+                                 std::string &single, std::string &other) {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path();
+        const std::string textPath = (directory / "fuzz_pipeline_input.txt").string();
+        const std::string binaryPath = (directory / "fuzz_pipeline_input.bin").string();
+        const std::string outputPath = (directory / "fuzz_pipeline_output.log").string();
+        const std::string cachePath = (directory / "fuzz_pipeline_cache.bin").string();
+        std::ofstream(textPath, std::ios::binary) << text;
+        std::ofstream(binaryPath, std::ios::binary) << binary;
+        std::filesystem::remove(cachePath);
+
+        single = runApi(textPath, outputPath, 1u);
+        if ((other = runApi(textPath, outputPath, nbThreads)) != single) return epipelineRun::ePipelineRunThreads;
+        if ((other = runApi(textPath, outputPath, nbThreads, C_PIPELINE_CACHE, cachePath)) != single)
+            return epipelineRun::ePipelineRunCache;
+        if ((other = runApi(binaryPath, outputPath, nbThreads, 2u * C_PIPELINE_CASES, cachePath)) != single)
+            return epipelineRun::ePipelineRunBinary;
+        return epipelineRun::ePipelineRunNone;
+    }
+
+    /**
+     * Display the first line of two outputs which differs
+     *
+     * @param single, other: output files with one thread and of another run
+     */
+    void displayOutputs(const std::string &single, const std::string &other) {
+        std::istringstream singleLines(single), otherLines(other);
+        std::string singleLine, otherLine;
+        for (uint32_t line = 1u;; ++line) {
+            const bool hasSingle = static_cast<bool>(std::getline(singleLines, singleLine));
+            const bool hasOther = static_cast<bool>(std::getline(otherLines, otherLine));
+            if (!hasSingle && !hasOther) return;
+            if (hasSingle && hasOther && singleLine == otherLine) continue;
+            std::cerr << "  line " << line << ": '" << (hasSingle ? singleLine : "none") << "' with 1 thread, '"
+                      << (hasOther ? otherLine : "none") << "' otherwise" << std::endl;
+            return;
+        }
+    }
+
+    /**
+     * Retrieve the description of a run of the Api
+     *
+     * @param run: run to describe
+     * @return description of the run
+     */
+    const char *runName(const epipelineRun run) {
+        switch (run) {
+            case epipelineRun::ePipelineRunThreads: return "threads";
+            case epipelineRun::ePipelineRunCache: return "threads and a cache";
+            case epipelineRun::ePipelineRunBinary: return "threads from the binary input, with the cache of the text";
+            case epipelineRun::ePipelineRunNone: break;
+        }
+        return "unknown";
+    }
+
+    /**
+     * Draw a random case: its size, then its number of mirrors, from an empty Safe up to a full one
+     *
+     * @param random: pseudo-random generator
+     * @param options: bounds of the cases
+     * @return random case
+     */
+    Case draw(Random &random, const Options &options) {
+        Case fuzzCase;
+        fuzzCase.rows = random.between(1u, options.maxLength);
+        fuzzCase.columns = random.between(1u, options.maxLength);
+        const uint32_t nbMirrors = random.between(0u, std::min(options.maxMirrors, fuzzCase.rows * fuzzCase.columns));
+        for (uint32_t mirror = 0u; mirror < nbMirrors; ++mirror) {
+            const Position position{random.between(1u, fuzzCase.rows), random.between(1u, fuzzCase.columns)};
+            (random.between(0u, 1u) == 0u ? fuzzCase.rightLeft : fuzzCase.leftRight).push_back(position);
+        }
+
+        /// With a pool, each threshold is drawn around the sizes of the small Safes, so each path is taken or not
+        if (options.pool > 0u) {
+            fuzzCase.thresholds.kernelMaxVertical = random.between(0u, 4u);
+            fuzzCase.thresholds.parallelMinSegments = random.between(0u, 32u);
+            fuzzCase.thresholds.parallelMinMirrors = random.between(0u, nbMirrors + 1u);
+        }
+        return fuzzCase;
+    }
+
+    /**
+     * Remove a row (or a column) of a case, with its mirrors. The next rows (or columns) are moved back.
+     *
+     * @param fuzzCase: case to reduce
+     * @param axis: 0 to remove a row, 1 to remove a column
+     * @param removed: row (or column) to remove
+     * @return reduced case
+     */
+    Case withoutLine(const Case &fuzzCase, const std::size_t axis, const uint32_t removed) {
+        Case reduced = fuzzCase;
+        (axis == 0u ? reduced.rows : reduced.columns) -= 1u;
+        for (auto *mirrors: {&reduced.rightLeft, &reduced.leftRight}) {
+            std::erase_if(*mirrors, [&](const Position &position) { return position[axis] == removed; });
+            for (auto &position: *mirrors)
+                if (position[axis] > removed) --position[axis];
+        }
+        return reduced;
+    }
+
+    /**
+     * Shrink a case as long as the solvers give different results: remove groups of mirrors, then single mirrors,
+     * rows and columns, until nothing can be removed.
+     *
+     * @param solvers: solvers to compare
+     * @param fuzzCase: case with different results, shrunk in place
+     */
+    void shrink(Solvers &solvers, Case &fuzzCase) {
+        Result fast, slow;
+        auto failing = [&](const Case &candidate) { return !solvers.compare(candidate, fast, slow); };
+
+        for (bool shrunk = true; shrunk;) {
+            shrunk = false;
+
+            /// Groups of consecutive mirrors of the same kind, halving their size down to single mirrors
+            for (const auto mirrors: {&Case::rightLeft, &Case::leftRight}) {
+                for (std::size_t size = (fuzzCase.*mirrors).size(); size > 0u; size /= 2u) {
+                    for (std::size_t first = 0u; first < (fuzzCase.*mirrors).size();) {
+                        Case candidate = fuzzCase;
+                        auto &candidateMirrors = candidate.*mirrors;
+                        const auto begin = candidateMirrors.begin() + static_cast<std::ptrdiff_t>(first);
+                        candidateMirrors.erase(begin, begin + static_cast<std::ptrdiff_t>(
+                                std::min(size, candidateMirrors.size() - first)));
+                        if (failing(candidate)) {
+                            fuzzCase = std::move(candidate);
+                            shrunk = true;
+                        } else first += size;
+                    }
+                }
+            }
+
+            /// Rows, then columns
+            for (std::size_t axis = 0u; axis < 2u; ++axis) {
+                for (uint32_t line = 1u; line <= (axis == 0u ? fuzzCase.rows : fuzzCase.columns);) {
+                    if ((axis == 0u ? fuzzCase.rows : fuzzCase.columns) == 1u) break;
+                    Case candidate = withoutLine(fuzzCase, axis, line);
+                    if (failing(candidate)) {
+                        fuzzCase = std::move(candidate);
+                        shrunk = true;
+                    } else ++line;
+                }
+            }
+        }
+    }
+
+    /**
+     * Write a case in the format of input.txt
+     *
+     * @param fuzzCase: case to write
+     * @param stream: stream receiving the case
+     */
+    void write(const Case &fuzzCase, std::ostream &stream) {
+        stream << fuzzCase.rows << ' ' << fuzzCase.columns << ' ' << fuzzCase.rightLeft.size() << ' '
+               << fuzzCase.leftRight.size() << '\n';
+        for (const auto *mirrors: {&fuzzCase.rightLeft, &fuzzCase.leftRight})
+            for (const auto &[row, column]: *mirrors) stream << row << ' ' << column << '\n';
+    }
+
+    /**
+     * Write an input to a file, or to the standard output if no file is given
+     *
+     * @param input: content of the input
+     * @param output: path of the file, empty for the standard output
+     * @return false if the file cannot be opened
+     */
+    bool save(const std::string &input, const std::string &output) {
+        if (output.empty()) {
+            std::cout << input;
+            return true;
+        }
+        std::ofstream file(output, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open file " << output << " !" << std::endl;
+            return false;
+        }
+        file << input;
+        return true;
+    }
+
+    /**
+     * Write a case in the format of input.txt to a file, or to the standard output if no file is given
+     *
+     * @param fuzzCase: case to write
+     * @param output: path of the file, empty for the standard output
+     * @return false if the file cannot be opened
+     */
+    bool save(const Case &fuzzCase, const std::string &output) {
+        std::ostringstream input;
+        write(fuzzCase, input);
+        return save(input.str(), output);
+    }
+
+    /**
+     * Retrieve the name of the answer for a candidate placement
+     *
+     * @param answer: answer to name
+     * @return name of the answer
+     */
+    const char *answerName(const SafeBreaker::ecandidate answer) {
+        switch (answer) {
+            case SafeBreaker::ecandidate::eCandidateOpens: return "opens";
+            case SafeBreaker::ecandidate::eCandidateCloses: return "closes";
+            case SafeBreaker::ecandidate::eCandidateOccupied: return "occupied";
+            case SafeBreaker::ecandidate::eCandidateOutside: return "outside";
+        }
+        return "unknown";
+    }
+
+    /**
+     * Retrieve the symbol of a kind of mirror
+     *
+     * @param kind: kind of mirror
+     * @return symbol of the kind, "none" if not a mirror
+     */
+    const char *kindName(const Mirror::emirrorKind kind) {
+        if (kind == Mirror::emirrorKind::eKindNone) return "none";
+        return kind == Mirror::emirrorKind::eKindRightLeft ? "/" : "\\";
+    }
+
+    /**
+     * Display the first solution enumerated differently in two results, if any
+     *
+     * @param first, second: results compared
+     * @param firstName, secondName: names of the results
+     */
+    void displaySolutions(const Result &first, const Result &second, const char *firstName, const char *secondName) {
+        const auto [firstSolution, secondSolution] = std::mismatch(first.solutions.begin(), first.solutions.end(),
+                                                                   second.solutions.begin(), second.solutions.end());
+        if (firstSolution == first.solutions.end() && secondSolution == second.solutions.end()) return;
+        std::cerr << "  solution " << firstSolution - first.solutions.begin() + 1 << " of " << first.solutions.size()
+                  << " (" << firstName << ") and " << second.solutions.size() << " (" << secondName << "):";
+        for (const auto &[name, solution, end]: {std::tuple{firstName, firstSolution, first.solutions.end()},
+                                                 std::tuple{secondName, secondSolution, second.solutions.end()}}) {
+            std::cerr << (solution == firstSolution ? " " : ", ") << name << ' ';
+            if (solution == end) std::cerr << "none";
+            else std::cerr << kindName(std::get<2>(*solution)) << " at (" << std::get<0>(*solution) << ", "
+                           << std::get<1>(*solution) << ")";
+        }
+        std::cerr << std::endl;
+    }
+
+    /**
+     * Display how a case is stretched to a large grid
+     *
+     * @param stretch: rows and columns of the case in the large grid
+     */
+    void displayStretch(const Stretch &stretch) {
+        for (const auto &[name, lines]: {std::pair{"  rows:", &stretch.rowOf},
+                                         std::pair{"  columns:", &stretch.columnOf}}) {
+            std::cerr << name;
+            for (std::size_t line = 1u; line < lines->size(); ++line)
+                std::cerr << ' ' << line << "->" << (*lines)[line];
+            std::cerr << std::endl;
+        }
+    }
+
+    /**
+     * Display the results of both solvers, their minimum numbers of mirrors if different, the first candidate
+     * placement answered differently and the first solution enumerated differently, if any
+     *
+     * @param fast, slow: results of the SafeBreaker and of the ReferenceSolver
+     * @param candidates: placements answered in the results
+     * @param placements: mirrors given by the SafeBreaker with its minimum number of mirrors
+     */
+    void displayResults(const Result &fast, const Result &slow, const std::vector<SafeBreaker::Candidate> &candidates,
+                        const std::vector<MirrorRouter::Placement> &placements) {
+        std::cerr << "  SafeBreaker: " << fast.nbSolution << " (" << fast.row << ", " << fast.column << ")"
+                  << std::endl << "  reference:   " << slow.nbSolution << " (" << slow.row << ", " << slow.column
+                  << ")" << std::endl;
+
+        if (fast.minimum != slow.minimum || !fast.placementsOpen) {
+            std::cerr << "  minimum mirrors (-1 for more than " << C_MINIMUM_MAX_MIRRORS << " or none): SafeBreaker "
+                      << fast.minimum << ", reference " << slow.minimum << std::endl << "  mirrors of the SafeBreaker"
+                      << (fast.placementsOpen ? "" : ", not opening the Safe") << ":";
+            for (const MirrorRouter::Placement &placement: placements)
+                std::cerr << ' ' << kindName(placement.kind) << " at (" << placement.row << ", " << placement.column
+                          << ")";
+            std::cerr << std::endl;
+        }
+
+        const auto [fastAnswer, slowAnswer] = std::mismatch(fast.answers.begin(), fast.answers.end(),
+                                                            slow.answers.begin(), slow.answers.end());
+        if (fastAnswer != fast.answers.end()) {
+            const SafeBreaker::Candidate &candidate = candidates[fastAnswer - fast.answers.begin()];
+            std::cerr << "  mirror " << kindName(candidate.kind) << " at (" << candidate.row << ", "
+                      << candidate.column << "): SafeBreaker " << answerName(*fastAnswer) << ", reference "
+                      << answerName(*slowAnswer) << std::endl;
+        }
+
+        displaySolutions(fast, slow, "SafeBreaker", "reference");
+    }
+
+    /**
+     * Display the thresholds of the SafeBreaker for a case, to reproduce it
+     *
+     * @param thresholds: thresholds of the case
+     */
+    void displayThresholds(const SafeBreaker::Thresholds &thresholds) {
+        std::cerr << "  thresholds: kernel max vertical " << thresholds.kernelMaxVertical << ", parallel min segments "
+                  << thresholds.parallelMinSegments << ", parallel min mirrors " << thresholds.parallelMinMirrors
+                  << std::endl;
+    }
+
+    /**
+     * Display the time spent by each solver
+     *
+     * @param solvers: solvers compared
+     * @param nbCases: number of cases solved
+     */
+    void displayThroughput(const Solvers &solvers, const uint64_t nbCases) {
+        for (const auto &[name, time]: {std::pair{"SafeBreaker", solvers.breakerTime},
+                                        std::pair{"reference", solvers.referenceTime}}) {
+            const double seconds = std::chrono::duration<double>(time).count();
+            std::cout << name << ": " << nbCases << " cases in " << seconds * 1e3 << " ms, "
+                      << (seconds > 0. ? static_cast<double>(nbCases) / seconds : 0.) << " cases/s" << std::endl;
+        }
+    }
+
+    /**
+     * Read the options of the command line, each followed by its value
+     *
+     * @param argc, argv: command line
+     * @param options: options read
+     * @return false if an option is unknown or has an invalid value
+     */
+    bool parseOptions(const int argc, char *argv[], Options &options) {
+        for (int index = 1; index + 1 < argc; index += 2) {
+            const std::string option = argv[index];
+            const char *value = argv[index + 1], *valueEnd = value + std::strlen(value);
+            if (option == "--output") options.output = value;
+            else if (option == "--seed" && std::from_chars(value, valueEnd, options.seed).ec == std::errc()) {}
+            else if (option == "--cases" && std::from_chars(value, valueEnd, options.cases).ec == std::errc()) {}
+            else if (option == "--max-length" &&
+                     std::from_chars(value, valueEnd, options.maxLength).ec == std::errc() && options.maxLength > 0u &&
+                     static_cast<uint64_t>(options.maxLength) * options.maxLength <= ReferenceSolver::C_MAX_CELLS) {}
+            else if (option == "--max-mirrors" &&
+                     std::from_chars(value, valueEnd, options.maxMirrors).ec == std::errc()) {}
+            else if (option == "--pool" && std::from_chars(value, valueEnd, options.pool).ec == std::errc()) {}
+            else if (option == "--edits" && std::from_chars(value, valueEnd, options.edits).ec == std::errc()) {}
+            else if (option == "--threads" && std::from_chars(value, valueEnd, options.threads).ec == std::errc()) {}
+            else return false;
+        }
+        return argc % 2 == 1;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] <<  " [--seed N] [--cases N] [--max-length N] [--max-mirrors N] [--pool N]"
+                  << " [--edits N] [--threads N] [--output file]" << std::endl;
+        return 1;
+    }
+
+    Random random(options.seed), editRandom(~options.seed), kernelRandom(options.seed ^ 0x5DEECE66Dull),
+           pipelineRandom(options.seed ^ 0x2545F4914F6CDD1Dull), largeRandom(options.seed ^ 0x9E3779B97F4A7C15ull);
+    Solvers solvers;
+    std::unique_ptr<ThreadPool> pool;
+    if (options.pool > 0u) {
+        pool = std::make_unique<ThreadPool>(options.pool);
+        solvers.breaker.setThreadPool(pool.get());
+    }
+    Result fast, slow, large;
+    std::vector<CrossingKernel::Result> kernelResults;
+
+    /// Input of the next batch of cases solved by the Api, in text and in binary format, and the outputs of the last
+    /// batch
+    std::ostringstream pipelineInput;
+    std::string pipelineBinary;
+    uint64_t firstPipelineCase = 0u;
+    std::string single, other;
+    for (uint64_t caseId = 0u; caseId < options.cases; ++caseId) {
+
+        /// The movements are drawn apart, as the edits
+        const Movements movements = drawMovements(kernelRandom);
+        if (!compareKernels(movements, kernelResults)) {
+            std::cerr << "Movements " << caseId << " of seed " << options.seed << " give different results with the"
+                      << " instruction sets of the CrossingKernel:" << std::endl;
+            displayKernels(movements, kernelResults);
+            return 1;
+        }
+
+        Case fuzzCase = draw(random, options);
+        if (!solvers.compare(fuzzCase, fast, slow)) {
+            std::cerr << "Case " << caseId << " of seed " << options.seed << " gives different results:" << std::endl;
+            displayResults(fast, slow, solvers.candidates, solvers.placements);
+            if (pool) displayThresholds(fuzzCase.thresholds);
+            displayThroughput(solvers, caseId + 1u);
+
+            shrink(solvers, fuzzCase);
+            solvers.compare(fuzzCase, fast, slow);
+            std::cerr << "Shrunk to " << fuzzCase.rows << "x" << fuzzCase.columns << " with "
+                      << fuzzCase.rightLeft.size() + fuzzCase.leftRight.size() << " mirrors:" << std::endl;
+            displayResults(fast, slow, solvers.candidates, solvers.placements);
+
+            save(fuzzCase, options.output);
+            return 1;
+        }
+
+        /// The case is stretched to a large grid, drawn apart as the movements
+        const Stretch stretch = drawStretch(largeRandom, fuzzCase);
+        if (!compareLargeGrid(solvers.breaker, fuzzCase, stretch, fast, large)) {
+            std::cerr << "Case " << caseId << " of seed " << options.seed << " gives different results once stretched"
+                      << " to a large grid of " << stretch.rows << "x" << stretch.columns << ":" << std::endl;
+            displayStretch(stretch);
+            std::cerr << "  case:       " << fast.nbSolution << " (" << fast.row << ", " << fast.column << ")"
+                      << std::endl << "  large grid: " << large.nbSolution << " (" << large.row << ", "
+                      << large.column << ") moved back to the case" << std::endl;
+            displaySolutions(fast, large, "case", "large grid");
+            save(fuzzCase, options.output);
+            return 1;
+        }
+
+        /// The edits are drawn apart, so a seed gives the same cases whatever the number of edits
+        std::ostringstream edits;
+        if (!compareEdits(solvers.breaker, editRandom, fuzzCase, options.edits, fast, slow, edits)) {
+            std::cerr << "Case " << caseId << " of seed " << options.seed << " gives different results once edited"
+                      << " in a SolverSession:" << std::endl << edits.str() << "  SafeBreaker: " << fast.nbSolution
+                      << " (" << fast.row << ", " << fast.column << ")" << std::endl << "  session:     "
+                      << slow.nbSolution << " (" << slow.row << ", " << slow.column << ")" << std::endl;
+            save(fuzzCase, options.output);
+            return 1;
+        }
+
+        /// The case is solved by the Api with the next ones, followed by a malformed line once in a while: the binary
+        /// input holds the case again instead, in either encoding
+        if (options.threads == 0u) continue;
+        const bool malformed = pipelineRandom.between(0u, 3u) == 0u;
+        write(fuzzCase, pipelineInput);
+        if (malformed) {
+            const auto line = pipelineRandom.between(0u, static_cast<uint32_t>(C_MALFORMED_LINES.size() - 1u));
+            pipelineInput << C_MALFORMED_LINES[line] << '\n';
+        }
+        if (pipelineBinary.empty()) BinaryCaseFormat::writeFileHeader(pipelineBinary);
+        const Safe safe = build(fuzzCase);
+        for (uint32_t copy = 0u; copy < (malformed ? 2u : 1u); ++copy)
+            BinaryCaseFormat::writeCase(pipelineBinary, safe, pipelineRandom.between(0u, 1u) == 0u ?
+                                                              BinaryCaseFormat::eencoding::eEncodingRaw :
+                                                              BinaryCaseFormat::eencoding::eEncodingDelta);
+        if (caseId + 1u - firstPipelineCase < C_PIPELINE_CASES && caseId + 1u < options.cases) continue;
+
+        if (const epipelineRun run = comparePipeline(pipelineInput.str(), pipelineBinary, options.threads, single,
+                                                     other); run != epipelineRun::ePipelineRunNone) {
+            std::cerr << "Cases " << firstPipelineCase << " to " << caseId << " of seed " << options.seed
+                      << " give different results when solved by the Api with 1 thread and with " << options.threads
+                      << " " << runName(run) << ":" << std::endl;
+            displayOutputs(single, other);
+            save(pipelineInput.str(), options.output);
+            return 1;
+        }
+        pipelineInput.str({});
+        pipelineBinary.clear();
+        firstPipelineCase = caseId + 1u;
+    }
+
+    displayThroughput(solvers, options.cases);
+    return 0;
+}
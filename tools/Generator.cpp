@@ -0,0 +1,325 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Random.h"
+
+/**
+ * Generator of adversarial inputs for the Mirrors and Laser problem.
+ *
+ * An input is generated from a named profile and a seed: the same profile and seed always give the same input, whatever
+ * the platform. The input is written in the format of input.txt: a line 'nb_rows nb_columns nb_mirror_/ nb_mirror_\'
+ * per case, followed by the positions of the mirrors / then of the mirrors \ .
+ *
+ * Reminder: the laser enters at row 1 going right, the detector is at the right of the last row. A mirror / sends a
+ * beam going right upward, a mirror \ sends it downward.
+ */
+
+namespace {
+
+    /// Maximum number of rows and columns of a Safe
+    const uint32_t C_MAX_LENGTH = 1000000u;
+
+    /// Maximum number of mirrors of each kind
+    const uint32_t C_MAX_MIRRORS = 200000u;
+
+    /// Position of a mirror: row and column
+    using Position = std::array<uint32_t, 2>;
+
+    /**
+     * Case of the input
+     */
+    struct Case {
+        uint32_t rows = 0u, columns = 0u;  ///< Size of the Safe
+        std::vector<Position> rightLeft, leftRight;  ///< Mirrors / and mirrors \ .
+    };
+
+    /**
+     * Options of the generator
+     */
+    struct Options {
+        std::string profile;  ///< Name of the profile
+        uint64_t seed = 1u;  ///< Seed of the pseudo-random generator
+        std::string output;  ///< Output file, standard output if empty
+        uint32_t mirrors = 0u;  ///< Number of mirrors of each kind, 0 for the default of the profile
+        uint32_t cases = 0u;  ///< Number of cases, 0 for the default of the profile
+    };
+
+    /**
+     * Draw distinct values in a range
+     *
+     * @param random: pseudo-random generator
+     * @param count: number of values, at most the size of the range
+     * @param min, max: bounds of the range, both included
+     * @return distinct values, in random order
+     */
+    std::vector<uint32_t> distinctValues(Random &random, const uint32_t count, const uint32_t min, const uint32_t max) {
+        std::vector<uint32_t> values(max - min + 1u);
+        for (uint32_t index = 0u; index < values.size(); ++index) values[index] = min + index;
+        /// Partial Fisher-Yates: only the first count values are drawn
+        for (uint32_t index = 0u; index < count; ++index)
+            std::swap(values[index], values[random.between(index, static_cast<uint32_t>(values.size() - 1u))]);
+        values.resize(count);
+        return values;
+    }
+
+    /**
+     * Beam going through every mirror: it goes right along a row, down one row, left along that row, down one row, and
+     * so on. Turning columns are drawn randomly so horizontal segments have random lengths.
+     */
+    std::vector<Case> snake(Random &random, const Options &options) {
+        const uint32_t nbMirrors = options.mirrors ? options.mirrors : C_MAX_MIRRORS;
+        Case safe{C_MAX_LENGTH, C_MAX_LENGTH, {}, {}};
+
+        /// Each pair of rows uses two (2) mirrors of each kind: \ then / on the right, / then \ on the left
+        uint32_t left = 1u;
+        for (uint32_t row = 1u; row + 2u <= C_MAX_LENGTH && safe.leftRight.size() + 2u <= nbMirrors; row += 2u) {
+            const uint32_t right = random.between(left + 1u, C_MAX_LENGTH);
+            safe.leftRight.push_back({row, right});  ///< Going right, turn down
+            safe.rightLeft.push_back({row + 1u, right});  ///< Going down, turn left
+            left = random.between(1u, right - 1u);
+            safe.rightLeft.push_back({row + 1u, left});  ///< Going left, turn down
+            safe.leftRight.push_back({row + 2u, left});  ///< Going down, turn right
+        }
+        return {safe};
+    }
+
+    /**
+     * Every mirror in the same line, the beam is sent along it by a first mirror. Used for dense rows and columns.
+     *
+     * @param alongRow: true for a dense row, false for a dense column
+     */
+    std::vector<Case> denseLine(Random &random, const Options &options, const bool alongRow) {
+        const uint32_t nbMirrors = options.mirrors ? options.mirrors : C_MAX_MIRRORS;
+        Case safe{C_MAX_LENGTH, C_MAX_LENGTH, {}, {}};
+        const uint32_t line = C_MAX_LENGTH / 2u;
+
+        /// Distinct positions along the line, mirrors \ and / alternately
+        std::vector<uint32_t> positions = distinctValues(random, 2u * nbMirrors, 2u, C_MAX_LENGTH);
+        for (uint32_t index = 0u; index < positions.size(); ++index) {
+            const Position position = alongRow ? Position{line, positions[index]} : Position{positions[index], line};
+            (index % 2u ? safe.rightLeft : safe.leftRight).push_back(position);
+        }
+
+        /// Dense row: a mirror \ of the first row, replacing one mirror \ of the row, sends the beam down to the second
+        /// mirror of the row. Dense column: the laser reaches the column in the first row.
+        if (alongRow) safe.leftRight.front() = {1u, positions[1]};
+        else safe.leftRight.front() = {1u, line};
+        return {safe};
+    }
+
+    /**
+     * The beam of the laser goes back and forth along rows while the beam from the detector goes back and forth along
+     * columns: every horizontal segment of one crosses every vertical segment of the other. There are about
+     * (nbMirrors / 2)^2 solutions.
+     *
+     * @param length: number of rows and columns of the Safe
+     */
+    Case crossings(Random &random, const uint32_t nbMirrors, const uint32_t length) {
+        Case safe{length, length, {}, {}};
+
+        /// Each row of the laser beam and each column of the detector beam uses two (2) mirrors of the same kind, the
+        /// laser beam needs one more mirror to leave the first row
+        const uint32_t nbRows = std::min((nbMirrors - 1u) / 2u, length - 2u);
+        const uint32_t nbColumns = std::min(nbMirrors - 1u - nbRows, length - 2u);
+
+        /// Laser: down the first column, then back and forth between the first and last columns, on rows of [2, length-1]
+        std::vector<uint32_t> rows = distinctValues(random, nbRows, 2u, length - 1u);
+        std::sort(rows.begin(), rows.end());
+        safe.leftRight.push_back({1u, 1u});
+        for (uint32_t index = 0u; index < nbRows; ++index) {
+            /// Going down, turn right then down with mirrors \, or turn left then down with mirrors /
+            auto &mirrors = index % 2u == 0u ? safe.leftRight : safe.rightLeft;
+            mirrors.push_back({rows[index], 1u});
+            mirrors.push_back({rows[index], length});
+        }
+
+        /// Detector: from the last row, back and forth between the first and last rows, on columns of [2, length-1]
+        std::vector<uint32_t> columns = distinctValues(random, nbColumns, 2u, length - 1u);
+        std::sort(columns.begin(), columns.end(), std::greater<>());
+        for (uint32_t index = 0u; index < nbColumns; ++index) {
+            /// Going left, turn up then left with mirrors \, or turn down then left with mirrors /
+            auto &mirrors = index % 2u == 0u ? safe.leftRight : safe.rightLeft;
+            mirrors.push_back({length, columns[index]});
+            mirrors.push_back({1u, columns[index]});
+        }
+        return safe;
+    }
+
+    /**
+     * Long horizontal segments of the laser beam crossing long vertical segments of the detector beam on a maximal Safe.
+     */
+    std::vector<Case> longCrossings(Random &random, const Options &options) {
+        return {crossings(random, options.mirrors ? options.mirrors : 40000u, C_MAX_LENGTH)};
+    }
+
+    /**
+     * Same layout as the long crossings but packed in a small Safe: most of the cells open the Safe.
+     */
+    std::vector<Case> manySolutions(Random &random, const Options &options) {
+        const uint32_t nbMirrors = options.mirrors ? options.mirrors : 4000u;
+        return {crossings(random, nbMirrors, std::max(nbMirrors + 2u, 4u))};
+    }
+
+    /**
+     * Many small cases with a few mirrors each.
+     */
+    std::vector<Case> tinyCases(Random &random, const Options &options) {
+        const uint32_t nbCases = options.cases ? options.cases : 100000u;
+        const uint32_t maxMirrors = options.mirrors ? options.mirrors : 8u;
+        std::vector<Case> cases(nbCases);
+        for (auto &safe: cases) {
+            safe.rows = random.between(1u, 8u);
+            safe.columns = random.between(1u, 8u);
+            for (auto *mirrors: {&safe.rightLeft, &safe.leftRight}) {
+                mirrors->resize(random.between(0u, maxMirrors));
+                for (auto &position: *mirrors)
+                    position = {random.between(1u, safe.rows), random.between(1u, safe.columns)};
+            }
+        }
+        return cases;
+    }
+
+    /**
+     * Maximal Safe with the maximal number of mirrors of each kind, at distinct random positions.
+     */
+    std::vector<Case> maxSize(Random &random, const Options &options) {
+        const uint32_t nbMirrors = options.mirrors ? options.mirrors : C_MAX_MIRRORS;
+        Case safe{C_MAX_LENGTH, C_MAX_LENGTH, {}, {}};
+        std::unordered_set<uint64_t> used;
+        used.reserve(2u * nbMirrors);
+        for (auto *mirrors: {&safe.rightLeft, &safe.leftRight}) {
+            while (mirrors->size() < nbMirrors) {
+                const Position position{random.between(1u, C_MAX_LENGTH), random.between(1u, C_MAX_LENGTH)};
+                if (used.insert((static_cast<uint64_t>(position[0]) << 32u) | position[1]).second)
+                    mirrors->push_back(position);
+            }
+        }
+        return {safe};
+    }
+
+    /// Profiles of the generator
+    const std::map<std::string, std::function<std::vector<Case>(Random &, const Options &)>> C_PROFILES = {
+            {"snake", snake},
+            {"dense-row", [](Random &random, const Options &options) { return denseLine(random, options, true); }},
+            {"dense-column", [](Random &random, const Options &options) { return denseLine(random, options, false); }},
+            {"long-crossings", longCrossings},
+            {"tiny-cases", tinyCases},
+            {"max-size", maxSize},
+            {"many-solutions", manySolutions},
+    };
+
+    /**
+     * Append an integer to a text
+     *
+     * @param text: text to append to
+     * @param value: integer to append
+     */
+    void append(std::string &text, const uint32_t value) {
+        char digits[16];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text.append(digits, result.ptr);
+    }
+
+    /**
+     * Write the cases in the format of input.txt
+     *
+     * @param cases: cases to write
+     * @param stream: output stream
+     */
+    void write(const std::vector<Case> &cases, std::ostream &stream) {
+        std::string text;
+        for (const auto &safe: cases) {
+            append(text, safe.rows);
+            text += ' ';
+            append(text, safe.columns);
+            text += ' ';
+            append(text, static_cast<uint32_t>(safe.rightLeft.size()));
+            text += ' ';
+            append(text, static_cast<uint32_t>(safe.leftRight.size()));
+            text += '\n';
+            for (const auto *mirrors: {&safe.rightLeft, &safe.leftRight}) {
+                for (const auto &position: *mirrors) {
+                    append(text, position[0]);
+                    text += ' ';
+                    append(text, position[1]);
+                    text += '\n';
+                }
+            }
+            /// Write by chunks to bound the memory of the text
+            if (text.size() > (1u << 20u)) {
+                stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+                text.clear();
+            }
+        }
+        stream.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    /**
+     * Parse the command line options.
+     *
+     * @param[in] argc, argv: command line
+     * @param[out] options: parsed options
+     * @return true if every option is valid
+     */
+    bool parseOptions(const int argc, char *argv[], Options &options) {
+        for (int index = 1; index + 1 < argc; index += 2) {
+            const std::string option = argv[index];
+            const char *value = argv[index + 1], *valueEnd = value + std::strlen(value);
+            if (option == "--profile") options.profile = value;
+            else if (option == "--output") options.output = value;
+            else if (option == "--seed" && std::from_chars(value, valueEnd, options.seed).ec == std::errc()) {}
+            else if (option == "--mirrors" && std::from_chars(value, valueEnd, options.mirrors).ec == std::errc() &&
+                     options.mirrors <= C_MAX_MIRRORS) {}
+            else if (option == "--cases" && std::from_chars(value, valueEnd, options.cases).ec == std::errc()) {}
+            else return false;
+        }
+        return argc % 2 == 1 && C_PROFILES.contains(options.profile);
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " --profile name [--seed N] [--output file] [--mirrors N] [--cases N]"
+                  << std::endl << "Profiles:";
+        for (const auto &[name, profile]: C_PROFILES) std::cerr << ' ' << name;
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    Random random(options.seed);
+    const std::vector<Case> cases = C_PROFILES.at(options.profile)(random, options);
+
+    /// Mirrors are written in random order, as an input would give them
+    std::vector<Case> shuffledCases = cases;
+    for (auto &safe: shuffledCases) {
+        random.shuffle(safe.rightLeft);
+        random.shuffle(safe.leftRight);
+    }
+
+    if (options.output.empty()) {
+        write(shuffledCases, std::cout);
+    } else {
+        std::ofstream file(options.output, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Cannot open file " << options.output << " !" << std::endl;
+            return 1;
+        }
+        write(shuffledCases, file);
+    }
+    return 0;
+}
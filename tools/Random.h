@@ -0,0 +1,62 @@
+/*
+ * Created by Aurelien Chagnon
+ */
+
+#ifndef SAFEANDMIRRORSPROBLEM_RANDOM_H
+#define SAFEANDMIRRORSPROBLEM_RANDOM_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Deterministic pseudo-random generator (splitmix64), independent of the standard library implementation.
+ */
+class Random {
+
+public:
+
+    explicit Random(const uint64_t seed) : mState(seed) {}
+
+    /**
+     * Draw a number
+     *
+     * @return uniform 64 bits number
+     */
+    uint64_t next() {
+        uint64_t value = (mState += 0x9E3779B97F4A7C15ull);
+        value = (value ^ (value >> 30u)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27u)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31u);
+    }
+
+    /**
+     * Draw a number in a range
+     *
+     * @param min, max: bounds of the range, both included
+     * @return number in [min, max]
+     */
+    uint32_t between(const uint32_t min, const uint32_t max) {
+        const uint64_t range = static_cast<uint64_t>(max) - min + 1u;
+        return min + static_cast<uint32_t>((next() >> 32u) * range >> 32u);
+    }
+
+    /**
+     * Shuffle a vector (Fisher-Yates)
+     *
+     * @param values: vector to shuffle
+     */
+    template<typename T>
+    void shuffle(std::vector<T> &values) {
+        for (std::size_t index = values.size(); index > 1u; --index)
+            std::swap(values[index - 1u], values[between(0u, static_cast<uint32_t>(index - 1u))]);
+    }
+
+private:
+
+    uint64_t mState;
+
+};
+
+
+#endif //SAFEANDMIRRORSPROBLEM_RANDOM_H